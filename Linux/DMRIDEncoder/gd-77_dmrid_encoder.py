@@ -0,0 +1,443 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+Copyright (C) 2020  VK3KYY / G4KYF, Roger Clark.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+
+
+Builds a compressed ("IDZ") DMR ID database image for the OpenGD77 firmware, from a CSV file
+in the RadioID.net user.csv format (RADIO_ID,CALLSIGN,FIRST_NAME,...), and optionally writes it to the radio.
+
+You need to install future if you're running python2:
+    debian like: sudo apt-get install python-future
+    or: pip install future
+
+You also need python-serial or python3-serial to write the image to the radio
+
+"""
+from __future__ import print_function
+import csv
+import getopt, sys
+import math
+import ntpath
+import platform
+import random
+import struct
+import time
+import unicodedata
+
+PROGRAM_VERSION = '0.0.1'
+
+# These must match the firmware (uiUtilities.c / uiUtilities.h)
+DMRID_MEMORY_STORAGE_START = 0x30000
+DMRID_MEMORY_STORAGE_END = 0x7B000 # The codeplug channels, contacts and TG lists start here
+DMRID_HEADER_LENGTH = 12
+DMRID_COMPRESSED_VERSION = 1
+DMRID_COMPRESSED_CHARSET = " ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-"
+DMRID_COMPRESSED_MAX_TEXT_LENGTH = 16
+DMRID_INDEX_MAX_ENTRIES = 1024
+DMRID_COMPRESSED_FLAG_CALLSIGN_INDEX = 0x01
+DMRID_CALLSIGN_MAX_LENGTH = 8
+DMRID_COMPRESSED_FLAG_BLOOM_FILTER = 0x02
+DMRID_BLOOM_FILTER_MAX_SIZE = 4096
+BLOOM_FILTER_MAX_FALSE_POSITIVES = 0.5 # A filter which passes more IDs than this isn't worth reading at boot
+MIN_BLOCK_SIZE_SHIFT = 8
+
+FLASH_SECTOR_SIZE = 4096
+MAX_TRANSFER_SIZE = 32
+
+
+###
+# Convert the text to the 6 bit character set, characters which can't be represented become spaces
+###
+def textToCodes(text, maxLength):
+    text = unicodedata.normalize('NFKD', text)
+    codes = []
+    for c in text:
+        if (unicodedata.combining(c)):
+            continue
+        pos = DMRID_COMPRESSED_CHARSET.find(c)
+        codes.append(pos if (pos >= 0) else 0)
+    # No point storing trailing spaces
+    codes = codes[:maxLength]
+    while ((len(codes) > 0) and (codes[-1] == 0)):
+        codes.pop()
+    return codes
+
+def textInCharset(text):
+    text = unicodedata.normalize('NFKD', text)
+    return all((unicodedata.combining(c) or (DMRID_COMPRESSED_CHARSET.find(c) >= 0)) for c in text)
+
+
+###
+# Encode one record: the ID as a LEB128 delta, the text length, and the 6 bit codes packed LSB first
+###
+def packCodes(codes):
+    out = bytearray()
+    bits = 0
+    numBits = 0
+    for code in codes:
+        bits |= code << numBits
+        numBits += 6
+        while (numBits >= 8):
+            out.append(bits & 0xFF)
+            bits >>= 8
+            numBits -= 8
+    if (numBits > 0):
+        out.append(bits & 0xFF)
+    return out
+
+def encodeRecord(delta, codes):
+    out = bytearray()
+    while True:
+        b = delta & 0x7F
+        delta >>= 7
+        if (delta != 0):
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            break
+
+    out.append(len(codes))
+    out += packCodes(codes)
+    return out
+
+
+###
+# Build the callsign index: entries of the callsign as 8 space padded 6 bit codes, and the 24 bit ID, sorted by callsign
+###
+def buildCallsignIndex(callsigns):
+    entries = []
+    for (dmrId, callsign) in callsigns:
+        # The firmware can't search for a character that isn't in the character set, so the callsign could never be found
+        if (not textInCharset(callsign.upper())):
+            continue
+        codes = textToCodes(callsign.upper(), DMRID_CALLSIGN_MAX_LENGTH)
+        if (len(codes) == 0):
+            continue
+        codes += [0] * (DMRID_CALLSIGN_MAX_LENGTH - len(codes))
+        entries.append((codes, dmrId))
+    entries.sort()
+
+    index = bytearray(struct.pack('<I', len(entries)))
+    for (codes, dmrId) in entries:
+        index += packCodes(codes) + struct.pack('<I', dmrId)[0:3]
+    return index
+
+
+###
+# Bloom filter, the hashes must match dmrIDBloomFilterMayContain() in the firmware
+###
+def bloomHash(h):
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+def bloomBits(dmrId, numHashes, bitsMask):
+    h1 = bloomHash(dmrId)
+    h2 = bloomHash(dmrId ^ 0x9E3779B9) | 1
+    return [((h1 + (i * h2)) & 0xFFFFFFFF) & bitsMask for i in range(0, numHashes)]
+
+def buildBloomFilter(records, size):
+    numBits = size * 8
+    numBitsShift = int(math.log(numBits, 2))
+    numHashes = min(max(int(round((float(numBits) / len(records)) * math.log(2))), 1), 16)
+    bits = bytearray(size)
+
+    for (dmrId, codes) in records:
+        for bit in bloomBits(dmrId, numHashes, numBits - 1):
+            bits[bit >> 3] |= 1 << (bit & 7)
+
+    # Measure the false positive rate with random IDs which aren't in the database
+    ids = set(dmrId for (dmrId, codes) in records)
+    tested = 0
+    falsePositives = 0
+    while (tested < 100000):
+        dmrId = random.randint(records[0][0], records[-1][0])
+        if (dmrId in ids):
+            continue
+        tested += 1
+        if (all((bits[bit >> 3] & (1 << (bit & 7))) for bit in bloomBits(dmrId, numHashes, numBits - 1))):
+            falsePositives += 1
+    print(" - Bloom filter: " + str(size) + " bytes, " + str(numHashes) + " hashes, false positive rate " + str(falsePositives * 1000 // tested / 10.0) + "%")
+
+    if (falsePositives > (tested * BLOOM_FILTER_MAX_FALSE_POSITIVES)):
+        print(" - Bloom filter left out, there are too many IDs for it to reject most unknown IDs")
+        return None
+
+    return bytearray([numBitsShift, numHashes, 0, 0]) + bits
+
+
+###
+# Pack the records into blocks of (1 << blockSizeShift) bytes
+###
+def buildBlocks(records, blockSizeShift):
+    blockSize = 1 << blockSizeShift
+    blocks = []
+    firstIds = []
+    block = None
+    count = 0
+    previousId = 0
+
+    for (dmrId, codes) in records:
+        if (block is not None):
+            encoded = encodeRecord(dmrId - previousId, codes)
+            if ((count < 255) and ((len(block) + len(encoded)) <= blockSize)):
+                block += encoded
+                count += 1
+                block[0] = count
+                previousId = dmrId
+                continue
+            blocks.append(block)
+
+        # Start a new block, its first ID is in the directory, so the first delta is 0
+        block = bytearray([1]) + encodeRecord(0, codes)
+        count = 1
+        firstIds.append(dmrId)
+        previousId = dmrId
+
+    if (block is not None):
+        blocks.append(block)
+
+    return (blocks, firstIds)
+
+
+###
+# Build the whole Flash image, using the smallest block size which keeps the directory within the firmware's RAM index
+###
+def buildImage(records, callsigns, bloomSize):
+    blockSizeShift = MIN_BLOCK_SIZE_SHIFT
+    while True:
+        (blocks, firstIds) = buildBlocks(records, blockSizeShift)
+        if (len(blocks) <= DMRID_INDEX_MAX_ENTRIES):
+            break
+        blockSizeShift += 1
+
+    blockSize = 1 << blockSizeShift
+    image = bytearray(b'IDZ')
+    image.append(DMRID_COMPRESSED_VERSION)
+    flags = DMRID_COMPRESSED_FLAG_CALLSIGN_INDEX if (callsigns is not None) else 0
+    bloomFilter = buildBloomFilter(records, bloomSize) if (bloomSize > 0) else None
+    if (bloomFilter is not None):
+        flags |= DMRID_COMPRESSED_FLAG_BLOOM_FILTER
+    image += struct.pack('<HBBI', len(blocks), blockSizeShift, flags, len(records))
+
+    for dmrId in firstIds + [records[-1][0]]:
+        image += struct.pack('<I', dmrId)[0:3]
+
+    for block in blocks:
+        image += block + bytearray([0xFF] * (blockSize - len(block)))
+
+    if (callsigns is not None):
+        image += buildCallsignIndex(callsigns)
+
+    if (bloomFilter is not None):
+        image += bloomFilter
+
+    return (image, len(blocks), blockSize)
+
+
+###
+# Read the CSV file, returns a sorted list of (id, codes), and a list of (id, callsign)
+###
+def readCSV(filename, maxLength):
+    entries = {}
+    callsigns = {}
+    with open(filename, 'r') as f:
+        for row in csv.reader(f):
+            if ((len(row) < 2) or (not row[0].strip().isdigit())):
+                continue # header line, or not an ID
+            dmrId = int(row[0])
+            if ((dmrId <= 0) or (dmrId > 0xFFFFFF)):
+                continue
+            text = row[1].strip()
+            callsigns[dmrId] = text
+            if ((len(row) > 2) and (len(row[2].strip()) > 0)):
+                text += ' ' + row[2].strip().split(' ')[0]
+            entries[dmrId] = textToCodes(text, maxLength)
+
+    return (sorted(entries.items()), list(callsigns.items()))
+
+
+###
+# Send a command to the radio and check its reply
+###
+def sendCommand(ser, sendbuffer, expectedLength):
+    ret = ser.write(sendbuffer)
+    if (ret != len(sendbuffer)):
+        print("ERROR: write() wrote " + str(ret) + " bytes")
+        return False
+
+    while (ser.in_waiting == 0):
+        time.sleep(0.01)
+
+    readbuffer = ser.read(ser.in_waiting)
+    if (sys.version_info > (3, 0)):
+        return ((len(readbuffer) == expectedLength) and (readbuffer[0] == sendbuffer[0]))
+    return ((len(readbuffer) == expectedLength) and (readbuffer[0] == chr(sendbuffer[0])))
+
+
+###
+# Write the image to the radio's Flash, a sector at a time, using the CPS protocol
+###
+def writeImage(ser, image):
+    numSectors = (len(image) + FLASH_SECTOR_SIZE - 1) // FLASH_SECTOR_SIZE
+
+    # Whole sectors are erased, so the last one must not reach the codeplug either
+    if ((DMRID_MEMORY_STORAGE_START + (numSectors * FLASH_SECTOR_SIZE)) > DMRID_MEMORY_STORAGE_END):
+        print("ERROR: the image would overwrite the codeplug")
+        return False
+
+    for sector in range(0, numSectors):
+        sectorNumber = (DMRID_MEMORY_STORAGE_START // FLASH_SECTOR_SIZE) + sector
+        if (not sendCommand(ser, bytearray([ord('W'), 1, (sectorNumber >> 16) & 0xFF, (sectorNumber >> 8) & 0xFF, sectorNumber & 0xFF]), 2)):
+            print("\nERROR: selecting sector " + str(sectorNumber))
+            return False
+
+        for offset in range(0, FLASH_SECTOR_SIZE, MAX_TRANSFER_SIZE):
+            imagePos = (sector * FLASH_SECTOR_SIZE) + offset
+            data = image[imagePos:imagePos + MAX_TRANSFER_SIZE]
+            if (len(data) == 0):
+                break
+            address = DMRID_MEMORY_STORAGE_START + imagePos
+            if (not sendCommand(ser, bytearray([ord('W'), 2]) + struct.pack('>IH', address, len(data)) + data, 2)):
+                print("\nERROR: writing address " + hex(address))
+                return False
+
+        if (not sendCommand(ser, bytearray([ord('W'), 3]), 2)):
+            print("\nERROR: writing sector " + str(sectorNumber))
+            return False
+
+        print("\r - writing: " + str(((sector + 1) * 100) // numSectors) + "%", end='')
+        sys.stdout.flush()
+
+    print("")
+    # Closing the CPS mode makes the firmware reload the DMR ID database
+    sendCommand(ser, bytearray([ord('C'), 5]), 1)
+    return True
+
+
+###
+# Display command line options
+###
+def usage():
+    print("GD-77 DMR ID Database Encoder v" + PROGRAM_VERSION)
+    print("Usage:  " + ntpath.basename(sys.argv[0]) + " [OPTION] <user.csv>")
+    print("")
+    print("    -h, --help                 : Display this help text,")
+    print("    -o, --output=<filename>    : Save the image in <filename>,")
+    print("    -c, --callsigns            : Add the callsign index, for entering Private Calls by callsign,")
+    print("    -b, --bloom=<bytes>        : Bloom filter size, a power of 2 up to " + str(DMRID_BLOOM_FILTER_MAX_SIZE) + ", 0 for none [default: " + str(DMRID_BLOOM_FILTER_MAX_SIZE) + "], left out if it would pass most unknown IDs,")
+    print("    -l, --length=<n>           : Maximum text length, 1.." + str(DMRID_COMPRESSED_MAX_TEXT_LENGTH) + " [default: " + str(DMRID_COMPRESSED_MAX_TEXT_LENGTH) + "],")
+    print("    -d, --device=<device>      : Write the image to the radio on the specified serial port.")
+    print("")
+
+
+###
+# main function
+###
+def main():
+    outputFilename = None
+    serialDev = None
+    maxLength = DMRID_COMPRESSED_MAX_TEXT_LENGTH
+    addCallsignIndex = False
+    bloomSize = DMRID_BLOOM_FILTER_MAX_SIZE
+
+    # Command line argument parsing
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], "hcb:o:l:d:", ["help", "callsigns", "bloom=", "output=", "length=", "device="])
+    except getopt.GetoptError as err:
+        print(str(err))
+        usage()
+        sys.exit(2)
+
+    for opt, arg in opts:
+        if opt in ("-h", "--help"):
+            usage()
+            sys.exit(2)
+        elif opt in ("-c", "--callsigns"):
+            addCallsignIndex = True
+        elif opt in ("-b", "--bloom"):
+            bloomSize = int(arg)
+            if ((bloomSize < 0) or (bloomSize > DMRID_BLOOM_FILTER_MAX_SIZE) or ((bloomSize & (bloomSize - 1)) != 0)):
+                print("ERROR: the Bloom filter size must be a power of 2, up to " + str(DMRID_BLOOM_FILTER_MAX_SIZE))
+                sys.exit(2)
+        elif opt in ("-o", "--output"):
+            outputFilename = arg
+        elif opt in ("-l", "--length"):
+            maxLength = min(max(int(arg), 1), DMRID_COMPRESSED_MAX_TEXT_LENGTH)
+        elif opt in ("-d", "--device"):
+            serialDev = arg
+        else:
+            assert False, "Unhandled option"
+
+    if ((len(args) != 1) or ((outputFilename is None) and (serialDev is None))):
+        usage()
+        sys.exit(2)
+
+    (records, callsigns) = readCSV(args[0], maxLength)
+    if (len(records) == 0):
+        print("ERROR: no IDs found in " + args[0])
+        sys.exit(1)
+
+    (image, numBlocks, blockSize) = buildImage(records, callsigns if addCallsignIndex else None, bloomSize)
+    print(" - " + str(len(records)) + " IDs, " + str(numBlocks) + " blocks of " + str(blockSize) + " bytes, " + str(len(image)) + " bytes (" + str(len(image) * 10 // len(records) / 10.0) + " bytes per ID)")
+
+    if (len(image) > (DMRID_MEMORY_STORAGE_END - DMRID_MEMORY_STORAGE_START)):
+        print("ERROR: the image is too large for the radio's DMR ID Flash area (" + str(DMRID_MEMORY_STORAGE_END - DMRID_MEMORY_STORAGE_START) + " bytes, below the codeplug). Use a shorter --length, or fewer IDs")
+        sys.exit(1)
+
+    if (outputFilename is not None):
+        with open(outputFilename, 'wb') as f:
+            f.write(image)
+        print(" - saved " + outputFilename)
+
+    if (serialDev is not None):
+        import serial
+
+        ser = serial.Serial()
+        ser.port = serialDev
+        ser.baudrate = 115200
+        ser.bytesize = serial.EIGHTBITS
+        ser.parity = serial.PARITY_NONE
+        ser.stopbits = serial.STOPBITS_ONE
+        ser.timeout = 1000.0
+        ser.write_timeout = 1000.0
+
+        try:
+            ser.open()
+        except serial.SerialException as err:
+            print(str(err))
+            sys.exit(1)
+
+        if (writeImage(ser, image) == True):
+            print("Done.")
+        else:
+            print("Failure")
+
+        if (ser.is_open):
+            ser.close()
+
+
+###
+# Calling main function
+###
+main()
+sys.exit(0)
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Drives calls through the real callLog.c and uiUtilities.c.
+ * While the radio is receiving, the log must never erase or program the Flash, however many calls end,
+ * and must keep the newest calls waiting in RAM. Once the radio is idle, callLogTick() writes them.
+ * After a simulated power cycle, lastheardRestoreFromCallLog() must give each station the age of its last call,
+ * counted in operating time.
+ *
+ * Usage: callLogTest [image file]
+ */
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include <HR-C6000.h>
+#include <ticks.h>
+#include <functions/callLog.h>
+#include <user_interface/uiUtilities.h>
+
+#define FIRST_ID         2340001
+#define TALKGROUP        ((TG_CALL_FLAG << 24) | 91)
+#define BUSY_CALLS       20
+#define AGE_CALLS        5
+
+static uint32_t operatingTimeAtBoot;
+
+// Operating time carried over from the previous power cycles, as fw_operatingTimeInit() restores it
+uint32_t fw_operatingSeconds(void)
+{
+	return operatingTimeAtBoot + (hostMillis / 1000);
+}
+
+// An over of a few seconds, with an LC every 60 ms
+static void hearCall(uint32_t id, uint32_t talkGroupOrPcId)
+{
+	for (int i = 0; i < 50; i++)
+	{
+		callLogCallHeard(id, talkGroupOrPcId);
+		callLogTick();
+		hostAdvanceMillis(60);
+	}
+}
+
+// Lets callLogTick() end the call in progress
+static void waitForCallEnd(void)
+{
+	for (int i = 0; i < 40; i++)
+	{
+		hostAdvanceMillis(100);
+		callLogTick();
+	}
+}
+
+static void checkLogIds(uint32_t firstId, int count)
+{
+	callLogRecord_t record;
+	int numRecords = callLogGetNumRecords();
+
+	HOST_CHECK(numRecords >= count);
+	for (int i = 0; i < count; i++)
+	{
+		HOST_CHECK(callLogReadRecord(numRecords - count + i, &record));
+		HOST_CHECK(record.id == (firstId + i));
+	}
+}
+
+static void powerCycle(uint32_t millisAtBoot)
+{
+	operatingTimeAtBoot = fw_operatingSeconds();
+	hostMillis = millisAtBoot;
+
+	HOST_CHECK(callLogInit());
+	lastheardInitList();
+	lastheardRestoreFromCallLog();
+}
+
+static void testNoWritesWhileReceiving(void)
+{
+	int writes;
+
+	slot_state = DMR_STATE_RX_1;
+	writes = mockFlashGetWriteOperations();
+
+	for (int c = 0; c < BUSY_CALLS; c++)
+	{
+		hearCall(FIRST_ID + c, TALKGROUP);
+	}
+	waitForCallEnd();
+
+	HOST_CHECK(mockFlashGetWriteOperations() == writes);
+	HOST_CHECK(callLogGetNumRecords() == CALL_LOG_RAM_TAIL_SIZE);// The oldest calls are lost, not the newest
+	checkLogIds(FIRST_ID + BUSY_CALLS - CALL_LOG_RAM_TAIL_SIZE, CALL_LOG_RAM_TAIL_SIZE);
+
+	slot_state = DMR_STATE_IDLE;
+	callLogTick();
+
+	HOST_CHECK(mockFlashGetWriteOperations() > writes);
+	writes = mockFlashGetWriteOperations();
+
+	// Nothing is left waiting, so a power cycle keeps them all
+	powerCycle(hostMillis);
+	HOST_CHECK(mockFlashGetWriteOperations() == writes);
+	HOST_CHECK(callLogGetNumRecords() == CALL_LOG_RAM_TAIL_SIZE);
+	checkLogIds(FIRST_ID + BUSY_CALLS - CALL_LOG_RAM_TAIL_SIZE, CALL_LOG_RAM_TAIL_SIZE);
+}
+
+static void testRestoredAges(void)
+{
+	static const uint32_t gapMinutes[AGE_CALLS] = { 10000, 600, 90, 5, 0 };// before each call
+	uint32_t callEnd[AGE_CALLS];
+	LinkItem_t *item;
+	uint32_t age;
+
+	for (int c = 0; c < AGE_CALLS; c++)
+	{
+		hostAdvanceMillis(gapMinutes[c] * 60 * 1000);
+		hearCall(FIRST_ID + 100 + c, TALKGROUP);
+		callEnd[c] = fw_operatingSeconds();
+		waitForCallEnd();
+	}
+	HOST_CHECK(callLogFlush());
+
+	// Switched off for a while, which doesn't count, then on for 30 s
+	hostAdvanceMillis(7 * 1000);
+	powerCycle(30 * 1000);
+
+	item = LinkHead;
+	for (int c = AGE_CALLS - 1; c >= 0; c--)
+	{
+		HOST_CHECK(item->id == (FIRST_ID + 100 + c));// Most recent first
+
+		age = fw_operatingSeconds() - callEnd[c];
+		if (age > (9999 * 60))
+		{
+			age = 9999 * 60;
+		}
+		HOST_CHECK((fw_millis() - item->time) / 1000 == age);
+		item = item->next;
+	}
+
+	// The operating time wasn't saved before the power went, so the calls seem to be in the future
+	operatingTimeAtBoot = 0;
+	lastheardInitList();
+	lastheardRestoreFromCallLog();
+	HOST_CHECK(LinkHead->time == fw_millis());
+}
+
+int main(int argc, char **argv)
+{
+	if (mockFlashOpen((argc > 1) ? argv[1] : "callLogTest.img") == false)
+	{
+		return 1;
+	}
+
+	mockFlashErase();
+	hostMillis = 5000;
+	operatingTimeAtBoot = 12345;
+	HOST_CHECK(callLogInit());
+	lastheardInitList();
+
+	testNoWritesWhileReceiving();
+	testRestoredAges();
+
+	mockFlashClose();
+
+	return hostTestResult("callLogTest");
+}
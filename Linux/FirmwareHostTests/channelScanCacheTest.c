@@ -0,0 +1,161 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Scans an 80 channel zone, in the order searchNextChannel() in uiChannelMode.c reads it, through the channel
+ * cache in the real codeplug.c, and checks the cache hits with codeplugChannelCacheStats.
+ *
+ * With plain LRU, a zone bigger than the cache misses on every hop, because each hop replaces the channel
+ * which is needed next. codeplugChannelGetDataForScan() keeps the cached channels in place, so every pass
+ * hits all but one of the cache entries, and the channels the user was browsing before the scan are still
+ * cached after it.
+ *
+ * Usage: channelScanCacheTest [image file]
+ */
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include "mockEEPROM.h"
+#include <codeplug.h>
+#include <trx.h>
+#include <user_interface/uiLocalisation.h>
+
+#define ZONE_FIRST_CHANNEL    100// Channels 100 to 128 are in the EEPROM, the rest in the Flash
+#define NUM_ZONE_CHANNELS     80
+#define NUM_BROWSED_CHANNELS  16
+#define NUM_SCAN_PASSES       10
+
+static stringsTable_t hostLanguage = { .all_channels = "All Channels" };
+const stringsTable_t *currentLanguage = &hostLanguage;
+
+static uint32_t channelFrequency(int index)
+{
+	return 14400000 + (index * 1250);
+}
+
+static void writeChannels(void)
+{
+	struct_codeplugChannel_t channel;
+
+	for (int i = ZONE_FIRST_CHANNEL; i < (ZONE_FIRST_CHANNEL + NUM_ZONE_CHANNELS); i++)
+	{
+		memset(&channel, 0, sizeof(channel));
+		snprintf(channel.name, sizeof(channel.name), "Channel %d", i);
+		channel.rxFreq = channel.txFreq = channelFrequency(i);
+		channel.txTone = channel.rxTone = CODEPLUG_CSS_NONE;
+		channel.chMode = RADIO_MODE_ANALOG;
+		HOST_CHECK(codeplugChannelSaveDataForIndex(i, &channel));
+	}
+	SPI_Flash_flushCache();
+}
+
+static void checkChannel(int index, const struct_codeplugChannel_t *channel)
+{
+	char name[16];
+
+	snprintf(name, sizeof(name), "Channel %d", index);
+	HOST_CHECK((strncmp(channel->name, name, sizeof(channel->name)) == 0) && (channel->rxFreq == channelFrequency(index)));
+}
+
+// The user steps through the first channels of the zone
+static uint32_t browse(void)
+{
+	struct_codeplugChannel_t channel;
+	uint32_t hits = codeplugChannelCacheStats.hits;
+
+	for (int i = 0; i < NUM_BROWSED_CHANNELS; i++)
+	{
+		codeplugChannelGetDataForIndex(ZONE_FIRST_CHANNEL + i, &channel);
+		checkChannel(ZONE_FIRST_CHANNEL + i, &channel);
+	}
+
+	return codeplugChannelCacheStats.hits - hits;
+}
+
+// Returns the hits on the last pass
+static uint32_t scan(void (*getChannel)(int index, struct_codeplugChannel_t *channelBuf))
+{
+	struct_codeplugChannel_t channel;
+	uint32_t hits = 0;
+
+	for (int pass = 0; pass < NUM_SCAN_PASSES; pass++)
+	{
+		hits = codeplugChannelCacheStats.hits;
+		for (int i = 0; i < NUM_ZONE_CHANNELS; i++)
+		{
+			getChannel(ZONE_FIRST_CHANNEL + i, &channel);
+			checkChannel(ZONE_FIRST_CHANNEL + i, &channel);
+		}
+		hits = codeplugChannelCacheStats.hits - hits;
+	}
+
+	return hits;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t lruHits;
+	uint32_t scanHits;
+	uint32_t browseHits;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "channelScanCacheTest.img") == false)
+	{
+		return 1;
+	}
+	mockFlashErase();
+	writeChannels();
+
+	// The scan as it was, with every read updating the LRU order
+	codeplugChannelCacheInvalidate();
+	browse();
+	lruHits = scan(codeplugChannelGetDataForIndex);
+	HOST_CHECK(lruHits == 0);
+
+	codeplugChannelCacheInvalidate();
+	browse();
+	memset(&codeplugChannelCacheStats, 0, sizeof(codeplugChannelCacheStats));
+	scanHits = scan(codeplugChannelGetDataForScan);
+	HOST_CHECK(scanHits == (CODEPLUG_CHANNEL_CACHE_SIZE - 1));
+	HOST_CHECK(codeplugChannelCacheStats.hits >= (NUM_SCAN_PASSES - 1) * (CODEPLUG_CHANNEL_CACHE_SIZE - 1));
+
+	// The channels browsed before the scan are still cached
+	browseHits = browse();
+	HOST_CHECK(browseHits >= (NUM_BROWSED_CHANNELS - 1));
+
+	printf("%d channel zone, %d entry cache, hits per pass: %u with LRU, %u for scans. %u of %d browsed channels still cached after the scan\n",
+			NUM_ZONE_CHANNELS, CODEPLUG_CHANNEL_CACHE_SIZE, lruHits, scanHits, browseHits, NUM_BROWSED_CHANNELS);
+
+	// A zone which fits in the cache is hit on every hop after the first pass
+	codeplugChannelCacheInvalidate();
+	memset(&codeplugChannelCacheStats, 0, sizeof(codeplugChannelCacheStats));
+	for (int pass = 0; pass < NUM_SCAN_PASSES; pass++)
+	{
+		struct_codeplugChannel_t channel;
+
+		for (int i = 0; i < NUM_BROWSED_CHANNELS; i++)
+		{
+			codeplugChannelGetDataForScan(ZONE_FIRST_CHANNEL + i, &channel);
+			checkChannel(ZONE_FIRST_CHANNEL + i, &channel);
+		}
+	}
+	HOST_CHECK(codeplugChannelCacheStats.misses == NUM_BROWSED_CHANNELS);
+
+	mockFlashClose();
+
+	return hostTestResult("channelScanCacheTest");
+}
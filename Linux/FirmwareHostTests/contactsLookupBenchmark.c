@@ -0,0 +1,238 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Lookups of contacts by TG / PC number with a full codeplug of 1024 contacts, through the real codeplug.c hash,
+ * compared with the linear scan of the contacts cache that it replaced. Every answer is checked against the scan,
+ * before and after contacts are edited, added and deleted.
+ *
+ * Usage: contactsLookupBenchmark [image file]
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include "mockEEPROM.h"
+#include <codeplug.h>
+#include <user_interface/uiLocalisation.h>
+
+#define CONTACTS_ADDRESS   0x87620
+#define CONTACTS_MAX       1024
+#define CONTACT_DATA_SIZE  24
+#define NUM_LOOKUPS        2000000
+#define NUM_EDITS          64
+
+static stringsTable_t hostLanguage = { .all_channels = "All Channels" };
+const stringsTable_t *currentLanguage = &hostLanguage;
+
+// The old cache and its linear scan, from codeplug.c before the hash
+typedef struct
+{
+	uint32_t tgOrPCNum;
+	uint16_t index;
+} oldContactCache_t;
+
+static oldContactCache_t oldCache[CONTACTS_MAX];
+static int oldNumContacts;
+
+static int oldContactIndexByTGorPC(int tgorpc, int callType)
+{
+	for (int i = 0; i < oldNumContacts; i++)
+	{
+		if (((oldCache[i].tgOrPCNum & 0xFFFFFF) == tgorpc) && ((oldCache[i].tgOrPCNum >> 24) == callType))
+		{
+			return oldCache[i].index;
+		}
+	}
+	return 0;
+}
+
+static bool oldContactsContainsPC(uint32_t pc)
+{
+	pc = pc & 0x00FFFFFF;
+	pc = pc | (CONTACT_CALLTYPE_PC << 24);
+
+	for (int i = 0; i < oldNumContacts; i++)
+	{
+		if (oldCache[i].tgOrPCNum == pc)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void oldCacheLoad(const uint8_t *image)
+{
+	oldNumContacts = 0;
+	for (int i = 0; i < CONTACTS_MAX; i++)
+	{
+		struct_codeplugContact_t contact;
+
+		memcpy(&contact, &image[CONTACTS_ADDRESS + (i * CONTACT_DATA_SIZE)], CONTACT_DATA_SIZE);
+		if (contact.name[0] != 0xFF)
+		{
+			oldCache[oldNumContacts].tgOrPCNum = bcd2int(byteSwap32(contact.tgNumber)) | (contact.callType << 24);
+			oldCache[oldNumContacts].index = i + 1;
+			oldNumContacts++;
+		}
+	}
+}
+
+// As codeplugContactSaveDataForIndex() takes it, with the number in binary
+static void setContact(struct_codeplugContact_t *contact, uint32_t number, int callType)
+{
+	memset(contact, 0xFF, sizeof(struct_codeplugContact_t));
+	snprintf(contact->name, sizeof(contact->name), "%s %u", ((callType == CONTACT_CALLTYPE_PC) ? "PC" : "TG"), number);
+	contact->tgNumber = number;
+	contact->callType = callType;
+}
+
+static uint32_t randomNumber(int callType)
+{
+	return (callType == CONTACT_CALLTYPE_PC) ? (1000000 + (rand() % 7000000)) : (1 + (rand() % 99999));
+}
+
+// 1 in 4 contacts is a private call, the rest are talkgroups. A few talkgroups appear twice, as they do in real codeplugs.
+static void fillContacts(uint8_t *image)
+{
+	struct_codeplugContact_t contact;
+
+	for (int i = 0; i < CONTACTS_MAX; i++)
+	{
+		int callType = ((i % 4) == 3) ? CONTACT_CALLTYPE_PC : CONTACT_CALLTYPE_TG;
+		uint32_t number = ((i % 100) == 99) ? (1 + (i % 50)) : randomNumber(callType);
+
+		setContact(&contact, number, callType);
+		contact.tgNumber = byteSwap32(int2bcd(number));// BCD in the codeplug
+		memcpy(&image[CONTACTS_ADDRESS + (i * CONTACT_DATA_SIZE)], &contact, CONTACT_DATA_SIZE);
+	}
+}
+
+// Half of the lookups are for contacts in the codeplug, the rest are for stations which are not
+static void makeQueries(uint32_t *queries, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if ((rand() % 2) == 0)
+		{
+			queries[i] = oldCache[rand() % oldNumContacts].tgOrPCNum;
+		}
+		else
+		{
+			int callType = ((rand() % 2) == 0) ? CONTACT_CALLTYPE_PC : CONTACT_CALLTYPE_TG;
+
+			queries[i] = randomNumber(callType) | (callType << 24);
+		}
+	}
+}
+
+static void checkAgainstOldScan(const uint32_t *queries, int count)
+{
+	struct_codeplugContact_t contact;
+
+	for (int i = 0; i < count; i++)
+	{
+		uint32_t number = queries[i] & 0xFFFFFF;
+		int callType = queries[i] >> 24;
+		int index = codeplugContactIndexByTGorPC(number, callType, &contact);
+
+		HOST_CHECK(index == oldContactIndexByTGorPC(number, callType));
+		HOST_CHECK(codeplugContactsContainsPC(number) == oldContactsContainsPC(number));
+		if (index != 0)
+		{
+			HOST_CHECK((contact.tgNumber == number) && (contact.callType == callType));
+		}
+	}
+}
+
+static void editContacts(void)
+{
+	struct_codeplugContact_t contact;
+
+	for (int i = 0; i < NUM_EDITS; i++)
+	{
+		int index = 1 + (rand() % CONTACTS_MAX);
+
+		switch (i % 3)
+		{
+			case 0:// Delete
+				memset(&contact, 0xFF, sizeof(contact));
+				break;
+			case 1:// Change the number
+				setContact(&contact, randomNumber(CONTACT_CALLTYPE_PC), CONTACT_CALLTYPE_PC);
+				break;
+			default:// Add one, or change a talkgroup
+				setContact(&contact, randomNumber(CONTACT_CALLTYPE_TG), CONTACT_CALLTYPE_TG);
+				break;
+		}
+		HOST_CHECK(codeplugContactSaveDataForIndex(index, &contact));
+	}
+
+	HOST_CHECK(SPI_Flash_flushCache());
+}
+
+int main(int argc, char **argv)
+{
+	static uint32_t queries[NUM_LOOKUPS];
+	volatile int found = 0;
+	double start, oldTime, hashTime;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "contactsLookupBenchmark.img") == false)
+	{
+		return 1;
+	}
+
+	srand(10);
+	mockFlashErase();
+	fillContacts(mockFlashGetImage());
+	oldCacheLoad(mockFlashGetImage());
+	codeplugInitContactsCache();
+	makeQueries(queries, NUM_LOOKUPS);
+
+	checkAgainstOldScan(queries, 20000);
+
+	start = hostSeconds();
+	for (int i = 0; i < NUM_LOOKUPS; i++)
+	{
+		found += oldContactsContainsPC(queries[i]);
+	}
+	oldTime = hostSeconds() - start;
+
+	start = hostSeconds();
+	for (int i = 0; i < NUM_LOOKUPS; i++)
+	{
+		found += codeplugContactsContainsPC(queries[i]);
+	}
+	hashTime = hostSeconds() - start;
+
+	printf("%d contacts, %d lookups, half of them for numbers not in the codeplug\n", oldNumContacts, NUM_LOOKUPS);
+	printf("%-24s %10.1f ns per lookup\n", "Linear scan (old)", (oldTime * 1e9) / NUM_LOOKUPS);
+	printf("%-24s %10.1f ns per lookup   x%.0f\n", "Hash", (hashTime * 1e9) / NUM_LOOKUPS, oldTime / hashTime);
+
+	// The hash must follow the cache through edits, inserts and deletes
+	editContacts();
+	oldCacheLoad(mockFlashGetImage());
+	makeQueries(queries, 20000);
+	checkAgainstOldScan(queries, 20000);
+	printf("%d contacts after %d edits, lookups still match the linear scan\n", oldNumContacts, NUM_EDITS);
+
+	mockFlashClose();
+
+	return hostTestResult("contactsLookupBenchmark");
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Builds "IDZ" compressed DMR ID databases with Linux/DMRIDEncoder, loads them into the Flash image and looks
+ * every ID up with the real uiUtilities.c. The database must stay below the codeplug at 0x7B000:
+ * the encoder must refuse a database which doesn't fit, and the firmware must ignore any part of a header
+ * which points past it, rather than reading the codeplug as DMR IDs.
+ *
+ * Usage: dmrIDCompressedTest [image file]
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include <user_interface/uiUtilities.h>
+
+#define ENCODER               "python3 ../DMRIDEncoder/gd-77_dmrid_encoder.py"
+#define CSV_FILE              "dmrIDCompressedTest.csv"
+#define IDZ_FILE              "dmrIDCompressedTest.idz"
+#define DMRID_ADDRESS         0x30000
+#define DMRID_AREA_END        0x7B000// the codeplug starts here
+#define NUM_IDS               3000
+#define NUM_OVERSIZE_IDS      40000
+#define UNSEARCHABLE_ID       999999// Its callsign has a character outside the character set
+
+static uint32_t ids[NUM_IDS];
+
+static void makeCallsign(int i, char *callsign)
+{
+	sprintf(callsign, "VK%d%c%c%c", i % 10, 'A' + ((i / 10) % 26), 'A' + ((i / 260) % 26), 'A' + ((i / 6760) % 26));
+}
+
+// The text the encoder stores is the callsign and the first name
+static void makeText(int i, char *text)
+{
+	char callsign[16];
+
+	makeCallsign(i, callsign);
+	sprintf(text, "%s Name%d", callsign, i);
+}
+
+static bool writeCSV(int numIds, bool longNames)
+{
+	FILE *f = fopen(CSV_FILE, "w");
+	char callsign[16];
+
+	if (f == NULL)
+	{
+		return false;
+	}
+
+	fprintf(f, "RADIO_ID,CALLSIGN,FIRST_NAME\n");
+	fprintf(f, "%u,VK#ABC,Name\n", UNSEARCHABLE_ID);
+	for (int i = 0; i < numIds; i++)
+	{
+		makeCallsign(i, callsign);
+		fprintf(f, "%u,%s,%s%d\n", 1000000 + (i * 37), callsign, (longNames ? "Abcdefghij" : "Name"), i);
+	}
+	fclose(f);
+
+	return true;
+}
+
+// Returns the size of the image, or -1 if the encoder failed
+static int encode(int numIds, bool longNames, uint8_t *flashImage)
+{
+	FILE *f;
+	long size;
+
+	remove(IDZ_FILE);
+	if ((writeCSV(numIds, longNames) == false) || (system(ENCODER " -c -o " IDZ_FILE " " CSV_FILE " > /dev/null") != 0))
+	{
+		return -1;
+	}
+
+	f = fopen(IDZ_FILE, "rb");
+	if (f == NULL)
+	{
+		return -1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	HOST_CHECK((DMRID_ADDRESS + size) <= DMRID_AREA_END);
+	memset(&flashImage[DMRID_ADDRESS], 0xFF, DMRID_AREA_END - DMRID_ADDRESS);
+	if (fread(&flashImage[DMRID_ADDRESS], 1, size, f) != size)
+	{
+		size = -1;
+	}
+	fclose(f);
+
+	return size;
+}
+
+static int countFound(void)
+{
+	dmrIdDataStruct_t record;
+	char text[32];
+	int found = 0;
+
+	for (int i = 0; i < NUM_IDS; i++)
+	{
+		memset(&record, 0, sizeof(record));
+		if (dmrIDLookup(ids[i], &record))
+		{
+			makeText(i, text);
+			HOST_CHECK(strcmp(record.text, text) == 0);
+			found++;
+		}
+		HOST_CHECK(dmrIDLookup(ids[i] + 1, &record) == false);
+	}
+
+	return found;
+}
+
+int main(int argc, char **argv)
+{
+	uint8_t *image;
+	uint8_t header[12];
+	uint8_t *callsignIndex;
+	uint32_t numBlocks;
+	char callsign[16];
+	uint32_t id;
+	int size;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "dmrIDCompressedTest.img") == false)
+	{
+		return 1;
+	}
+	mockFlashErase();
+	image = mockFlashGetImage();
+
+	// A database which would reach the codeplug is refused, and no image is written
+	HOST_CHECK(encode(NUM_OVERSIZE_IDS, true, image) < 0);
+	HOST_CHECK(access(IDZ_FILE, F_OK) != 0);
+
+	size = encode(NUM_IDS, false, image);
+	HOST_CHECK(size > 0);
+	for (int i = 0; i < NUM_IDS; i++)
+	{
+		ids[i] = 1000000 + (i * 37);
+	}
+	memcpy(header, &image[DMRID_ADDRESS], sizeof(header));
+
+	dmrIDCacheInit();
+	HOST_CHECK(countFound() == NUM_IDS);
+	HOST_CHECK(dmrIDCallsignIndexAvailable());
+	makeCallsign(1234, callsign);
+	HOST_CHECK(dmrIDCallsignGetEntry(dmrIDCallsignFind(callsign), callsign, callsign, &id) && (id == ids[1234]));
+
+	// A prefix with a character outside the character set matches nothing, it used to be read as a space,
+	// which is also the padding at the end of a shorter callsign
+	strcat(callsign, "@");
+	HOST_CHECK(dmrIDCallsignFind(callsign) == -1);
+	HOST_CHECK(dmrIDCallsignGetEntry(0, "@", callsign, &id) == false);
+	HOST_CHECK(dmrIDCallsignFind("VK#") == -1);
+
+	// Blocks which run past the end of the area
+	image[DMRID_ADDRESS + 6] = 16;
+	dmrIDCacheInit();
+	HOST_CHECK(countFound() == 0);
+	HOST_CHECK(dmrIDCallsignIndexAvailable() == false);
+	memcpy(&image[DMRID_ADDRESS], header, sizeof(header));
+
+	// The encoder leaves the callsign which can't be searched for out of the index
+	numBlocks = header[4] | (header[5] << 8);
+	callsignIndex = &image[DMRID_ADDRESS + sizeof(header) + ((numBlocks + 1) * 3) + (numBlocks << header[6])];
+	HOST_CHECK((callsignIndex[0] | (callsignIndex[1] << 8) | (callsignIndex[2] << 16) | (callsignIndex[3] << 24)) == NUM_IDS);
+
+	// A callsign index which runs past the end of the area is not used, but the IDs still are
+	image[DMRID_ADDRESS + 11] = 0x01;// 16M IDs, and as many callsigns
+	memcpy(callsignIndex, "\x00\x00\x00\x01", 4);
+	dmrIDCacheInit();
+	HOST_CHECK(countFound() == NUM_IDS);
+	HOST_CHECK(dmrIDCallsignIndexAvailable() == false);
+
+	printf("%d IDs in a %d byte image, %d byte area below the codeplug\n", NUM_IDS, size, DMRID_AREA_END - DMRID_ADDRESS);
+
+	remove(CSV_FILE);
+	remove(IDZ_FILE);
+	mockFlashClose();
+
+	return hostTestResult("dmrIDCompressedTest");
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Builds "ID-" format DMR ID databases in the Flash image and counts the Flash probes made by dmrIDLookup()
+ * in the real uiUtilities.c, against the plain binary search it used before interpolation search was added.
+ * Every lookup is checked: IDs in the database must be found with the right text, and other IDs must not be.
+ *
+ * Two kinds of database are built: IDs spread evenly over the whole range, and IDs handed out in runs from
+ * the start of a few country ranges, as the real DMR ID registry does, which is the hard case for interpolation.
+ *
+ * Usage: dmrIDLookupBenchmark [image file]
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include <user_interface/uiUtilities.h>
+
+#define DMRID_ADDRESS         0x30000
+#define DMRID_HEADER_LENGTH   12
+#define DMRID_AREA_END        0x7B000// the codeplug starts here
+#define CONTACT_LENGTH        12// 4 byte BCD ID and 8 characters
+#define MAX_IDS               25000// as many as fit below the codeplug
+#define NUM_LOOKUPS           20000
+
+static uint32_t ids[MAX_IDS];
+static int numIds;
+static uint32_t probeReads;
+
+// Every probe reads the 4 byte ID of a record, the text is read separately
+bool __real_SPI_Flash_streamRead(spiFlashStream_t *stream, uint8_t *dataBuf, int size);
+
+bool __wrap_SPI_Flash_streamRead(spiFlashStream_t *stream, uint8_t *dataBuf, int size)
+{
+	if (size == 4)
+	{
+		probeReads++;
+	}
+
+	return __real_SPI_Flash_streamRead(stream, dataBuf, size);
+}
+
+static int compareIds(const void *a, const void *b)
+{
+	uint32_t idA = *(const uint32_t *)a;
+	uint32_t idB = *(const uint32_t *)b;
+
+	return (idA > idB) - (idA < idB);
+}
+
+static void sortAndRemoveDuplicates(void)
+{
+	int out = 0;
+
+	qsort(ids, numIds, sizeof(uint32_t), compareIds);
+	for (int i = 0; i < numIds; i++)
+	{
+		if ((out == 0) || (ids[i] != ids[out - 1]))
+		{
+			ids[out++] = ids[i];
+		}
+	}
+	numIds = out;
+}
+
+static void makeEvenIds(int count)
+{
+	for (numIds = 0; numIds < count; numIds++)
+	{
+		ids[numIds] = 1000000 + (rand() % 7000000);
+	}
+	sortAndRemoveDuplicates();
+}
+
+// IDs are given out in order from the start of each country's range, so they are dense there and absent elsewhere
+static void makeClusteredIds(int count)
+{
+	static const struct { uint32_t start; int share; } countries[] =
+	{
+		{ 3100000, 30 }, { 2340000, 12 }, { 2620000, 12 }, { 5050000, 6 }, { 2080000, 6 }, { 2220000, 6 },
+		{ 3020000, 5 }, { 2040000, 4 }, { 2140000, 4 }, { 4400000, 3 }, { 7240000, 3 }, { 4600000, 3 },
+		{ 2500000, 2 }, { 1023000, 2 }, { 6550000, 2 }
+	};
+	int numCountries = sizeof(countries) / sizeof(countries[0]);
+
+	numIds = 0;
+	for (int c = 0; c < numCountries; c++)
+	{
+		uint32_t id = countries[c].start;
+
+		for (int i = 0; (i < ((count * countries[c].share) / 100)) && (numIds < MAX_IDS); i++)
+		{
+			id += 1 + (((rand() % 4) == 0) ? (rand() % 20) : 0);// Mostly consecutive, some gaps
+			ids[numIds++] = id;
+		}
+	}
+	sortAndRemoveDuplicates();
+}
+
+static void recordText(uint32_t id, char *text)
+{
+	char buf[16];
+
+	snprintf(buf, sizeof(buf), "T%07u", id);
+	memcpy(text, buf, CONTACT_LENGTH - 4);
+}
+
+static void writeDatabase(uint8_t *image)
+{
+	uint8_t *p = &image[DMRID_ADDRESS];
+
+	memset(p, 0xFF, DMRID_AREA_END - DMRID_ADDRESS);
+	memset(p, 0, DMRID_HEADER_LENGTH);
+	memcpy(p, "ID-", 3);
+	p[3] = CONTACT_LENGTH + 0x4A;
+	p[8] = numIds & 0xFF;
+	p[9] = (numIds >> 8) & 0xFF;
+	p[10] = (numIds >> 16) & 0xFF;
+	p += DMRID_HEADER_LENGTH;
+
+	HOST_CHECK((DMRID_ADDRESS + DMRID_HEADER_LENGTH + (numIds * CONTACT_LENGTH)) <= DMRID_AREA_END);
+	for (int i = 0; i < numIds; i++)
+	{
+		uint32_t bcd = int2bcd(ids[i]);
+
+		memcpy(p, &bcd, 4);
+		recordText(ids[i], (char *)p + 4);
+		p += CONTACT_LENGTH;
+	}
+}
+
+static bool isInDatabase(uint32_t id)
+{
+	return (bsearch(&id, ids, numIds, sizeof(uint32_t), compareIds) != NULL);
+}
+
+// The search dmrIDLookupInFlash() made before interpolation search, counting its probes
+static int binarySearchProbes(uint32_t id)
+{
+	int stride = (numIds + (DMRID_INDEX_MAX_ENTRIES - 1)) / DMRID_INDEX_MAX_ENTRIES;
+	int indexEntry = 0;
+	int startPos;
+	int endPos;
+	int probes = 0;
+
+	// The RAM index holds every stride'th ID
+	while (((indexEntry + 1) * stride < numIds) && (ids[(indexEntry + 1) * stride] <= id))
+	{
+		indexEntry++;
+	}
+
+	startPos = indexEntry * stride;
+	if (ids[startPos] == id)
+	{
+		return 0;
+	}
+
+	endPos = startPos + stride - 1;
+	if (endPos > (numIds - 1))
+	{
+		endPos = numIds - 1;
+	}
+	startPos++;
+
+	while (startPos <= endPos)
+	{
+		int curPos = (startPos + endPos) >> 1;
+
+		probes++;
+		if (ids[curPos] < id)
+		{
+			startPos = curPos + 1;
+		}
+		else if (ids[curPos] > id)
+		{
+			endPos = curPos - 1;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return probes;
+}
+
+typedef struct
+{
+	double probes;
+	double oldProbes;
+	double busTimeUs;
+} lookupResult_t;
+
+static lookupResult_t runLookups(bool hits)
+{
+	lookupResult_t result = { 0, 0, 0 };
+	dmrIdDataStruct_t record;
+
+	probeReads = 0;
+	mockFlashResetStats();
+
+	for (int i = 0; i < NUM_LOOKUPS; i++)
+	{
+		uint32_t id;
+		char text[CONTACT_LENGTH - 4];
+
+		if (hits)
+		{
+			id = ids[rand() % numIds];
+		}
+		else
+		{
+			do
+			{
+				id = ids[0] + (rand() % (ids[numIds - 1] - ids[0]));
+			} while (isInDatabase(id));
+		}
+
+		dmrIDLookupCacheInvalidate();// Measure the Flash search, not the cache in front of it
+		HOST_CHECK(dmrIDLookup(id, &record) == hits);
+		if (hits)
+		{
+			recordText(id, text);
+			HOST_CHECK(memcmp(record.text, text, sizeof(text)) == 0);
+		}
+
+		result.oldProbes += binarySearchProbes(id);
+	}
+
+	result.probes = (double)probeReads / NUM_LOOKUPS;
+	result.oldProbes /= NUM_LOOKUPS;
+	result.busTimeUs = (mockFlashStats.busTimeNs / 1000.0) / NUM_LOOKUPS;
+
+	return result;
+}
+
+typedef struct
+{
+	const char *name;
+	void (*make)(int count);
+	int count;
+} database_t;
+
+static const database_t databases[] =
+{
+	{ "Even",      makeEvenIds,      1000 },
+	{ "Even",      makeEvenIds,      10000 },
+	{ "Even",      makeEvenIds,      25000 },
+	{ "Clustered", makeClusteredIds, 10000 },
+	{ "Clustered", makeClusteredIds, 25000 }
+};
+
+int main(int argc, char **argv)
+{
+	if (mockFlashOpen((argc > 1) ? argv[1] : "dmrIDLookupBenchmark.img") == false)
+	{
+		return 1;
+	}
+
+	srand(12);
+	mockFlashErase();
+
+	printf("Average Flash probes per lookup, %d lookups each, plain binary search in brackets\n\n", NUM_LOOKUPS);
+	printf("%-10s %7s %6s %20s %20s %14s\n", "IDs", "Count", "Stride", "Found", "Not found", "Bus us/lookup");
+
+	for (int d = 0; d < (sizeof(databases) / sizeof(databases[0])); d++)
+	{
+		lookupResult_t found;
+		lookupResult_t notFound;
+
+		databases[d].make(databases[d].count);
+		writeDatabase(mockFlashGetImage());
+		dmrIDCacheInit();
+
+		found = runLookups(true);
+		notFound = runLookups(false);
+
+		printf("%-10s %7d %6d %9.2f (%6.2f) %9.2f (%6.2f) %14.1f\n", databases[d].name, numIds,
+				(numIds + (DMRID_INDEX_MAX_ENTRIES - 1)) / DMRID_INDEX_MAX_ENTRIES,
+				found.probes, found.oldProbes, notFound.probes, notFound.oldProbes, found.busTimeUs);
+
+		// Interpolation never costs more than a few probes over binary search, even on clustered IDs
+		HOST_CHECK(found.probes <= (found.oldProbes + DMRID_INTERPOLATION_PROBES));
+		HOST_CHECK(notFound.probes <= (notFound.oldProbes + DMRID_INTERPOLATION_PROBES));
+	}
+
+	mockFlashClose();
+
+	return hostTestResult("dmrIDLookupBenchmark");
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Runs the write queue in the real EEPROM.c against a simulated 24LC512 on the I2C bus, which doesn't ACK its
+ * address during its 5mS write cycle, and which can be made to fail the data part of the next page writes.
+ *
+ * A page whose write fails must stay queued and be written by a later EEPROM_Tick(), and a page which keeps
+ * failing must be dropped after EEPROM_WRITE_MAX_RETRIES attempts, so it can't block the queue. Both are
+ * checked with eepromStats. Finally, random writes are run with one page write in 100 failing, and the
+ * EEPROM must end up with exactly the data which was written.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include <EEPROM.h>
+
+#define SIM_EEPROM_SIZE        (64 * 1024)
+#define SIM_PAGE_SIZE          128
+#define SIM_WRITE_CYCLE_MS     5
+#define NUM_RANDOM_WRITES      5000
+#define EEPROM_WRITE_MAX_RETRIES 3// as in EEPROM.c
+
+volatile int isI2cInUse;
+
+static uint8_t simMemory[SIM_EEPROM_SIZE];
+static uint8_t expectedMemory[SIM_EEPROM_SIZE];
+static int simAddress;
+static uint32_t simBusyUntil;
+static int simFailNextWrites;// data writes to fail
+static int simFailOneIn;// or fail one in this many at random, 0 = never
+static uint32_t simPageWrites;
+
+void vPortEnterCritical(void)
+{
+}
+
+void vPortExitCritical(void)
+{
+}
+
+status_t I2C_MasterTransferBlocking(I2C_Type *base, i2c_master_transfer_t *xfer)
+{
+	if ((xfer->flags & kI2C_TransferNoStartFlag) == 0)
+	{
+		// Start, or repeated start, with the device address
+		if ((int32_t)(hostMillis - simBusyUntil) < 0)
+		{
+			return kStatus_I2C_Addr_Nak;
+		}
+
+		if (xfer->direction == kI2C_Read)
+		{
+			for (int i = 0; i < xfer->dataSize; i++)
+			{
+				xfer->data[i] = simMemory[(simAddress + i) % SIM_EEPROM_SIZE];
+			}
+		}
+		else if (xfer->dataSize == 2)
+		{
+			simAddress = (xfer->data[0] << 8) | xfer->data[1];
+		}
+
+		return kStatus_Success;
+	}
+
+	// Page write data, which wraps within the page
+	bool fail = (simFailNextWrites > 0) || ((simFailOneIn > 0) && ((rand() % simFailOneIn) == 0));
+	int size = xfer->dataSize;
+
+	if (fail)
+	{
+		if (simFailNextWrites > 0)
+		{
+			simFailNextWrites--;
+		}
+		size /= 2;// The transfer stops part way through, and the EEPROM writes what it has received
+	}
+
+	for (int i = 0; i < size; i++)
+	{
+		int page = simAddress & ~(SIM_PAGE_SIZE - 1);
+
+		simMemory[page + ((simAddress + i) & (SIM_PAGE_SIZE - 1))] = xfer->data[i];
+	}
+	simBusyUntil = hostMillis + SIM_WRITE_CYCLE_MS;
+	simPageWrites++;
+
+	return (fail ? kStatus_I2C_Nak : kStatus_Success);
+}
+
+static void fillPage(int address, uint8_t value)
+{
+	uint8_t buf[SIM_PAGE_SIZE];
+
+	memset(buf, value, sizeof(buf));
+	memcpy(&expectedMemory[address], buf, sizeof(buf));
+	HOST_CHECK(EEPROM_Write(address, buf, sizeof(buf)));
+}
+
+// Runs the main loop until the queue is empty
+static int tickUntilWritten(void)
+{
+	int ticks = 0;
+
+	while (EEPROM_IsWritePending() && (ticks < 10000))
+	{
+		hostAdvanceMillis(1);
+		EEPROM_Tick();
+		ticks++;
+	}
+
+	HOST_CHECK(EEPROM_IsWritePending() == false);
+
+	return ticks;
+}
+
+static void testTransientFailure(void)
+{
+	memset(&eepromStats, 0, sizeof(eepromStats));
+	fillPage(0x1000, 0x11);
+	fillPage(0x1080, 0x22);
+	simFailNextWrites = EEPROM_WRITE_MAX_RETRIES - 1;
+	tickUntilWritten();
+
+	printf("Transient failure: %u write failures, %u pages dropped\n", eepromStats.writeFailures, eepromStats.pagesDropped);
+	HOST_CHECK(eepromStats.writeFailures == (EEPROM_WRITE_MAX_RETRIES - 1));
+	HOST_CHECK(eepromStats.pagesDropped == 0);
+	HOST_CHECK(memcmp(&simMemory[0x1000], &expectedMemory[0x1000], 2 * SIM_PAGE_SIZE) == 0);
+}
+
+static void testPermanentFailure(void)
+{
+	uint8_t buf[SIM_PAGE_SIZE];
+
+	memset(&eepromStats, 0, sizeof(eepromStats));
+	fillPage(0x2000, 0x33);
+	simFailNextWrites = 1000;
+	tickUntilWritten();
+	simFailNextWrites = 0;
+
+	printf("Permanent failure: %u write failures, %u pages dropped\n", eepromStats.writeFailures, eepromStats.pagesDropped);
+	HOST_CHECK(eepromStats.writeFailures == EEPROM_WRITE_MAX_RETRIES);
+	HOST_CHECK(eepromStats.pagesDropped == 1);
+
+	// The queue must still work
+	memcpy(&expectedMemory[0x2000], &simMemory[0x2000], SIM_PAGE_SIZE);
+	fillPage(0x2080, 0x44);
+	tickUntilWritten();
+	HOST_CHECK(memcmp(&simMemory[0x2080], &expectedMemory[0x2080], SIM_PAGE_SIZE) == 0);
+	HOST_CHECK(EEPROM_Read(0x2080, buf, sizeof(buf)) && (memcmp(buf, &expectedMemory[0x2080], SIM_PAGE_SIZE) == 0));
+}
+
+static void testRandomFailures(void)
+{
+	uint8_t buf[64];
+
+	memset(&eepromStats, 0, sizeof(eepromStats));
+	simPageWrites = 0;
+	srand(5);
+	simFailOneIn = 100;
+
+	for (int i = 0; i < NUM_RANDOM_WRITES; i++)
+	{
+		int address = rand() % (SIM_EEPROM_SIZE - sizeof(buf));
+		int size = 1 + (rand() % sizeof(buf));
+
+		for (int j = 0; j < size; j++)
+		{
+			buf[j] = rand();
+		}
+		memcpy(&expectedMemory[address], buf, size);
+		HOST_CHECK(EEPROM_Write(address, buf, size));
+
+		for (int t = rand() % 30; t > 0; t--)
+		{
+			hostAdvanceMillis(1);
+			EEPROM_Tick();
+		}
+	}
+
+	tickUntilWritten();
+	simFailOneIn = 100;
+
+	printf("Random failures: %d writes, %u page writes, %u write failures, %u pages dropped\n", NUM_RANDOM_WRITES, simPageWrites,
+			eepromStats.writeFailures, eepromStats.pagesDropped);
+	HOST_CHECK(eepromStats.writeFailures > 0);
+	HOST_CHECK(eepromStats.pagesDropped == 0);
+	HOST_CHECK(memcmp(simMemory, expectedMemory, SIM_EEPROM_SIZE) == 0);
+}
+
+int main(int argc, char **argv)
+{
+	testTransientFailure();
+	testPermanentFailure();
+	testRandomFailures();
+
+	HOST_CHECK(EEPROM_Flush());
+
+	return hostTestResult("eepromQueueTest");
+}
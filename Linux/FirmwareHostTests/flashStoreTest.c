@@ -0,0 +1,260 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Power cut replay test for the Flash store.
+ *
+ * A fixed sequence of writes and deletes is run once to count the program and erase operations it makes.
+ * It is then replayed once for every one of those operations, with the power cut part way through it,
+ * and sometimes a second time while the store is recovering. After each cut the store is re-initialised,
+ * as at boot, and every key must hold either the last value which was successfully written, or the value
+ * that was being written when the power went. The sequence then carries on to the end, and must finish
+ * with exactly the expected contents.
+ *
+ * Finally, the number of records written per sector erase is measured for the operating time counter,
+ * and for the mixed sequence.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include <functions/flashStore.h>
+
+#define NUM_TEST_KEYS  8
+#define NUM_OPS        500
+
+typedef struct
+{
+	int     key;
+	int     length;// 0 = delete
+	uint8_t data[FLASH_STORE_MAX_RECORD_LENGTH];
+} storeOp_t;
+
+typedef struct
+{
+	int     length;// 0 = no record
+	uint8_t data[FLASH_STORE_MAX_RECORD_LENGTH];
+} storeValue_t;
+
+static storeOp_t ops[NUM_OPS];
+static storeValue_t expected[FLASH_STORE_MAX_KEYS];
+static jmp_buf powerCutRestart;
+static volatile int nextOp;
+static volatile bool opInProgress;
+static int replayWriteOperations;// programs and erases made by the sequence, when the power isn't cut
+
+static void makeOps(void)
+{
+	srand(4);
+	for (int i = 0; i < NUM_OPS; i++)
+	{
+		ops[i].key = 1 + (rand() % NUM_TEST_KEYS);
+		ops[i].length = ((rand() % 10) == 0) ? 0 : (1 + (rand() % FLASH_STORE_MAX_RECORD_LENGTH));
+		for (int j = 0; j < ops[i].length; j++)
+		{
+			ops[i].data[j] = rand();
+		}
+	}
+}
+
+static bool valueMatches(int key, const storeValue_t *value)
+{
+	uint8_t buf[FLASH_STORE_MAX_RECORD_LENGTH];
+	int length = flashStoreRead(key, buf, sizeof(buf));
+
+	if (value->length == 0)
+	{
+		return (length < 0);
+	}
+
+	return ((length == value->length) && (memcmp(buf, value->data, length) == 0));
+}
+
+static void applyOp(const storeOp_t *op, storeValue_t *value)
+{
+	value->length = op->length;
+	memcpy(value->data, op->data, op->length);
+}
+
+// After a power cut, the key being changed may have either value, all the others must be unchanged
+static void checkAfterPowerCut(void)
+{
+	for (int key = 0; key < FLASH_STORE_MAX_KEYS; key++)
+	{
+		if (valueMatches(key, &expected[key]) == false)
+		{
+			storeValue_t newValue;
+
+			if (opInProgress && (key == ops[nextOp].key))
+			{
+				applyOp(&ops[nextOp], &newValue);
+				if (HOST_CHECK(valueMatches(key, &newValue)))
+				{
+					expected[key] = newValue;
+				}
+			}
+			else
+			{
+				HOST_CHECK(false);
+				printf("  key %d lost after a power cut before op %d\n", key, nextOp);
+			}
+		}
+	}
+}
+
+static void checkAll(void)
+{
+	for (int key = 0; key < FLASH_STORE_MAX_KEYS; key++)
+	{
+		HOST_CHECK(valueMatches(key, &expected[key]));
+	}
+}
+
+// Runs the sequence with the power cut during the given write operation, and then optionally a second time during recovery
+static void replay(int cutAt, int secondCutAt)
+{
+	volatile bool secondCutArmed = false;
+
+	mockFlashErase();
+	memset(expected, 0, sizeof(expected));
+	nextOp = 0;
+	opInProgress = false;
+	HOST_CHECK(flashStoreInit());
+
+	mockFlashSetPowerCut(cutAt, &powerCutRestart);
+	replayWriteOperations = -mockFlashGetWriteOperations();
+
+	if (setjmp(powerCutRestart) != 0)
+	{
+		// Power restored. Boot as the firmware does.
+		if ((secondCutAt > 0) && (secondCutArmed == false))
+		{
+			secondCutArmed = true;
+			mockFlashSetPowerCut(secondCutAt, &powerCutRestart);
+		}
+
+		HOST_CHECK(flashStoreInit());
+		checkAfterPowerCut();
+		opInProgress = false;
+	}
+
+	while (nextOp < NUM_OPS)
+	{
+		const storeOp_t *op = &ops[nextOp];
+
+		opInProgress = true;
+		if (op->length > 0)
+		{
+			HOST_CHECK(flashStoreWrite(op->key, op->data, op->length));
+		}
+		else
+		{
+			HOST_CHECK(flashStoreDelete(op->key));
+		}
+		applyOp(op, &expected[op->key]);
+		opInProgress = false;
+		nextOp++;
+
+		flashStoreTick();
+	}
+
+	mockFlashSetPowerCut(0, NULL);
+	replayWriteOperations += mockFlashGetWriteOperations();
+	checkAll();
+
+	// and the contents must be the same after a normal reboot
+	HOST_CHECK(flashStoreInit());
+	checkAll();
+}
+
+static void measureWritesPerErase(const char *name, void (*run)(void))
+{
+	mockFlashErase();
+	flashStoreInit();
+	memset(&flashStoreStats, 0, sizeof(flashStoreStats));
+	mockFlashResetStats();
+
+	run();
+
+	printf("%-40s %8u records %5u compactions %5u erases  %7.1f records per erase\n", name, flashStoreStats.recordsWritten,
+			flashStoreStats.compactions, mockFlashStats.sectorErases, (double)flashStoreStats.recordsWritten / mockFlashStats.sectorErases);
+}
+
+static void runOperatingTime(void)
+{
+	// What fw_operatingTimeTick() stores every 10 minutes, for 2 years of continuous use
+	for (uint32_t seconds = 600; seconds <= (2 * 365 * 24 * 3600); seconds += 600)
+	{
+		HOST_CHECK(flashStoreWrite(FLASH_STORE_KEY_OPERATING_TIME, (uint8_t *)&seconds, sizeof(seconds)));
+		flashStoreTick();
+	}
+}
+
+static void runMixed(void)
+{
+	for (int pass = 0; pass < 20; pass++)
+	{
+		for (int i = 0; i < NUM_OPS; i++)
+		{
+			if (ops[i].length > 0)
+			{
+				flashStoreWrite(ops[i].key, ops[i].data, ops[i].length);
+			}
+			else
+			{
+				flashStoreDelete(ops[i].key);
+			}
+			flashStoreTick();
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int writeOperations;
+	int replays = 0;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "flashStoreTest.img") == false)
+	{
+		return 1;
+	}
+
+	makeOps();
+
+	// Count the write operations in a run without power cuts
+	replay(0, 0);
+	writeOperations = replayWriteOperations;
+	printf("%d operations make %d programs and erases, %u compactions\n", NUM_OPS, writeOperations, flashStoreStats.compactions);
+
+	srand(7);
+	mockFlashResetStats();
+	for (int cutAt = 1; cutAt <= writeOperations; cutAt++)
+	{
+		replay(cutAt, (((rand() % 4) == 0) ? (1 + (rand() % 3)) : 0));
+		replays++;
+	}
+	printf("%d replays, %u power cuts\n\n", replays, mockFlashStats.powerCuts);
+	HOST_CHECK(mockFlashStats.powerCuts >= replays);
+
+	measureWritesPerErase("Operating time, every 10 minutes", runOperatingTime);
+	measureWritesPerErase("Mixed sequence, 20 times", runMixed);
+
+	mockFlashClose();
+
+	return hostTestResult("flashStoreTest");
+}
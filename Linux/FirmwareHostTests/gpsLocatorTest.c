@@ -0,0 +1,194 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Sends GPS LCs through lastHeardListUpdate() in the real uiUtilities.c, for every longitude (2^25 values)
+ * and every latitude (2^24 values), and checks the locator it gives against an exact reference.
+ * Each axis only depends on its own coordinate, so the other one is held at 0.
+ * The double code which the integer decoding replaced is run on the same values, and the differences
+ * between them are counted. They must all be coordinates on an exact subsquare boundary, which the double
+ * code put in the subsquare below.
+ *
+ * Usage: gpsLocatorTest [image file]
+ */
+#include <math.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include <HR-C6000.h>
+#include <user_interface/uiUtilities.h>
+
+#define LONGITUDE_STEPS (1 << 25)// 360/2^25 degrees each
+#define LATITUDE_STEPS  (1 << 24)// 180/2^24 degrees each
+
+// The locator decoding before it was changed to integer arithmetic
+static uint8_t *oldCoordsToMaidenhead(double longitude, double latitude)
+{
+	static uint8_t maidenhead[15];
+	double l, l2;
+	uint8_t c;
+
+	l = longitude;
+
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		l = l / ((i == 0) ? 20.0 : 10.0) + 9.0;
+		c = (uint8_t) l;
+		maidenhead[0 + i] = c + 'A';
+		l2 = c;
+		l -= l2;
+		l *= 10.0;
+		c = (uint8_t) l;
+		maidenhead[2 + i] = c + '0';
+		l2 = c;
+		l -= l2;
+		l *= 24.0;
+		c = (uint8_t) l;
+		maidenhead[4 + i] = c + 'A';
+
+		l = latitude;
+	}
+
+	maidenhead[6] = '\0';
+
+	return &maidenhead[0];
+}
+
+static uint8_t *oldDecodeGPSPosition(int32_t longitudeI, int32_t latitudeI)
+{
+	float longitude = 360.0F / 33554432.0F;	// 360/2^25 steps
+	float latitude  = 180.0F / 16777216.0F;	// 180/2^24 steps
+
+	longitude *= (float)longitudeI;
+	latitude  *= (float)latitudeI;
+
+	return (oldCoordsToMaidenhead(longitude, latitude));
+}
+
+// The subsquare number, counted from 180W or 90S, of the float the coordinate is decoded to.
+// A long double holds (degrees + offset) * subsquaresPerDegree exactly, so the floor is exact too.
+static uint32_t exactSubsquare(int32_t steps, float degreesPerStep, int offset, int subsquaresPerDegree)
+{
+	float degrees = degreesPerStep * (float)steps;
+
+	return (uint32_t)floorl(((long double)degrees + offset) * subsquaresPerDegree);
+}
+
+static void subsquareToLocator(uint32_t subsquares, uint8_t *locator)
+{
+	locator[0] = (subsquares / 240) + 'A';
+	locator[2] = ((subsquares / 24) % 10) + '0';
+	locator[4] = (subsquares % 24) + 'A';
+}
+
+static bool onSubsquareBoundary(int32_t steps, float degreesPerStep, int subsquaresPerDegree)
+{
+	long double subsquares = (long double)(degreesPerStep * (float)steps) * subsquaresPerDegree;
+
+	return (subsquares == floorl(subsquares));
+}
+
+static uint8_t *sendGPS(int32_t longitudeI, int32_t latitudeI)
+{
+	uint8_t frame[12];
+
+	memset(frame, 0, sizeof(frame));
+	frame[0] = 0x08;// GPS
+	frame[2] = (longitudeI >> 24) & 0x01;
+	frame[3] = (longitudeI >> 16) & 0xFF;
+	frame[4] = (longitudeI >> 8) & 0xFF;
+	frame[5] = longitudeI & 0xFF;
+	frame[6] = (latitudeI >> 16) & 0xFF;
+	frame[7] = (latitudeI >> 8) & 0xFF;
+	frame[8] = latitudeI & 0xFF;
+
+	lastHeardListUpdate(frame, true);
+
+	return (uint8_t *)LinkHead->locator;
+}
+
+// Returns the number of differences from the old code
+static int checkAxis(bool isLongitude)
+{
+	int32_t range = (isLongitude ? LONGITUDE_STEPS : LATITUDE_STEPS) / 2;
+	float degreesPerStep = isLongitude ? (360.0F / 33554432.0F) : (180.0F / 16777216.0F);
+	int offset = isLongitude ? 180 : 90;
+	int subsquaresPerDegree = isLongitude ? 12 : 24;
+	int axis = isLongitude ? 0 : 1;
+	uint8_t expected[7];
+	uint8_t *locator;
+	uint8_t *oldLocator;
+	uint32_t expectedSubsquare;
+	int differences = 0;
+
+	// The other axis is at 0, which is the start of field J, square 0, subsquare A
+	memcpy(expected, "JJ00AA", sizeof(expected));
+
+	for (int32_t steps = -range; steps < range; steps++)
+	{
+		expectedSubsquare = exactSubsquare(steps, degreesPerStep, offset, subsquaresPerDegree);
+		subsquareToLocator(expectedSubsquare, &expected[axis]);
+
+		locator = sendGPS(isLongitude ? steps : 0, isLongitude ? 0 : steps);
+		if (memcmp(locator, expected, sizeof(expected)) != 0)
+		{
+			HOST_CHECK(memcmp(locator, expected, sizeof(expected)) == 0);
+			printf("%s %d: %s, expected %s\n", (isLongitude ? "Longitude" : "Latitude"), steps, locator, expected);
+		}
+
+		oldLocator = oldDecodeGPSPosition(isLongitude ? steps : 0, isLongitude ? 0 : steps);
+		if (memcmp(oldLocator, expected, sizeof(expected)) != 0)
+		{
+			differences++;
+			HOST_CHECK(onSubsquareBoundary(steps, degreesPerStep, subsquaresPerDegree));
+			subsquareToLocator(expectedSubsquare - 1, &expected[axis]);
+			HOST_CHECK(memcmp(oldLocator, expected, sizeof(expected)) == 0);
+		}
+	}
+
+	return differences;
+}
+
+int main(int argc, char **argv)
+{
+	int longitudeDifferences, latitudeDifferences;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "gpsLocatorTest.img") == false)
+	{
+		return 1;
+	}
+
+	mockFlashErase();
+	lastheardInitList();
+
+	// A few places, as a check on the reference
+	HOST_CHECK(strcmp((char *)sendGPS(-11893, 4800819), "IO91WM") == 0);// London, 0.1276W 51.5072N
+	HOST_CHECK(strcmp((char *)sendGPS(13511540, -3524483), "QF22LE") == 0);// Melbourne, 144.9631E 37.8136S
+	HOST_CHECK(strcmp((char *)sendGPS(-16777216, -8388608), "AA00AA") == 0);
+
+	longitudeDifferences = checkAxis(true);
+	latitudeDifferences = checkAxis(false);
+
+	printf("%d longitudes and %d latitudes match the exact locator\n", LONGITUDE_STEPS, LATITUDE_STEPS);
+	printf("The old double code differs for %d longitudes and %d latitudes, all on subsquare boundaries\n",
+			longitudeDifferences, latitudeDifferences);
+
+	mockFlashClose();
+
+	return hostTestResult("gpsLocatorTest");
+}
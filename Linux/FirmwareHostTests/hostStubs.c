@@ -0,0 +1,75 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#include <time.h>
+#include "hostStubs.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+uint32_t hostMillis;
+static int hostChecks;
+static int hostFailures;
+
+uint32_t fw_millis(void)
+{
+	return hostMillis;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+	hostMillis += xTicksToDelay;// 1 ms ticks
+}
+
+void gpioInitFlash(void)
+{
+}
+
+void hostAdvanceMillis(uint32_t ms)
+{
+	hostMillis += ms;
+}
+
+double hostSeconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+bool hostCheck(bool cond, const char *text, const char *file, int line)
+{
+	hostChecks++;
+	if (cond == false)
+	{
+		hostFailures++;
+		if (hostFailures <= 20)
+		{
+			printf("%s:%d: check failed: %s\n", file, line, text);
+		}
+	}
+
+	return cond;
+}
+
+int hostTestResult(const char *testName)
+{
+	printf("%s: %d checks, %d failed\n", testName, hostChecks, hostFailures);
+
+	return ((hostFailures == 0) ? 0 : 1);
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef _HOST_STUBS_H_
+#define _HOST_STUBS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * Replacements for the RTOS and hardware functions used by the firmware modules under test.
+ * Time only moves when a test advances it, or when the firmware calls vTaskDelay().
+ */
+extern uint32_t hostMillis;
+
+void hostAdvanceMillis(uint32_t ms);
+double hostSeconds(void);// Wall clock, for the benchmarks
+
+#define HOST_CHECK(cond) hostCheck((cond), #cond, __FILE__, __LINE__)
+bool hostCheck(bool cond, const char *text, const char *file, int line);
+int hostTestResult(const char *testName);// Prints the summary and returns the exit code
+
+#endif
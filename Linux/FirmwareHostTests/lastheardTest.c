@@ -0,0 +1,269 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Drives synthetic DMR call traffic through lastHeardListUpdate() in the real uiUtilities.c, and after every
+ * frame checks the last heard list and its hash against a simple most recently heard model: the list order,
+ * the links in both directions, the talkgroups, and that lastheardFindInList() finds exactly the listed IDs.
+ * It then times lastheardFindInList() against the list walk it replaced.
+ *
+ * Usage: lastheardTest [image file]
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include <HR-C6000.h>
+#include <user_interface/uiUtilities.h>
+
+#define NUM_STATIONS     300
+#define NUM_TALKGROUPS   12
+#define NUM_FRAMES       200000
+#define NUM_FIND_TIMINGS 2000000
+
+typedef struct
+{
+	uint32_t id;
+	uint32_t talkGroupOrPcId;
+	uint32_t time;
+} modelItem_t;
+
+static modelItem_t model[NUM_LASTHEARD_STORED];// Most recently heard first
+static int modelCount;
+static uint32_t stations[NUM_STATIONS];
+static uint32_t talkgroups[NUM_TALKGROUPS];
+
+static void modelHeard(uint32_t id, uint32_t talkGroupOrPcId)
+{
+	int pos = 0;
+
+	while ((pos < modelCount) && (model[pos].id != id))
+	{
+		pos++;
+	}
+
+	if (pos == modelCount)
+	{
+		if (modelCount < NUM_LASTHEARD_STORED)
+		{
+			modelCount++;
+		}
+		pos = modelCount - 1;// The oldest is dropped
+	}
+
+	memmove(&model[1], &model[0], pos * sizeof(modelItem_t));
+	model[0].id = id;
+	model[0].talkGroupOrPcId = talkGroupOrPcId;
+	model[0].time = hostMillis;
+}
+
+static bool modelContains(uint32_t id)
+{
+	for (int i = 0; i < modelCount; i++)
+	{
+		if (model[i].id == id)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void checkList(void)
+{
+	LinkItem_t *item = LinkHead;
+	LinkItem_t *prev = NULL;
+	int count = 0;
+
+	HOST_CHECK(numLastHeard == modelCount);
+
+	while (item != NULL)
+	{
+		HOST_CHECK(item->prev == prev);
+		if (count < modelCount)
+		{
+			HOST_CHECK(item->id == model[count].id);
+			HOST_CHECK(item->talkGroupOrPcId == model[count].talkGroupOrPcId);
+			HOST_CHECK(item->time == model[count].time);
+			HOST_CHECK(lastheardFindInList(model[count].id) == item);
+		}
+		prev = item;
+		item = item->next;
+		count++;
+	}
+
+	HOST_CHECK(count == NUM_LASTHEARD_STORED);
+}
+
+// A talkgroup or private call frame, as the hotspot passes it in
+static bool sendFrame(uint32_t id, uint32_t talkGroupOrPcId)
+{
+	uint8_t frame[12];
+
+	memset(frame, 0, sizeof(frame));
+	frame[0] = talkGroupOrPcId >> 24;
+	frame[3] = (talkGroupOrPcId >> 16) & 0xFF;
+	frame[4] = (talkGroupOrPcId >> 8) & 0xFF;
+	frame[5] = talkGroupOrPcId & 0xFF;
+	frame[6] = (id >> 16) & 0xFF;
+	frame[7] = (id >> 8) & 0xFF;
+	frame[8] = id & 0xFF;
+
+	return lastHeardListUpdate(frame, true);
+}
+
+// A few stations make most of the calls, as on a busy talkgroup
+static uint32_t pickStation(void)
+{
+	int r = rand() % 100;
+
+	if (r < 50)
+	{
+		return stations[rand() % 10];
+	}
+	if (r < 80)
+	{
+		return stations[10 + (rand() % 40)];
+	}
+	return stations[50 + (rand() % (NUM_STATIONS - 50))];
+}
+
+// The list walk lastheardFindInList() used before the hash
+static LinkItem_t *oldFindInList(uint32_t id)
+{
+	LinkItem_t *item = LinkHead;
+
+	while (item->next != NULL)
+	{
+		if (item->id == id)
+		{
+			return item;
+		}
+		item = item->next;
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	static uint32_t findIds[1024];
+	volatile uintptr_t sink = 0;
+	uint32_t talkGroupOrPcId = 0;
+	uint32_t id = 0;
+	double start, oldTime, hashTime;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "lastheardTest.img") == false)
+	{
+		return 1;
+	}
+
+	srand(17);
+	mockFlashErase();// No DMR ID database, so names are not found
+	lastheardInitList();
+	lastHeardClearLastID();
+
+	for (int i = 0; i < NUM_STATIONS; i++)
+	{
+		stations[i] = 2340000 + (rand() % 900000);
+	}
+	for (int i = 0; i < NUM_TALKGROUPS; i++)
+	{
+		talkgroups[i] = (TG_CALL_FLAG << 24) | (1 + (rand() % 99999));
+	}
+
+	for (int f = 0; f < NUM_FRAMES; f++)
+	{
+		int r = rand() % 100;
+
+		hostAdvanceMillis(60);
+
+		if (r < 70)
+		{
+			// A new over, mostly on the same talkgroup
+			id = pickStation();
+			if ((rand() % 10) == 0)
+			{
+				talkGroupOrPcId = talkgroups[rand() % NUM_TALKGROUPS];
+			}
+		}
+		else if (r < 75)
+		{
+			// Private call
+			id = pickStation();
+			talkGroupOrPcId = (PC_CALL_FLAG << 24) | stations[rand() % NUM_STATIONS];
+		}
+		else if (r < 80)
+		{
+			// The same station moves to another talkgroup
+			talkGroupOrPcId = talkgroups[rand() % NUM_TALKGROUPS];
+		}
+		else if (r < 85)
+		{
+			// End of the over, so the same station counts as a new call
+			lastHeardClearLastID();
+			continue;
+		}
+		// Otherwise a repeat of the last frame, as in a continuing over
+
+		if ((id == 0) || (talkGroupOrPcId == 0))
+		{
+			continue;
+		}
+
+		if (sendFrame(id, talkGroupOrPcId))
+		{
+			modelHeard(id, talkGroupOrPcId);
+		}
+		checkList();
+
+		if ((f % 997) == 0)
+		{
+			uint32_t other = 1 + (rand() % 0xFFFFFF);
+
+			HOST_CHECK((lastheardFindInList(other) != NULL) == modelContains(other));
+		}
+	}
+
+	// Half of the IDs searched for are in the list, as when the same stations keep calling
+	for (int i = 0; i < 1024; i++)
+	{
+		findIds[i] = ((i % 2) == 0) ? model[rand() % modelCount].id : (1 + (rand() % 0xFFFFFF));
+	}
+
+	start = hostSeconds();
+	for (int i = 0; i < NUM_FIND_TIMINGS; i++)
+	{
+		sink += (uintptr_t)oldFindInList(findIds[i & 1023]);
+	}
+	oldTime = hostSeconds() - start;
+
+	start = hostSeconds();
+	for (int i = 0; i < NUM_FIND_TIMINGS; i++)
+	{
+		sink += (uintptr_t)lastheardFindInList(findIds[i & 1023]);
+	}
+	hashTime = hostSeconds() - start;
+
+	printf("%d frames from %d stations, %d in the list\n", NUM_FRAMES, NUM_STATIONS, numLastHeard);
+	printf("%-24s %8.1f ns per find\n", "List walk (old)", (oldTime * 1e9) / NUM_FIND_TIMINGS);
+	printf("%-24s %8.1f ns per find   x%.1f\n", "Hash", (hashTime * 1e9) / NUM_FIND_TIMINGS, oldTime / hashTime);
+
+	mockFlashClose();
+
+	return hostTestResult("lastheardTest");
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Compares prepare_framedata() in the real mbelib.c with the version before its FEC decoding was changed to packed
+ * codeword words (mbelibOld.c). ambe_d, errs and errs2 must match for every frame. Half the frames are random,
+ * which covers every Golay correction, as any 23 bit word is within 3 bits of a codeword. The other half are
+ * earlier frames with 1 to 3 bits flipped, as a weak signal gives. Both versions are then timed.
+ *
+ * Usage: mbelibFECBenchmark
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include <dmr_codec/mbelib.h>
+
+#define NUM_FRAMES         4000000
+#define NUM_TIMING_FRAMES  4096
+#define NUM_TIMING_PASSES  500
+#define AMBE_D_SIZE        49
+
+void oldPrepareFramedata(uint8_t *indata, char *ambe_d, int *errs, int *errs2);// mbelibOld.c
+
+static uint32_t randomState = 12345;
+
+// xorshift, so the frames are the same on every host
+static uint32_t randomNext(void)
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+
+	return randomState;
+}
+
+static int compareFrames(void)
+{
+	static uint8_t history[4096][9];
+	uint8_t frame[9];
+	char ambe_d[AMBE_D_SIZE], oldAmbe_d[AMBE_D_SIZE];
+	int errs, errs2, oldErrs, oldErrs2;
+	int mismatches = 0;
+
+	for (int f = 0; f < NUM_FRAMES; f++)
+	{
+		if ((f & 0x01) == 0)
+		{
+			for (int i = 0; i < sizeof(frame); i++)
+			{
+				frame[i] = randomNext();
+			}
+		}
+		else
+		{
+			int flips = 1 + (randomNext() % 3);
+
+			memcpy(frame, history[randomNext() % 4096], sizeof(frame));
+			for (int i = 0; i < flips; i++)
+			{
+				int bit = randomNext() % 72;
+
+				frame[bit >> 3] ^= (0x80 >> (bit & 0x07));
+			}
+		}
+		memcpy(history[f % 4096], frame, sizeof(frame));
+
+		// Both must write every byte of ambe_d
+		memset(ambe_d, 0x55, sizeof(ambe_d));
+		memset(oldAmbe_d, 0xAA, sizeof(oldAmbe_d));
+
+		prepare_framedata(frame, ambe_d, &errs, &errs2);
+		oldPrepareFramedata(frame, oldAmbe_d, &oldErrs, &oldErrs2);
+
+		if ((memcmp(ambe_d, oldAmbe_d, sizeof(ambe_d)) != 0) || (errs != oldErrs) || (errs2 != oldErrs2))
+		{
+			if (mismatches < 5)
+			{
+				printf("Frame %d: errs %d/%d, errs2 %d/%d (new/old)\n", f, errs, oldErrs, errs2, oldErrs2);
+			}
+			mismatches++;
+		}
+		HOST_CHECK((errs >= 0) && (errs <= 3) && (errs2 >= errs) && (errs2 <= (errs + 3)));
+	}
+
+	return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t frames[NUM_TIMING_FRAMES][9];
+	char ambe_d[AMBE_D_SIZE];
+	int errs, errs2;
+	volatile int sink = 0;
+	int mismatches;
+	double start, oldTime, newTime;
+
+	mismatches = compareFrames();
+	HOST_CHECK(mismatches == 0);
+	printf("%d frames, %d differ from the old FEC decoding\n", NUM_FRAMES, mismatches);
+
+	for (int i = 0; i < NUM_TIMING_FRAMES; i++)
+	{
+		for (int j = 0; j < 9; j++)
+		{
+			frames[i][j] = randomNext();
+		}
+	}
+
+	start = hostSeconds();
+	for (int p = 0; p < NUM_TIMING_PASSES; p++)
+	{
+		for (int i = 0; i < NUM_TIMING_FRAMES; i++)
+		{
+			oldPrepareFramedata(frames[i], ambe_d, &errs, &errs2);
+			sink += ambe_d[p % AMBE_D_SIZE] + errs2;
+		}
+	}
+	oldTime = hostSeconds() - start;
+
+	start = hostSeconds();
+	for (int p = 0; p < NUM_TIMING_PASSES; p++)
+	{
+		for (int i = 0; i < NUM_TIMING_FRAMES; i++)
+		{
+			prepare_framedata(frames[i], ambe_d, &errs, &errs2);
+			sink += ambe_d[p % AMBE_D_SIZE] + errs2;
+		}
+	}
+	newTime = hostSeconds() - start;
+
+	printf("%-24s %8.1f ns per frame\n", "Char per bit (old)", (oldTime * 1e9) / (NUM_TIMING_PASSES * NUM_TIMING_FRAMES));
+	printf("%-24s %8.1f ns per frame   x%.1f\n", "Packed words", (newTime * 1e9) / (NUM_TIMING_PASSES * NUM_TIMING_FRAMES), oldTime / newTime);
+
+	return hostTestResult("mbelibFECBenchmark");
+}
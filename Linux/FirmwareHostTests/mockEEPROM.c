@@ -0,0 +1,78 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#include <string.h>
+#include <EEPROM.h>
+#include "mockEEPROM.h"
+
+mockEEPROMStats_t mockEEPROMStats;
+static uint8_t eepromImage[MOCK_EEPROM_SIZE];
+
+uint8_t *mockEEPROMGetImage(void)
+{
+	return eepromImage;
+}
+
+void mockEEPROMResetStats(void)
+{
+	memset(&mockEEPROMStats, 0, sizeof(mockEEPROMStats));
+}
+
+bool EEPROM_Read(int address, uint8_t *buf, int size)
+{
+	if ((address < 0) || ((address + size) > MOCK_EEPROM_SIZE))
+	{
+		return false;
+	}
+
+	memcpy(buf, &eepromImage[address], size);
+	mockEEPROMStats.reads++;
+
+	return true;
+}
+
+bool EEPROM_Write(int address, uint8_t *buf, int size)
+{
+	if ((address < 0) || ((address + size) > MOCK_EEPROM_SIZE))
+	{
+		return false;
+	}
+
+	if (size > 0)
+	{
+		memcpy(&eepromImage[address], buf, size);
+		mockEEPROMStats.writes++;
+		mockEEPROMStats.bytesWritten += size;
+		mockEEPROMStats.pageWrites += ((address + size - 1) / MOCK_EEPROM_PAGE_SIZE) - (address / MOCK_EEPROM_PAGE_SIZE) + 1;
+	}
+
+	return true;
+}
+
+void EEPROM_Tick(void)
+{
+}
+
+bool EEPROM_Flush(void)
+{
+	return true;
+}
+
+bool EEPROM_IsWritePending(void)
+{
+	return false;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef _MOCK_EEPROM_H_
+#define _MOCK_EEPROM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 64K I2C EEPROM held in RAM, replacing EEPROM.c. Writes take effect immediately.
+ */
+#define MOCK_EEPROM_SIZE       (64 * 1024)
+#define MOCK_EEPROM_PAGE_SIZE  128
+
+typedef struct
+{
+	uint32_t writes;// EEPROM_Write() calls
+	uint32_t bytesWritten;
+	uint32_t pageWrites;// page write cycles the real EEPROM would need
+	uint32_t reads;
+} mockEEPROMStats_t;
+
+extern mockEEPROMStats_t mockEEPROMStats;
+
+uint8_t *mockEEPROMGetImage(void);
+void mockEEPROMResetStats(void);
+
+#endif
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "mockFlash.h"
+
+#define CMD_WRITE_ENABLE   0x06
+#define CMD_WRITE_DISABLE  0x04
+#define CMD_READ_SR1       0x05
+#define CMD_READ_SR2       0x35
+#define CMD_PAGE_PROGRAM   0x02
+#define CMD_SECTOR_ERASE   0x20
+#define CMD_JEDEC_ID       0x9f
+#define CMD_READ           0x03
+#define CMD_FAST_READ      0x0b
+
+const mockFlashBusModel_t MOCK_FLASH_BUS_BITBANG = { .name = "bit-bang", .accessesPerBitOut = 4, .accessesPerBitIn = 4, .accessesPerRead = 0 };// CLK low, MOSI, MISO, CLK high for every bit
+const mockFlashBusModel_t MOCK_FLASH_BUS_BLOCK = { .name = "block", .accessesPerBitOut = 3, .accessesPerBitIn = 3, .accessesPerRead = 1 };// MOSI is only set once per block read
+
+mockFlashStats_t mockFlashStats;
+
+static void mock_flash_select(void);
+static void mock_flash_deselect(void);
+static void mock_flash_writeBuf(const uint8_t *buf, int size);
+static void mock_flash_readBuf(uint8_t *buf, int size);
+
+const spiFlashTransport_t MOCK_FLASH_TRANSPORT =
+{
+	.select = mock_flash_select,
+	.deselect = mock_flash_deselect,
+	.writeBuf = mock_flash_writeBuf,
+	.readBuf = mock_flash_readBuf
+};
+
+static struct
+{
+	uint8_t *image;
+	int fd;
+	const mockFlashBusModel_t *busModel;
+	bool selected;
+	bool writeEnabled;
+	uint8_t command;
+	int headerLength;// bytes received since CS was asserted, up to the end of the address (and dummy byte)
+	uint32_t address;
+	uint32_t programStart;// address in the PAGE_PROGRAM command
+	int idPos;
+	uint8_t pageData[256];
+	bool pageDataValid[256];
+	int writeOperations;
+	int powerCutOperation;// absolute operation count at which the power is cut, 0 = never
+	jmp_buf *restartPoint;
+} chip = { .fd = -1, .busModel = &MOCK_FLASH_BUS_BLOCK };
+
+static int mock_flash_headerLength(uint8_t command)
+{
+	switch (command)
+	{
+		case CMD_READ:
+		case CMD_PAGE_PROGRAM:
+		case CMD_SECTOR_ERASE:
+			return 4;
+		case CMD_FAST_READ:
+			return 5;
+		default:
+			return 1;
+	}
+}
+
+bool mockFlashOpen(const char *imagePath)
+{
+	bool isNew;
+
+	chip.fd = open(imagePath, O_RDWR | O_CREAT, 0644);
+	if (chip.fd < 0)
+	{
+		perror(imagePath);
+		return false;
+	}
+
+	isNew = (lseek(chip.fd, 0, SEEK_END) < MOCK_FLASH_SIZE);
+	if (isNew && (ftruncate(chip.fd, MOCK_FLASH_SIZE) != 0))
+	{
+		perror(imagePath);
+		close(chip.fd);
+		return false;
+	}
+
+	chip.image = mmap(NULL, MOCK_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, chip.fd, 0);
+	if (chip.image == MAP_FAILED)
+	{
+		perror(imagePath);
+		close(chip.fd);
+		return false;
+	}
+
+	if (isNew)
+	{
+		memset(chip.image, 0xFF, MOCK_FLASH_SIZE);
+	}
+
+	chip.selected = false;
+	chip.writeEnabled = false;
+	chip.writeOperations = 0;
+	chip.powerCutOperation = 0;
+	mockFlashResetStats();
+	SPI_Flash_setTransport(&MOCK_FLASH_TRANSPORT);
+
+	return true;
+}
+
+void mockFlashClose(void)
+{
+	if (chip.fd >= 0)
+	{
+		munmap(chip.image, MOCK_FLASH_SIZE);
+		close(chip.fd);
+		chip.fd = -1;
+		chip.image = NULL;
+	}
+}
+
+uint8_t *mockFlashGetImage(void)
+{
+	return chip.image;
+}
+
+void mockFlashErase(void)
+{
+	memset(chip.image, 0xFF, MOCK_FLASH_SIZE);
+}
+
+void mockFlashSetBusModel(const mockFlashBusModel_t *model)
+{
+	chip.busModel = model;
+}
+
+void mockFlashResetStats(void)
+{
+	memset(&mockFlashStats, 0, sizeof(mockFlashStats));
+}
+
+void mockFlashSetPowerCut(int operation, jmp_buf *restartPoint)
+{
+	chip.powerCutOperation = ((operation > 0) ? (chip.writeOperations + operation) : 0);
+	chip.restartPoint = restartPoint;
+}
+
+int mockFlashGetWriteOperations(void)
+{
+	return chip.writeOperations;
+}
+
+static void mock_flash_countBus(int bytes, int accessesPerBit)
+{
+	uint64_t accesses = (uint64_t)bytes * 8 * accessesPerBit;
+
+	mockFlashStats.gpioAccesses += accesses;
+	mockFlashStats.busTimeNs += accesses * MOCK_FLASH_NS_PER_GPIO_ACCESS;
+}
+
+static void mock_flash_select(void)
+{
+	chip.selected = true;
+	chip.command = 0;
+	chip.headerLength = 0;
+	chip.address = 0;
+	chip.idPos = 0;
+	memset(chip.pageDataValid, 0, sizeof(chip.pageDataValid));
+
+	mockFlashStats.selects++;
+	mockFlashStats.gpioAccesses++;
+	mockFlashStats.busTimeNs += MOCK_FLASH_NS_PER_GPIO_ACCESS;
+}
+
+// The power is cut part way through this operation. Only some of the bytes change, and the last one may only be partly done.
+static void mock_flash_cutPower(uint32_t address, bool isErase)
+{
+	int length = (isErase ? 4096 : 256);
+	int done = rand() % (length + 1);
+
+	for (int i = 0; i < length; i++)
+	{
+		if (isErase)
+		{
+			if ((i < done) || (rand() & 1))
+			{
+				chip.image[address + i] = 0xFF;
+			}
+		}
+		else
+		{
+			// Bytes are programmed in the order they were sent, from the start address round to the end of the page
+			int offset = (address + i) & 0xFF;
+			uint32_t pos = (address & ~0xFF) + offset;
+
+			if (chip.pageDataValid[offset])
+			{
+				if (i < done)
+				{
+					chip.image[pos] &= chip.pageData[offset];
+				}
+				else if (i == done)
+				{
+					chip.image[pos] &= (chip.pageData[offset] | rand());// only some of the bits have been cleared
+				}
+			}
+		}
+	}
+
+	mockFlashStats.powerCuts++;
+	chip.powerCutOperation = 0;
+	chip.selected = false;
+	chip.writeEnabled = false;
+	longjmp(*chip.restartPoint, 1);
+}
+
+static bool mock_flash_startWriteOperation(void)
+{
+	if (chip.writeEnabled == false)
+	{
+		return false;// The chip ignores program and erase commands unless they follow WRITE_ENABLE
+	}
+
+	chip.writeEnabled = false;
+	chip.writeOperations++;
+
+	return true;
+}
+
+// Program and erase commands are carried out when CS is released, as on the real chip
+static void mock_flash_deselect(void)
+{
+	mockFlashStats.gpioAccesses++;
+	mockFlashStats.busTimeNs += MOCK_FLASH_NS_PER_GPIO_ACCESS;
+
+	if (chip.selected == false)
+	{
+		return;
+	}
+	chip.selected = false;
+
+	switch (chip.command)
+	{
+		case CMD_WRITE_ENABLE:
+			chip.writeEnabled = true;
+			break;
+		case CMD_WRITE_DISABLE:
+			chip.writeEnabled = false;
+			break;
+		case CMD_PAGE_PROGRAM:
+			if ((chip.headerLength == 4) && mock_flash_startWriteOperation())
+			{
+				uint32_t pageStart = chip.address & ~0xFF;
+
+				if (chip.writeOperations == chip.powerCutOperation)
+				{
+					mock_flash_cutPower(chip.programStart, false);
+				}
+
+				for (int i = 0; i < 256; i++)
+				{
+					if (chip.pageDataValid[i])
+					{
+						chip.image[pageStart + i] &= chip.pageData[i];// Programming can only clear bits
+						mockFlashStats.bytesProgrammed++;
+					}
+				}
+				mockFlashStats.pagePrograms++;
+			}
+			break;
+		case CMD_SECTOR_ERASE:
+			if ((chip.headerLength == 4) && mock_flash_startWriteOperation())
+			{
+				uint32_t sectorStart = chip.address & ~0xFFF;
+
+				if (chip.writeOperations == chip.powerCutOperation)
+				{
+					mock_flash_cutPower(sectorStart, true);
+				}
+
+				memset(&chip.image[sectorStart], 0xFF, 4096);
+				mockFlashStats.sectorErases++;
+			}
+			break;
+	}
+}
+
+static void mock_flash_writeBuf(const uint8_t *buf, int size)
+{
+	mockFlashStats.bytesOut += size;
+	mock_flash_countBus(size, chip.busModel->accessesPerBitOut);
+
+	for (int i = 0; (i < size) && chip.selected; i++)
+	{
+		if (chip.headerLength == 0)
+		{
+			chip.command = buf[i];
+			chip.headerLength = 1;
+		}
+		else if (chip.headerLength < mock_flash_headerLength(chip.command))
+		{
+			if (chip.headerLength < 4)
+			{
+				chip.address = ((chip.address << 8) | buf[i]) & (MOCK_FLASH_SIZE - 1);
+				chip.programStart = chip.address;
+			}
+			chip.headerLength++;
+		}
+		else if (chip.command == CMD_PAGE_PROGRAM)
+		{
+			// Data wraps round within the page
+			chip.pageData[chip.address & 0xFF] = buf[i];
+			chip.pageDataValid[chip.address & 0xFF] = true;
+			chip.address = (chip.address & ~0xFF) | ((chip.address + 1) & 0xFF);
+		}
+	}
+}
+
+static void mock_flash_readBuf(uint8_t *buf, int size)
+{
+	static const uint8_t JEDEC_ID[3] = { 0xef, 0x40, 0x14 };// Winbond W25Q80
+
+	mockFlashStats.bytesIn += size;
+	mock_flash_countBus(size, chip.busModel->accessesPerBitIn);
+	mockFlashStats.gpioAccesses += chip.busModel->accessesPerRead;
+	mockFlashStats.busTimeNs += chip.busModel->accessesPerRead * MOCK_FLASH_NS_PER_GPIO_ACCESS;
+
+	for (int i = 0; i < size; i++)
+	{
+		uint8_t data = 0xFF;
+
+		if (chip.selected && (chip.headerLength == mock_flash_headerLength(chip.command)))
+		{
+			switch (chip.command)
+			{
+				case CMD_READ:
+				case CMD_FAST_READ:
+					data = chip.image[chip.address];
+					chip.address = (chip.address + 1) & (MOCK_FLASH_SIZE - 1);
+					break;
+				case CMD_READ_SR1:
+				case CMD_READ_SR2:
+					data = 0x00;// Never busy, as the operations complete immediately
+					break;
+				case CMD_JEDEC_ID:
+					data = (chip.idPos < sizeof(JEDEC_ID)) ? JEDEC_ID[chip.idPos++] : 0xFF;
+					break;
+			}
+		}
+		buf[i] = data;
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef _MOCK_FLASH_H_
+#define _MOCK_FLASH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#include <SPI_Flash.h>
+
+/*
+ * Simulated W25Q80 on a file-backed image, plugged into SPI_Flash.c as its transport.
+ *
+ * The chip decodes the same commands as the real one (READ, FAST_READ, PAGE_PGM, SECTOR_E, status and ID reads),
+ * so the firmware code runs unchanged on top of it. Every byte on the bus is counted, and the bus time is estimated
+ * from the number of GPIO register accesses the selected firmware backend makes per bit.
+ *
+ * For the power cut tests, a program or erase can be cut short part way through, after which the chip stops
+ * and the test is resumed at the setjmp() point passed to mockFlashSetPowerCut().
+ */
+#define MOCK_FLASH_SIZE               (1024 * 1024)
+#define MOCK_FLASH_NS_PER_GPIO_ACCESS 33// About two clocks of the 60 MHz peripheral bus
+
+typedef struct
+{
+	const char *name;
+	int accessesPerBitOut;// GPIO register accesses per bit clocked out
+	int accessesPerBitIn;
+	int accessesPerRead;// once per block read
+} mockFlashBusModel_t;
+
+extern const mockFlashBusModel_t MOCK_FLASH_BUS_BITBANG;// SPI_FLASH_TRANSPORT_BITBANG
+extern const mockFlashBusModel_t MOCK_FLASH_BUS_BLOCK;// SPI_FLASH_TRANSPORT_BLOCK
+
+typedef struct
+{
+	uint64_t selects;// commands, i.e. CS assertions
+	uint64_t bytesOut;// command, address and data bytes sent to the chip
+	uint64_t bytesIn;
+	uint64_t gpioAccesses;
+	uint64_t busTimeNs;
+	uint32_t sectorErases;
+	uint32_t pagePrograms;
+	uint32_t bytesProgrammed;
+	uint32_t powerCuts;
+} mockFlashStats_t;
+
+extern mockFlashStats_t mockFlashStats;
+extern const spiFlashTransport_t MOCK_FLASH_TRANSPORT;
+
+bool mockFlashOpen(const char *imagePath);// Creates a blank (0xFF) image if the file doesn't exist. Also selects MOCK_FLASH_TRANSPORT
+void mockFlashClose(void);
+uint8_t *mockFlashGetImage(void);
+void mockFlashErase(void);// Whole chip, without counting it
+void mockFlashSetBusModel(const mockFlashBusModel_t *model);
+void mockFlashResetStats(void);
+void mockFlashSetPowerCut(int operation, jmp_buf *restartPoint);// Cut the power during the n'th next program or erase (1 = the next one). 0 disables
+int mockFlashGetWriteOperations(void);// Programs and erases since the image was opened
+
+#endif
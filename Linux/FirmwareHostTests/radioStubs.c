@@ -0,0 +1,232 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Replacements for the display, radio, menu and voice prompt code used by uiUtilities.c, so it can be linked
+ * on its own. They are weak, so a test can replace any of them with its own version.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include <adc.h>
+#include <wdog.h>
+#include <HR-C6000.h>
+#include <settings.h>
+#include <sound.h>
+#include <ticks.h>
+#include <trx.h>
+#include <UC1701.h>
+#include <voicePrompts.h>
+#include <functions/callLog.h>
+#include <user_interface/menuSystem.h>
+#include <user_interface/uiLocalisation.h>
+
+#define WEAK __attribute__((weak))
+
+// Hardware
+WEAK const int BATTERY_MAX_VOLTAGE = 82;
+WEAK const int CUTOFF_VOLTAGE_UPPER_HYST = 64;
+WEAK float averageBatteryVoltage = 80;
+WEAK volatile uint8_t DMR_frame_buffer[DMR_FRAME_BUFFER_SIZE];
+WEAK volatile int dmrMonitorCapturedTS = -1;
+WEAK volatile int micAudioSamplesTotal;
+WEAK volatile int slot_state = DMR_STATE_IDLE;
+WEAK const uint8_t TG_CALL_FLAG = 0x00;
+WEAK const uint8_t PC_CALL_FLAG = 0x03;
+
+WEAK int HRC6000GetReceivedSrcId(void)
+{
+	return 0;
+}
+
+WEAK int HRC6000GetReceivedTgOrPcId(void)
+{
+	return 0;
+}
+
+WEAK bool checkTalkGroupFilter(void)
+{
+	return true;
+}
+
+WEAK uint8_t getAudioAmpStatus(void)
+{
+	return 0;
+}
+
+// Radio
+WEAK uint32_t trxDMRID;
+WEAK uint32_t trxTalkGroupOrPcId;
+WEAK int trxCurrentBand[2];
+WEAK volatile bool trxTransmissionEnabled = false;
+WEAK volatile uint8_t trxRxSignal;
+WEAK volatile uint8_t trxTxMic;
+
+WEAK int trxGetMode(void)
+{
+	return RADIO_MODE_DIGITAL;
+}
+
+WEAK int trxGetBandwidthIs25kHz(void)
+{
+	return 0;
+}
+
+WEAK int trxGetDMRColourCode(void)
+{
+	return 1;
+}
+
+WEAK int trxGetDMRTimeSlot(void)
+{
+	return 0;
+}
+
+WEAK void trxReadVoxAndMicStrength(void)
+{
+}
+
+WEAK void trxSetPowerFromLevel(int powerLevel)
+{
+}
+
+// Settings, which are plain assignments here
+WEAK settingsStruct_t nonVolatileSettings;
+WEAK struct_codeplugChannel_t *currentChannelData;
+WEAK struct_codeplugChannel_t channelScreenChannelData;
+WEAK int settingsUsbMode;
+
+WEAK void settingsSetUINT8(uint8_t *s, uint8_t v)
+{
+	*s = v;
+}
+
+WEAK void settingsSetUINT32(uint32_t *s, uint32_t v)
+{
+	*s = v;
+}
+
+WEAK void settingsIncUINT16(uint16_t *s, uint16_t v)
+{
+	*s += v;
+}
+
+WEAK void settingsDecUINT16(uint16_t *s, uint16_t v)
+{
+	*s -= v;
+}
+
+// Menus and display
+static stringsTable_t hostLanguage = { .all_channels = "All Channels" };
+WEAK const stringsTable_t *currentLanguage = &hostLanguage;
+WEAK int uiPrivateCallState;
+WEAK int uiPrivateCallLastID;
+
+WEAK int menuSystemGetCurrentMenuNumber(void)
+{
+	return UI_CHANNEL_MODE;
+}
+
+WEAK bool uiVFOModeIsScanning(void)
+{
+	return false;
+}
+
+WEAK void ucClearRows(int16_t startRow, int16_t endRow, bool isInverted)
+{
+}
+
+WEAK void ucFillRect(int16_t x, int16_t y, int16_t width, int16_t height, bool isInverted)
+{
+}
+
+WEAK void ucPrintAt(uint8_t x, uint8_t y, const char *text, ucFont_t fontSize)
+{
+}
+
+WEAK void ucPrintCentered(uint8_t y, const char *text, ucFont_t fontSize)
+{
+}
+
+WEAK int ucPrintCore(int16_t x, int16_t y, const char *szMsg, ucFont_t fontSize, ucTextAlign_t alignment, bool isInverted)
+{
+	return 0;
+}
+
+// Voice prompts
+WEAK void voicePromptsInit(void)
+{
+}
+
+WEAK void voicePromptsAppendPrompt(uint8_t prompt)
+{
+}
+
+WEAK void voicePromptsAppendString(char *promptString)
+{
+}
+
+WEAK void voicePromptsAppendInteger(int32_t value)
+{
+}
+
+WEAK void voicePromptsAppendLanguageString(const char * const *languageStringAdd)
+{
+}
+
+WEAK void voicePromptsPlay(void)
+{
+}
+
+WEAK void voicePromptsTerminate(void)
+{
+}
+
+WEAK bool voicePromptsIsPlaying(void)
+{
+	return false;
+}
+
+// Call log
+WEAK void callLogCallHeard(uint32_t id, uint32_t talkGroupOrPcId)
+{
+}
+
+WEAK int callLogGetNumRecords(void)
+{
+	return 0;
+}
+
+WEAK bool callLogReadRecord(int index, callLogRecord_t *record)
+{
+	return false;
+}
+
+// Operating time, which only counts this power cycle here
+WEAK uint32_t fw_operatingSeconds(void)
+{
+	return hostMillis / 1000;
+}
+
+// newlib has itoa(), glibc doesn't
+WEAK char *itoa(int value, char *str, int base)
+{
+	sprintf(str, ((base == 16) ? "%x" : "%d"), value);
+
+	return str;
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Measures the EEPROM bytes written by settingsSaveSettings() for each kind of change made in the menus,
+ * through the real settings.c, and checks after every save that the newest slot holds exactly what is in RAM,
+ * so a change which was not marked as dirty shows up as a failure.
+ *
+ * Before the settings were split into slots with dirty ranges, every save wrote the whole settingsStruct_t.
+ */
+#include <string.h>
+#include "hostStubs.h"
+#include "mockEEPROM.h"
+#include <settings.h>
+#include <codeplug.h>
+#include <functions/flashStore.h>
+#include <sound.h>
+#include <trx.h>
+#include <voicePrompts.h>
+#include <user_interface/uiLocalisation.h>
+
+#define SETTINGS_ADDRESS    0x6000
+#define SETTINGS_SLOT_SIZE  0x80
+#define NUM_ZONES           12
+
+// Everything else settings.c uses
+const int MELODY_KEY_BEEP[] = { 0, 0 };
+int soundBeepVolumeDivider;
+uint32_t trxDMRID;
+bool voicePromptDataIsLoaded = false;
+const stringsTable_t languages[1];
+const stringsTable_t *currentLanguage = &languages[0];
+
+int codeplugGetUserDMRID(void)
+{
+	return 5053238;
+}
+
+void codeplugGetVFO_ChannelData(struct_codeplugChannel_t *vfoBuf, int VFONumber)
+{
+	memset(vfoBuf, 0, sizeof(struct_codeplugChannel_t));
+}
+
+void codeplugSetVFO_ChannelData(struct_codeplugChannel_t *vfoBuf, int VFONumber)
+{
+}
+
+void codeplugInitChannelsPerZone(void)
+{
+}
+
+bool SPI_Flash_eraseSector(uint32_t address)
+{
+	return true;
+}
+
+// The VFOs are only saved to the Flash store on the RD-5R, see settingsVFOStoreTest
+int flashStoreRead(int key, uint8_t *buf, int bufSize)
+{
+	return -1;
+}
+
+bool flashStoreDelete(int key)
+{
+	return true;
+}
+
+// Copied from menuSystem.c, which has too many dependencies to link here
+static void menuSystemMenuIncrement(int32_t *currentItem, int32_t numItems)
+{
+	*currentItem = (*currentItem + 1) % numItems;
+}
+
+static uint32_t saves;
+
+// Saves as settingsSaveIfNeeded() does, counting the saves for the comparison with the old code
+static bool save(void)
+{
+	saves++;
+	return settingsSaveSettings(false);
+}
+
+// The newest valid slot in the EEPROM must match the settings in RAM
+static bool savedSettingsMatch(void)
+{
+	uint8_t *image = mockEEPROMGetImage();
+	int newest = -1;
+	uint16_t newestSequence = 0;
+
+	for (int slot = 0; slot < 2; slot++)
+	{
+		uint8_t *slotData = &image[SETTINGS_ADDRESS + (slot * SETTINGS_SLOT_SIZE)];
+		uint16_t sequence;
+
+		memcpy(&sequence, slotData + sizeof(settingsStruct_t), sizeof(uint16_t));
+		if ((((settingsStruct_t *)slotData)->magicNumber == nonVolatileSettings.magicNumber) &&
+				((newest < 0) || ((int16_t)(sequence - newestSequence) > 0)))
+		{
+			newest = slot;
+			newestSequence = sequence;
+		}
+	}
+
+	return (newest >= 0) &&
+			(memcmp(&image[SETTINGS_ADDRESS + (newest * SETTINGS_SLOT_SIZE)], &nonVolatileSettings, sizeof(settingsStruct_t)) == 0);
+}
+
+// Options menu: the user changes a value and confirms
+static void changeKeypadTimer(void)
+{
+	settingsIncrement(nonVolatileSettings.keypadTimerLong, 1);
+}
+
+// Sound options menu: the user changes the mic gain and the beep volume, which is saved part way through, then cancels
+static void cancelSoundOptions(void)
+{
+	settingsStruct_t originalNonVolatileSettings;
+
+	memcpy(&originalNonVolatileSettings, &nonVolatileSettings, sizeof(settingsStruct_t));
+	settingsIncrement(nonVolatileSettings.micGainDMR, 1);
+	settingsIncrement(nonVolatileSettings.beepVolumeDivider, 1);
+	save();// As the RD-5R does, after 500 ms
+	settingsRestoreFromCopy(&originalNonVolatileSettings);
+}
+
+// Display options menu: contrast changed then cancelled, restored field by field as menuDisplayOptions.c does
+static void cancelDisplayContrast(void)
+{
+	int8_t originalContrast = nonVolatileSettings.displayContrast;
+
+	settingsIncrement(nonVolatileSettings.displayContrast, 2);
+	save();
+	settingsSet(nonVolatileSettings.displayContrast, originalContrast);
+}
+
+// GD77S zone change, as in uiChannelMode.c
+static void nextZoneGD77S(void)
+{
+	int32_t zone = nonVolatileSettings.currentZone;
+
+	menuSystemMenuIncrement(&zone, NUM_ZONES);
+	settingsSet(nonVolatileSettings.currentZone, (int16_t)zone);
+	settingsSet(nonVolatileSettings.overrideTG, 0);
+	settingsSet(nonVolatileSettings.currentChannelIndexInZone, -2);
+}
+
+// Channel screen: the user steps to the next channel
+static void nextChannel(void)
+{
+	settingsIncrement(nonVolatileSettings.currentChannelIndexInZone, 1);
+}
+
+// VFO screen: swap from VFO A to B
+static void swapVFO(void)
+{
+	settingsSet(nonVolatileSettings.currentVFONumber, 1 - nonVolatileSettings.currentVFONumber);
+}
+
+// The CC/TS filter, last in the struct
+static void changeCcTsFilter(void)
+{
+	settingsSet(nonVolatileSettings.dmrCcTsFilter, (nonVolatileSettings.dmrCcTsFilter + 1) % NUM_DMR_CCTS_FILTER_LEVELS);
+}
+
+// Nothing changed, e.g. a menu opened and left with the green key
+static void noChange(void)
+{
+}
+
+typedef struct
+{
+	const char *name;
+	void (*change)(void);
+} menuChange_t;
+
+static const menuChange_t changes[] =
+{
+	{ "Keypad long press timer",     changeKeypadTimer },
+	{ "Sound options, cancelled",    cancelSoundOptions },
+	{ "Display contrast, cancelled", cancelDisplayContrast },
+	{ "GD77S next zone",             nextZoneGD77S },
+	{ "Next channel",                nextChannel },
+	{ "Swap VFO",                    swapVFO },
+	{ "CC/TS filter",                changeCcTsFilter },
+	{ "No change",                   noChange }
+};
+
+#define NUM_CHANGES        (sizeof(changes) / sizeof(changes[0]))
+#define REPEATS_PER_CHANGE 4// Each slot gets written at least twice
+
+int main(int argc, char **argv)
+{
+	settingsStruct_t beforeReload;
+	uint32_t totalBytes = 0;
+	uint32_t totalOldBytes = 0;
+
+	settingsLoadSettings();// Blank EEPROM, so the defaults are restored and saved
+	save();// Bring the other slot up to date too
+	HOST_CHECK(savedSettingsMatch());
+
+	printf("%-28s %14s %14s %12s\n", "Menu change", "Bytes written", "Old bytes", "Page writes");
+
+	for (int c = 0; c < NUM_CHANGES; c++)
+	{
+		mockEEPROMResetStats();
+		saves = 0;
+
+		for (int r = 0; r < REPEATS_PER_CHANGE; r++)
+		{
+			changes[c].change();
+			HOST_CHECK(save());
+			HOST_CHECK(savedSettingsMatch());
+		}
+
+		// Each save writes at most the whole struct and its 4 byte trailer
+		HOST_CHECK(mockEEPROMStats.bytesWritten <= (saves * (sizeof(settingsStruct_t) + sizeof(uint32_t))));
+
+		printf("%-28s %14.1f %14.1f %12.1f\n", changes[c].name, (double)mockEEPROMStats.bytesWritten / REPEATS_PER_CHANGE,
+				(double)(saves * sizeof(settingsStruct_t)) / REPEATS_PER_CHANGE, (double)mockEEPROMStats.pageWrites / REPEATS_PER_CHANGE);
+
+		totalBytes += mockEEPROMStats.bytesWritten;
+		totalOldBytes += saves * sizeof(settingsStruct_t);
+
+		// Write only the end of each slot, so a change that was never marked as dirty is left behind in one of them
+		for (int slot = 0; slot < 2; slot++)
+		{
+			changeCcTsFilter();
+			HOST_CHECK(save());
+			HOST_CHECK(savedSettingsMatch());
+		}
+	}
+
+	printf("%-28s %14.1f %14.1f\n", "Average", (double)totalBytes / (NUM_CHANGES * REPEATS_PER_CHANGE),
+			(double)totalOldBytes / (NUM_CHANGES * REPEATS_PER_CHANGE));
+
+	// Once both slots have caught up, saving with nothing changed writes nothing
+	HOST_CHECK(save());
+	mockEEPROMResetStats();
+	HOST_CHECK(save());
+	HOST_CHECK(mockEEPROMStats.bytesWritten == 0);
+
+	// And the settings must survive a reboot
+	memcpy(&beforeReload, &nonVolatileSettings, sizeof(settingsStruct_t));
+	memset(&nonVolatileSettings, 0, sizeof(settingsStruct_t));
+	HOST_CHECK(settingsLoadSettings() == false);
+	HOST_CHECK(memcmp(&beforeReload, &nonVolatileSettings, sizeof(settingsStruct_t)) == 0);
+
+	return hostTestResult("settingsTest");
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The VFOs on the RD-5R, which can't save its settings when it is turned off, so it saves them 500 ms after
+ * every change. They go to the Flash store rather than to the codeplug EEPROM page, which used to be rewritten
+ * with both VFOs on every frequency step.
+ *
+ * Runs the real settings.c, codeplug.c and flashStore.c on the simulated Flash and EEPROM, built for the RD-5R.
+ * Checks that tuning writes nothing to the EEPROM, and that the store erases its two sectors in turn.
+ * Then cuts the power at every program and erase of a tuning session, and checks that the VFO is the last
+ * one saved, or the one being saved, after the reboot.
+ * Finally checks that the codeplug copy is used again after it has been written, by the firmware or the CPS.
+ */
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include "mockEEPROM.h"
+#include <settings.h>
+#include <codeplug.h>
+#include <sound.h>
+#include <trx.h>
+#include <voicePrompts.h>
+#include <functions/flashStore.h>
+#include <user_interface/uiLocalisation.h>
+
+#define NUM_WEAR_STEPS        100000
+#define NUM_POWER_CUT_STEPS   150// Two compactions of the store
+#define FIRST_FREQUENCY       14400000// 144.000 MHz
+#define STEP_FREQUENCY        1250// 12.5 kHz
+
+// Everything else settings.c uses
+const int MELODY_KEY_BEEP[] = { 0, 0 };
+int soundBeepVolumeDivider;
+uint32_t trxDMRID;
+bool voicePromptDataIsLoaded = false;
+const stringsTable_t languages[1];
+const stringsTable_t *currentLanguage = &languages[0];
+
+static uint32_t storeSectorErases[FLASH_STORE_NUM_SECTORS];
+static uint32_t otherErases;
+static jmp_buf powerCutRestart;
+
+bool __real_SPI_Flash_eraseSector(uint32_t address);
+
+bool __wrap_SPI_Flash_eraseSector(uint32_t address)
+{
+	if ((address >= FLASH_STORE_BASE_ADDRESS) && (address < (FLASH_STORE_BASE_ADDRESS + (FLASH_STORE_NUM_SECTORS * 4096))))
+	{
+		storeSectorErases[(address - FLASH_STORE_BASE_ADDRESS) / 4096]++;
+	}
+	else
+	{
+		otherErases++;
+	}
+
+	return __real_SPI_Flash_eraseSector(address);
+}
+
+static uint32_t stepFrequency(int step)
+{
+	return FIRST_FREQUENCY + ((step % 4000) * STEP_FREQUENCY);// 144 - 194 MHz
+}
+
+// As main.c does
+static void boot(void)
+{
+	settingsLoadSettings();
+	HOST_CHECK(flashStoreInit());
+	settingsLoadFlashStoreVFOs();
+}
+
+// A frequency step on the VFO screen, saved 500 ms later
+static void tune(int vfo, uint32_t frequency)
+{
+	settingsVFOChannel[vfo].rxFreq = frequency;
+	settingsVFOChannel[vfo].txFreq = frequency;
+	settingsSetVFODirty();
+	hostAdvanceMillis(600);
+	settingsSaveIfNeeded(false);
+}
+
+static void blankMemories(void)
+{
+	mockFlashErase();
+	memset(mockEEPROMGetImage(), 0xFF, MOCK_EEPROM_SIZE);
+	memset(storeSectorErases, 0, sizeof(storeSectorErases));
+	otherErases = 0;
+}
+
+static void measureWear(void)
+{
+	uint32_t erases;
+
+	blankMemories();
+	boot();
+	tune(CHANNEL_VFO_B, FIRST_FREQUENCY);
+	mockEEPROMResetStats();
+	memset(&flashStoreStats, 0, sizeof(flashStoreStats));
+
+	for (int step = 0; step < NUM_WEAR_STEPS; step++)
+	{
+		tune(CHANNEL_VFO_A, stepFrequency(step));
+		flashStoreTick();
+	}
+
+	erases = storeSectorErases[0] + storeSectorErases[1];
+	HOST_CHECK(mockEEPROMStats.bytesWritten == 0);
+	HOST_CHECK(otherErases == 0);
+	HOST_CHECK(erases > 0);
+	// Both sectors take their turn
+	HOST_CHECK(((storeSectorErases[0] > storeSectorErases[1]) ? (storeSectorErases[0] - storeSectorErases[1]) : (storeSectorErases[1] - storeSectorErases[0])) <= 1);
+
+	printf("%d frequency steps: %u Flash store records, %u erases (%u and %u), %.1f steps per erase\n", NUM_WEAR_STEPS,
+			flashStoreStats.recordsWritten, erases, storeSectorErases[0], storeSectorErases[1], (double)NUM_WEAR_STEPS / erases);
+	printf("Before, each step wrote %d bytes of EEPROM to the same page\n", (int)(2 * sizeof(struct_codeplugChannel_t)));
+
+	// The VFOs survive a reboot
+	boot();
+	HOST_CHECK(settingsVFOChannel[CHANNEL_VFO_A].rxFreq == stepFrequency(NUM_WEAR_STEPS - 1));
+	HOST_CHECK(settingsVFOChannel[CHANNEL_VFO_B].rxFreq == FIRST_FREQUENCY);
+}
+
+// Runs the tuning session with the power cut during the given program or erase. Returns the number of programs and erases made.
+static int replay(int cutAt)
+{
+	volatile int step = 0;
+	volatile uint32_t saved = FIRST_FREQUENCY;
+	int writeOperations;
+
+	blankMemories();
+	boot();
+	tune(CHANNEL_VFO_A, FIRST_FREQUENCY);
+	writeOperations = -mockFlashGetWriteOperations();
+	mockFlashSetPowerCut(cutAt, &powerCutRestart);
+
+	if (setjmp(powerCutRestart) != 0)
+	{
+		// Power restored
+		boot();
+		if (settingsVFOChannel[CHANNEL_VFO_A].rxFreq != saved)
+		{
+			HOST_CHECK(settingsVFOChannel[CHANNEL_VFO_A].rxFreq == stepFrequency(step));
+			saved = stepFrequency(step);
+			step++;
+		}
+		HOST_CHECK(settingsVFOChannel[CHANNEL_VFO_A].txFreq == saved);
+	}
+
+	while (step < NUM_POWER_CUT_STEPS)
+	{
+		tune(CHANNEL_VFO_A, stepFrequency(step));
+		saved = stepFrequency(step);
+		step++;
+		flashStoreTick();
+	}
+
+	mockFlashSetPowerCut(0, NULL);
+	writeOperations += mockFlashGetWriteOperations();
+
+	boot();
+	HOST_CHECK(settingsVFOChannel[CHANNEL_VFO_A].rxFreq == stepFrequency(NUM_POWER_CUT_STEPS - 1));
+
+	return writeOperations;
+}
+
+static void checkCodeplugCopy(void)
+{
+	struct_codeplugChannel_t vfo;
+	uint8_t record[FLASH_STORE_MAX_RECORD_LENGTH];
+
+	blankMemories();
+	boot();
+	tune(CHANNEL_VFO_A, FIRST_FREQUENCY);
+	tune(CHANNEL_VFO_A, FIRST_FREQUENCY + STEP_FREQUENCY);
+
+	// The CPS asks for the VFOs, or SK1 + SK2: they are written to the codeplug, and the store copy is dropped
+	HOST_CHECK(settingsSaveSettings(true));
+	codeplugGetVFO_ChannelData(&vfo, CHANNEL_VFO_A);
+	HOST_CHECK(vfo.rxFreq == (FIRST_FREQUENCY + STEP_FREQUENCY));
+	HOST_CHECK(flashStoreRead(FLASH_STORE_KEY_VFO_A, record, sizeof(record)) < 0);
+	boot();
+	HOST_CHECK(settingsVFOChannel[CHANNEL_VFO_A].rxFreq == (FIRST_FREQUENCY + STEP_FREQUENCY));
+
+	// The CPS writes a new VFO to the codeplug after the radio has saved a newer one to the store, then reboots the radio
+	tune(CHANNEL_VFO_A, FIRST_FREQUENCY + (2 * STEP_FREQUENCY));
+	vfo.rxFreq = vfo.txFreq = 43912500;
+	codeplugSetVFO_ChannelData(&vfo, CHANNEL_VFO_A);
+	settingsDiscardFlashStoreVFOs();
+	boot();
+	HOST_CHECK(settingsVFOChannel[CHANNEL_VFO_A].rxFreq == 43912500);
+}
+
+int main(int argc, char **argv)
+{
+	int writeOperations;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "settingsVFOStoreTest.img") == false)
+	{
+		return 1;
+	}
+
+	measureWear();
+
+	writeOperations = replay(0);
+	mockFlashResetStats();
+	for (int cutAt = 1; cutAt <= writeOperations; cutAt++)
+	{
+		replay(cutAt);
+	}
+	printf("%d power cuts during %d frequency steps\n", mockFlashStats.powerCuts, NUM_POWER_CUT_STEPS);
+	HOST_CHECK(mockFlashStats.powerCuts == writeOperations);
+
+	checkCodeplugCopy();
+
+	mockFlashClose();
+
+	return hostTestResult("settingsVFOStoreTest");
+}
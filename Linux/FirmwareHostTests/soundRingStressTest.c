@@ -0,0 +1,215 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Runs the wave buffer ring from sound.h with a producer and a consumer thread, as the codec task and the
+ * SAI callbacks use it. Every buffer is filled with its sequence number, and the consumer checks each one it
+ * takes: the sequence must follow on, and all of the buffer must hold it, which fails if the producer
+ * overwrote a buffer before the consumer was done with it. The count must never go over the ring size.
+ * Both ring sizes are tested, with the producer either waiting for space, or dropping the buffer when the
+ * ring is full as the hotspot does. The last run leaves the hotspot as hotspotExit() does, and checks that
+ * the ring then only uses the WAV_BUFFER_COUNT wave buffers.
+ *
+ * Usage: soundRingStressTest
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "fsl_device_registers.h"
+
+// The CMSIS __DMB() is an ARM instruction. This is the same barrier for the host CPU.
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#include <sound.h>
+
+#define BUFFERS_PER_RUN 2000000
+
+soundRing_t wavbufferRing;
+union sharedDataBuffer audioAndHotspotDataBuffer;
+
+typedef struct
+{
+	int bufferCount;// The buffers in the array of the mode
+	int bufferSize;
+	bool dropWhenFull;
+	uint32_t produced;
+	uint32_t dropped;
+	volatile bool producerDone;
+} stressRun_t;
+
+// The sequence number, then a pattern made from it
+static void fillBuffer(volatile uint8_t *buffer, int size, uint32_t sequence)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		buffer[i] = sequence >> (i * 8);
+	}
+	for (int i = 4; i < size; i++)
+	{
+		buffer[i] = sequence + i;
+	}
+}
+
+static uint32_t bufferSequence(const uint8_t *buffer)
+{
+	return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static bool bufferIsWhole(const uint8_t *buffer, int size)
+{
+	uint32_t sequence = bufferSequence(buffer);
+
+	for (int i = 4; i < size; i++)
+	{
+		if (buffer[i] != (uint8_t)(sequence + i))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static volatile uint8_t *ringBuffer(stressRun_t *run, int index)
+{
+	HOST_CHECK(index < run->bufferCount);
+	if (index >= run->bufferCount)
+	{
+		index = 0;// Past the end of the array, as the firmware would write
+	}
+
+	return &audioAndHotspotDataBuffer.rawBuffer[index * run->bufferSize];
+}
+
+static void *producer(void *arg)
+{
+	stressRun_t *run = (stressRun_t *)arg;
+	uint32_t sequence = 0;
+
+	while (run->produced < BUFFERS_PER_RUN)
+	{
+		if (soundRingCount() >= wavbufferRing.size)
+		{
+			if (run->dropWhenFull)
+			{
+				run->dropped++;
+				run->produced++;
+				sequence++;
+			}
+			sched_yield();
+			continue;
+		}
+
+		fillBuffer(ringBuffer(run, soundRingWriteBuffer()), run->bufferSize, sequence);
+		soundRingAdvanceWrite();
+		run->produced++;
+		sequence++;
+	}
+	run->producerDone = true;
+
+	return NULL;
+}
+
+// Returns the number of buffers taken
+static uint32_t consumer(stressRun_t *run)
+{
+	uint8_t copy[WAV_BUFFER_SIZE];
+	uint32_t expected = 0;
+	uint32_t taken = 0;
+	uint32_t sequence;
+	int count;
+
+	while (true)
+	{
+		count = soundRingCount();
+		HOST_CHECK((count >= 0) && (count <= wavbufferRing.size));
+
+		if (count == 0)
+		{
+			if (run->producerDone && (soundRingCount() == 0))
+			{
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+
+		memcpy(copy, (const uint8_t *)ringBuffer(run, soundRingReadBuffer()), run->bufferSize);
+		sequence = bufferSequence(copy);
+
+		HOST_CHECK(bufferIsWhole(copy, run->bufferSize));
+		if (run->dropWhenFull)
+		{
+			HOST_CHECK(sequence >= expected);// Dropped buffers leave gaps
+		}
+		else
+		{
+			HOST_CHECK(sequence == expected);
+		}
+		expected = sequence + 1;
+
+		soundRingAdvanceRead();
+		taken++;
+	}
+
+	return taken;
+}
+
+// The ring must have been reset for the mode
+static void stress(int bufferCount, int bufferSize, bool dropWhenFull)
+{
+	stressRun_t run = { .bufferCount = bufferCount, .bufferSize = bufferSize, .dropWhenFull = dropWhenFull };
+	pthread_t producerThread;
+	uint32_t taken;
+	double start;
+
+	start = hostSeconds();
+	pthread_create(&producerThread, NULL, producer, &run);
+	taken = consumer(&run);
+	pthread_join(producerThread, NULL);
+
+	HOST_CHECK((taken + run.dropped) == BUFFERS_PER_RUN);
+	if (dropWhenFull == false)
+	{
+		HOST_CHECK(run.dropped == 0);
+	}
+
+	printf("%2d buffers of %3d bytes, %-16s %8u taken %8u dropped %6.2f s\n", wavbufferRing.size, bufferSize,
+			(dropWhenFull ? "drop when full" : "wait when full"), taken, run.dropped, hostSeconds() - start);
+}
+
+int main(int argc, char **argv)
+{
+	soundRingReset(WAV_BUFFER_COUNT);
+	stress(WAV_BUFFER_COUNT, WAV_BUFFER_SIZE, false);
+
+	soundRingReset(HOTSPOT_BUFFER_COUNT);
+	stress(HOTSPOT_BUFFER_COUNT, HOTSPOT_BUFFER_SIZE, false);
+	soundRingReset(HOTSPOT_BUFFER_COUNT);
+	stress(HOTSPOT_BUFFER_COUNT, HOTSPOT_BUFFER_SIZE, true);
+
+	// Stop the hotspot past the last wave buffer, leave it as hotspotExit() does, then receive audio again
+	while (soundRingWriteBuffer() != (HOTSPOT_BUFFER_COUNT - 1))
+	{
+		soundRingAdvanceWrite();
+		soundRingAdvanceRead();
+	}
+	soundRingReset(WAV_BUFFER_COUNT);
+	stress(WAV_BUFFER_COUNT, WAV_BUFFER_SIZE, false);
+
+	return hostTestResult("soundRingStressTest");
+}
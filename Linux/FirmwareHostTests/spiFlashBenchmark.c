@@ -0,0 +1,151 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Read throughput of SPI_Flash.c on the mock transport, for the bit-bang and block transfer backends.
+ *
+ * Usage: spiFlashBenchmark [image file]
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+
+#define DMRID_AREA_START     0x30000
+#define DMRID_AREA_END       0xE0000
+#define DMRID_RECORD_SIZE    12
+#define AMBE_FRAME_SIZE      27
+#define VOICE_PROMPT_START   0xE0000
+#define VOICE_PROMPT_LENGTH  (64 * 1024)
+
+typedef void (*workloadFunction_t)(uint8_t *image);
+
+typedef struct
+{
+	const char *name;
+	workloadFunction_t run;
+} workload_t;
+
+static uint8_t readBuf[4096];
+
+static void workloadIdLookups(uint8_t *image)
+{
+	srand(1);
+	for (int i = 0; i < 20000; i++)
+	{
+		uint32_t address = DMRID_AREA_START + ((rand() % ((DMRID_AREA_END - DMRID_AREA_START) / DMRID_RECORD_SIZE)) * DMRID_RECORD_SIZE);
+
+		SPI_Flash_read(address, readBuf, DMRID_RECORD_SIZE);
+		HOST_CHECK(memcmp(readBuf, &image[address], DMRID_RECORD_SIZE) == 0);
+	}
+}
+
+static void workloadPromptFrames(uint8_t *image)
+{
+	for (uint32_t address = VOICE_PROMPT_START; (address + AMBE_FRAME_SIZE) <= (VOICE_PROMPT_START + VOICE_PROMPT_LENGTH); address += AMBE_FRAME_SIZE)
+	{
+		SPI_Flash_read(address, readBuf, AMBE_FRAME_SIZE);
+		HOST_CHECK(memcmp(readBuf, &image[address], AMBE_FRAME_SIZE) == 0);
+	}
+}
+
+static void workloadPromptStream(uint8_t *image)
+{
+	spiFlashStream_t stream;
+
+	SPI_Flash_streamOpen(&stream, VOICE_PROMPT_START, true);
+	for (uint32_t address = VOICE_PROMPT_START; (address + AMBE_FRAME_SIZE) <= (VOICE_PROMPT_START + VOICE_PROMPT_LENGTH); address += AMBE_FRAME_SIZE)
+	{
+		SPI_Flash_streamRead(&stream, readBuf, AMBE_FRAME_SIZE);
+		HOST_CHECK(memcmp(readBuf, &image[address], AMBE_FRAME_SIZE) == 0);
+	}
+	SPI_Flash_streamClose(&stream);
+}
+
+static void workloadSectorReads(uint8_t *image)
+{
+	for (uint32_t address = 0; address < MOCK_FLASH_SIZE; address += 4096)
+	{
+		SPI_Flash_read(address, readBuf, 4096);
+		HOST_CHECK(memcmp(readBuf, &image[address], 4096) == 0);
+	}
+}
+
+static const workload_t workloads[] =
+{
+	{ "DMR ID lookups, 20000 x 12 bytes", workloadIdLookups },
+	{ "Voice prompt, 27 byte reads", workloadPromptFrames },
+	{ "Voice prompt, prefetch stream", workloadPromptStream },
+	{ "CPS sector reads, 256 x 4K", workloadSectorReads }
+};
+
+int main(int argc, char **argv)
+{
+	const mockFlashBusModel_t *busModels[] = { &MOCK_FLASH_BUS_BITBANG, &MOCK_FLASH_BUS_BLOCK };
+	uint8_t *image;
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "spiFlashBenchmark.img") == false)
+	{
+		return 1;
+	}
+
+	image = mockFlashGetImage();
+	srand(12345);
+	for (int i = 0; i < MOCK_FLASH_SIZE; i++)
+	{
+		image[i] = rand();
+	}
+
+	printf("Simulated bus time assumes %d ns per GPIO register access\n\n", MOCK_FLASH_NS_PER_GPIO_ACCESS);
+	printf("%-34s %-9s %8s %10s %10s %12s %10s %9s\n", "Workload", "Backend", "Commands", "Bytes out", "Bytes in", "Bus time ms", "KB/s", "Host ms");
+
+	for (int w = 0; w < (sizeof(workloads) / sizeof(workloads[0])); w++)
+	{
+		uint64_t bitbangTimeNs = 0;
+
+		for (int b = 0; b < (sizeof(busModels) / sizeof(busModels[0])); b++)
+		{
+			double startTime;
+			double hostMs;
+
+			mockFlashSetBusModel(busModels[b]);
+			mockFlashResetStats();
+			startTime = hostSeconds();
+			workloads[w].run(image);
+			hostMs = (hostSeconds() - startTime) * 1000.0;
+
+			printf("%-34s %-9s %8llu %10llu %10llu %12.1f %10.1f %9.1f", workloads[w].name, busModels[b]->name,
+					(unsigned long long)mockFlashStats.selects, (unsigned long long)mockFlashStats.bytesOut, (unsigned long long)mockFlashStats.bytesIn,
+					mockFlashStats.busTimeNs / 1e6, (mockFlashStats.bytesIn / 1024.0) / (mockFlashStats.busTimeNs / 1e9), hostMs);
+
+			if (b == 0)
+			{
+				bitbangTimeNs = mockFlashStats.busTimeNs;
+				printf("\n");
+			}
+			else
+			{
+				printf("  x%.2f\n", (double)bitbangTimeNs / mockFlashStats.busTimeNs);
+			}
+		}
+	}
+
+	mockFlashClose();
+
+	return hostTestResult("spiFlashBenchmark");
+}
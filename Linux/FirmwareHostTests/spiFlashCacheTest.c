@@ -0,0 +1,239 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Counts the Flash sector erases for a scripted session of contact and channel edits made on the radio,
+ * through the real codeplug.c functions and the SPI_Flash.c write cache, and checks that the Flash ends up
+ * holding exactly what was written.
+ *
+ * The old SPI_Flash_write() erased every sector it touched on every call, so that count is worked out from
+ * the calls made, which are caught with the linker's --wrap option.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "hostStubs.h"
+#include "mockFlash.h"
+#include "mockEEPROM.h"
+#include <codeplug.h>
+#include <user_interface/uiLocalisation.h>
+
+#define CONTACTS_ADDRESS      0x87620
+#define CONTACTS_IN_USE       200
+#define CHANNELS_FLASH_START  0x7B1C0
+#define CONTACT_DATA_SIZE     24
+#define CHANNEL_DATA_SIZE     56
+#define EDIT_INTERVAL_MS      1500// Time spent in the menus between two saves
+
+static stringsTable_t hostLanguage = { .all_channels = "All Channels" };
+const stringsTable_t *currentLanguage = &hostLanguage;
+
+static uint8_t *expectedImage;// What the Flash should hold once the cache has been flushed
+static uint32_t oldWriteErases;
+
+bool __real_SPI_Flash_write(uint32_t addr, uint8_t *dataBuf, int size);
+
+bool __wrap_SPI_Flash_write(uint32_t addr, uint8_t *dataBuf, int size)
+{
+	oldWriteErases += ((addr + size - 1) / 4096) - (addr / 4096) + 1;
+	memcpy(&expectedImage[addr], dataBuf, size);
+
+	return __real_SPI_Flash_write(addr, dataBuf, size);
+}
+
+static void editPause(void)
+{
+	hostAdvanceMillis(EDIT_INTERVAL_MS);
+	SPI_Flash_cacheTick();
+}
+
+static void editContact(int index, const char *name, uint32_t tg)
+{
+	struct_codeplugContact_t contact;
+	uint8_t readBack[sizeof(contact.name)];
+
+	codeplugContactGetDataForIndex(index, &contact);
+	memset(contact.name, 0xFF, sizeof(contact.name));
+	memcpy(contact.name, name, strlen(name));
+	contact.tgNumber = tg;
+	contact.callType = CONTACT_CALLTYPE_TG;
+	HOST_CHECK(codeplugContactSaveDataForIndex(index, &contact));
+
+	// Reads must see the new data while it is still only in the cache
+	SPI_Flash_read(CONTACTS_ADDRESS + ((index - 1) * CONTACT_DATA_SIZE), readBack, sizeof(readBack));
+	HOST_CHECK(memcmp(readBack, contact.name, sizeof(readBack)) == 0);
+
+	editPause();
+}
+
+static void editChannel(int index, const char *name)
+{
+	struct_codeplugChannel_t channel;
+
+	codeplugChannelGetDataForIndex(index, &channel);
+	memset(channel.name, 0xFF, sizeof(channel.name));
+	memcpy(channel.name, name, strlen(name));
+	HOST_CHECK(codeplugChannelSaveDataForIndex(index, &channel));
+	codeplugChannelIndexSetValid(index);
+
+	editPause();
+}
+
+static void fillCodeplug(uint8_t *image)
+{
+	struct_codeplugContact_t contact;
+
+	for (int i = 0; i < CONTACTS_IN_USE; i++)
+	{
+		memset(&contact, 0xFF, sizeof(contact));
+		snprintf(contact.name, sizeof(contact.name), "Contact %d", i + 1);
+		contact.tgNumber = 0x00100000 + i;// BCD, byte swapped
+		contact.callType = CONTACT_CALLTYPE_TG;
+		memcpy(&image[CONTACTS_ADDRESS + (i * CONTACT_DATA_SIZE)], &contact, CONTACT_DATA_SIZE);
+	}
+
+	// Channels 129 to 256, all valid
+	memset(&image[CHANNELS_FLASH_START - 16], 0xFF, 16);
+	for (int i = 0; i < 128; i++)
+	{
+		uint8_t *channel = &image[CHANNELS_FLASH_START + (i * CHANNEL_DATA_SIZE)];
+
+		memset(channel, 0x00, CHANNEL_DATA_SIZE);
+		snprintf((char *)channel, 16, "Channel %d", i + 129);
+	}
+}
+
+typedef struct
+{
+	const char *name;
+	void (*run)(void);
+	uint32_t maxErases;// with the cache
+} editPhase_t;
+
+static void phaseEditContacts(void)
+{
+	for (int i = 1; i <= 12; i++)
+	{
+		char name[16];
+
+		snprintf(name, sizeof(name), "Edited %d", i);
+		editContact(i, name, 2000 + i);
+	}
+}
+
+static void phaseAddContacts(void)
+{
+	// Unused slots are blank, so adding contacts only clears bits
+	for (int i = CONTACTS_IN_USE + 1; i <= (CONTACTS_IN_USE + 8); i++)
+	{
+		editContact(i, "New contact", 3000 + i);
+	}
+}
+
+static void phaseStraddlingContact(void)
+{
+	// Contact 106 starts 8 bytes before the end of a sector
+	for (int i = 0; i < 4; i++)
+	{
+		editContact(106, ((i & 1) ? "Odd" : "Even"), 4000 + i);
+	}
+}
+
+static void phaseEditChannels(void)
+{
+	static const int channels[] = { 130, 131, 131, 140, 150, 151, 200, 130 };
+
+	for (int i = 0; i < (sizeof(channels) / sizeof(channels[0])); i++)
+	{
+		char name[16];
+
+		snprintf(name, sizeof(name), "Ch %d.%d", channels[i], i);
+		editChannel(channels[i], name);
+	}
+}
+
+static void phaseSlowEdits(void)
+{
+	// Long enough between edits for the cache tick to write each one back, so the cache can't save anything here
+	for (int i = 0; i < 3; i++)
+	{
+		editContact(20, ((i & 1) ? "Slow odd" : "Slow even"), 5000 + i);
+		hostAdvanceMillis(SPI_FLASH_CACHE_FLUSH_DELAY_MS + 1);
+		SPI_Flash_cacheTick();
+	}
+}
+
+static const editPhase_t phases[] =
+{
+	{ "Edit 12 contacts",                 phaseEditContacts,      1 },
+	{ "Add 8 contacts",                   phaseAddContacts,       0 },
+	{ "Edit a contact across 2 sectors",  phaseStraddlingContact, 8 },// With one slot, each sector flushes the other, as the old code did
+	{ "Edit 8 Flash channels",            phaseEditChannels,      3 },// sector 0x7B goes idle while channel 200 is edited
+	{ "Edit a contact 3 times, slowly",   phaseSlowEdits,         3 }
+};
+
+int main(int argc, char **argv)
+{
+	uint32_t totalOldErases = 0;
+	uint32_t totalErases = 0;
+	uint8_t cpsSector[4096];
+
+	if (mockFlashOpen((argc > 1) ? argv[1] : "spiFlashCacheTest.img") == false)
+	{
+		return 1;
+	}
+
+	mockFlashErase();
+	fillCodeplug(mockFlashGetImage());
+	expectedImage = malloc(MOCK_FLASH_SIZE);
+	memcpy(expectedImage, mockFlashGetImage(), MOCK_FLASH_SIZE);
+
+	codeplugInitContactsCache();
+	codeplugInitChannelsValidCache();
+
+	// The CPS buffer must never be touched by the cache
+	for (int i = 0; i < sizeof(cpsSector); i++)
+	{
+		cpsSector[i] = SPI_Flash_sectorbuffer[i] = i * 7;
+	}
+
+	printf("%-34s %10s %12s %14s\n", "Phase", "Old erases", "Cache erases", "Pages written");
+
+	for (int p = 0; p < (sizeof(phases) / sizeof(phases[0])); p++)
+	{
+		oldWriteErases = 0;
+		mockFlashResetStats();
+
+		phases[p].run();
+		HOST_CHECK(SPI_Flash_flushCache());
+
+		printf("%-34s %10u %12u %14u\n", phases[p].name, oldWriteErases, mockFlashStats.sectorErases, mockFlashStats.pagePrograms);
+		HOST_CHECK(mockFlashStats.sectorErases <= phases[p].maxErases);
+		HOST_CHECK(memcmp(mockFlashGetImage(), expectedImage, MOCK_FLASH_SIZE) == 0);
+
+		totalOldErases += oldWriteErases;
+		totalErases += mockFlashStats.sectorErases;
+	}
+
+	printf("%-34s %10u %12u\n", "Total", totalOldErases, totalErases);
+	HOST_CHECK(memcmp(SPI_Flash_sectorbuffer, cpsSector, sizeof(cpsSector)) == 0);
+
+	free(expectedImage);
+	mockFlashClose();
+
+	return hostTestResult("spiFlashCacheTest");
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _FW_CALL_LOG_H_
+#define _FW_CALL_LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Log of the received DMR calls, kept across power cycles.
+ *
+ * Finished calls are held in RAM and appended to a ring of Flash sectors in batches, from the main loop,
+ * while the radio is not receiving or transmitting. When the newest sector is full, the sector holding the
+ * oldest calls is erased and reused. The log is replayed into the last heard list at boot, and the CPS can read
+ * the whole log, oldest call first.
+ *
+ * The sectors are in the part of the Flash which the CPS never writes, see the Flash map in SPI_Flash.h.
+ * Nothing else uses 0x2A000 - 0x2DFFF: the flash store starts at 0x2E000, and the CPS's custom data ends at 0x10000.
+ */
+#define CALL_LOG_BASE_ADDRESS         0x2A000// four sectors, just below the flash store
+#define CALL_LOG_NUM_SECTORS          4
+#define CALL_LOG_RAM_TAIL_SIZE        8// calls waiting to be written
+#define CALL_LOG_FLUSH_RECORDS        6// write once this many calls are waiting
+#define CALL_LOG_FLUSH_DELAY_MS       (5 * 60 * 1000)// or once the oldest one has waited this long
+#define CALL_LOG_CALL_END_MS          1500// no LC for this long ends the call
+
+typedef struct
+{
+	uint8_t  marker;// CALL_LOG_RECORD_MARKER, 0xFF if the slot is unused
+	uint8_t  crc;// crc8 of the rest of the record
+	uint16_t duration;// seconds
+	uint32_t sequence;
+	uint32_t id;
+	uint32_t talkGroupOrPcId;// call type in the top byte, as in LinkItem_t
+	uint32_t operatingTime;// fw_operatingSeconds() when the call ended, so its age is known after a power cycle
+	char     locator[7];
+	uint8_t  reserved[5];
+} callLogRecord_t;// 32 bytes, the CPS transfer size
+
+bool callLogInit(void);
+void callLogCallHeard(uint32_t id, uint32_t talkGroupOrPcId);
+void callLogTick(void);
+bool callLogFlush(void);
+int callLogGetNumRecords(void);
+bool callLogReadRecord(int index, callLogRecord_t *record);// index 0 is the oldest call. Returns false if the record is corrupt
+
+#endif
@@ -29,9 +29,14 @@ extern const int VFO_FREQ_STEP_TABLE[8];
 #define CODEPLUG_CONTACTS_MIN        1
 #define CODEPLUG_CONTACTS_MAX        1024
 
+#define CODEPLUG_CHANNELS_MIN        1
+#define CODEPLUG_CHANNELS_MAX        1024
+
 #define CODEPLUG_DTMF_CONTACTS_MIN   1
 #define CODEPLUG_DTMF_CONTACTS_MAX   32
 
+#define CODEPLUG_CHANNEL_CACHE_SIZE  24// A 16 channel zone, plus some neighbours
+
 #define CODEPLUG_CSS_NONE            0xFFFF
 #define CODEPLUG_DCS_FLAGS_MASK      0xC000
 #define CODEPLUG_DCS_INVERTED_MASK   0x4000
@@ -109,6 +114,14 @@ typedef struct
 	uint8_t    code[16];
 } struct_codeplugDTMFContact_t;
 
+typedef struct
+{
+	uint32_t hits;
+	uint32_t misses;
+} codeplugChannelCacheStats_t;
+
+extern codeplugChannelCacheStats_t codeplugChannelCacheStats;
+
 typedef enum
 {
 	CODEPLUG_CUSTOM_DATA_TYPE_NONE = 0,
@@ -124,7 +137,11 @@ void codeplugZoneSetSelected(int selectedZone,int selectedChannel);
  */
 int codeplugZonesGetCount(void);
 void codeplugZoneGetDataForNumber(int indexNum,struct_codeplugZone_t *returnBuf);
+void codeplugZoneGetNameForNumber(int zoneNum, char *nameBuf);
+void codeplugInitZonesCache(void);
+void codeplugZonesCacheInvalidate(void);
 void codeplugChannelGetDataForIndex(int index, struct_codeplugChannel_t *channelBuf);
+void codeplugChannelGetDataForScan(int index, struct_codeplugChannel_t *channelBuf);
 void codeplugUtilConvertBufToString(char *codeplugBuf,char *outBuf,int len);
 void codeplugUtilConvertStringToBuf(char *inBuf,char *outBuf,int len);
 uint32_t byteSwap32(uint32_t n);
@@ -148,7 +165,14 @@ void codeplugGetVFO_ChannelData(struct_codeplugChannel_t *vfoBuf,int VFONumber);
 void codeplugSetVFO_ChannelData(struct_codeplugChannel_t *vfoBuf,int VFONumber);
 bool codeplugChannelIndexIsValid(int index);
 void codeplugChannelIndexSetValid(int index);
+int codeplugChannelGetNextValidIndex(int index, int direction);
+int codeplugChannelGetFirstValidIndex(void);
+int codeplugChannelGetLastValidIndex(void);
+void codeplugInitChannelsValidCache(void);
+void codeplugChannelsValidCacheInvalidate(void);
 bool codeplugChannelSaveDataForIndex(int index, struct_codeplugChannel_t *channelBuf);
+void codeplugChannelCacheInvalidate(void);
+void codeplugCachesInvalidate(void);
 bool codeplugChannelToneIsCTCSS(uint16_t tone);
 bool codeplugChannelToneIsDCS(uint16_t tone);
 
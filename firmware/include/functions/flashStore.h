@@ -0,0 +1,62 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _FW_FLASH_STORE_H_
+#define _FW_FLASH_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Small key/value store for data which changes at run time.
+ *
+ * Records are appended to one of two reserved Flash sectors, so updating a value never erases anything.
+ * When the active sector gets full of stale records, the live records are copied to the other sector,
+ * which then becomes the active one, and the old sector is erased. Both sectors therefore get the same wear.
+ * The RAM index (key -> record offset) is rebuilt by scanning the active sector at boot.
+ */
+#define FLASH_STORE_BASE_ADDRESS        0x2E000// two sectors, just below the DMR ID database. See the Flash map in SPI_Flash.h
+#define FLASH_STORE_NUM_SECTORS         2
+#define FLASH_STORE_MAX_KEYS            32
+#define FLASH_STORE_MAX_RECORD_LENGTH   64
+
+typedef enum
+{
+	FLASH_STORE_KEY_RESERVED = 0,
+	FLASH_STORE_KEY_OPERATING_TIME,// uint32_t seconds, see fw_operatingTimeTick()
+	FLASH_STORE_KEY_VFO_A,// struct_codeplugChannel_t, newer than the codeplug copy, see settingsSaveIfNeeded()
+	FLASH_STORE_KEY_VFO_B,
+	// Add new keys here, never renumber existing ones
+} flashStoreKey_t;
+
+typedef struct
+{
+	uint32_t recordsWritten;
+	uint32_t compactions;
+} flashStoreStats_t;
+
+extern flashStoreStats_t flashStoreStats;
+
+bool flashStoreInit(void);
+int flashStoreRead(int key, uint8_t *buf, int bufSize);// returns the record length, or -1 if the key has no record
+bool flashStoreWrite(int key, const uint8_t *data, int length);
+bool flashStoreDelete(int key);
+bool flashStoreCompact(void);
+void flashStoreTick(void);
+
+#endif
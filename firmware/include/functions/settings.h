@@ -227,6 +227,7 @@ void settingsDecUINT32(uint32_t *s, uint32_t v);
 #endif
 
 void settingsSetDirty(void);
+void settingsRestoreFromCopy(const settingsStruct_t *original);
 void settingsSetVFODirty(void);
 void settingsSaveIfNeeded(bool immediately);
 bool settingsSaveSettings(bool includeVFOs);
@@ -234,6 +235,8 @@ bool settingsLoadSettings(void);
 void settingsRestoreDefaultSettings(void);
 void settingsEraseCustomContent(void);
 void settingsInitVFOChannel(int vfoNumber);
+void settingsLoadFlashStoreVFOs(void);
+void settingsDiscardFlashStoreVFOs(void);
 bool settingsPlatformSpecificSaveSettings(bool includeVFOs);
 void enableVoicePromptsIfLoaded(void);
 
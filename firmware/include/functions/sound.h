@@ -55,11 +55,82 @@ extern union sharedDataBuffer
 	volatile uint8_t rawBuffer[HOTSPOT_BUFFER_COUNT * HOTSPOT_BUFFER_SIZE];
 } audioAndHotspotDataBuffer;
 
-extern volatile int wavbuffer_read_idx;
-extern volatile int wavbuffer_write_idx;
-extern volatile int wavbuffer_count;
+/*
+ * The wave buffers, and the hotspot buffers which share their memory, are used as a single producer, single consumer ring.
+ * Only the producer moves writeIdx and only the consumer moves readIdx, so there is no shared count to keep in step
+ * and neither side has to disable interrupts. The indices count up to twice the number of buffers, so that a full ring
+ * can be told apart from an empty one.
+ *
+ * Mode                     Producer                                Consumer
+ * DMR RX and voice prompts codec task, soundStoreBuffer()          SAI TX callback, soundSendData(). Started by soundTickRXBuffer()
+ *                                                                  while no transfer is running
+ * DMR TX                   SAI RX callback, soundReceiveData()     codec task, soundRetrieveBuffer()
+ * Hotspot TX               USB frames from MMDVMHost               HR-C6000 tick, copying each frame for the timeslot ISR
+ * CPS AMBE encoding        CPS_ACCESS_WAV_BUFFER writes            CPS_COMPRESS_AND_ACCESS_AMBE_BUFFER reads
+ *
+ * soundRingReset() and soundRingDiscard() must only be called while the consumer isn't running.
+ */
+typedef struct
+{
+	volatile int writeIdx;
+	volatile int readIdx;
+	int size;// WAV_BUFFER_COUNT, or HOTSPOT_BUFFER_COUNT in hotspot mode
+} soundRing_t;
+
+extern soundRing_t wavbufferRing;
 extern uint8_t *currentWaveBuffer;
 
+static inline int soundRingCount(void)
+{
+	int count = wavbufferRing.writeIdx - wavbufferRing.readIdx;
+
+	return ((count < 0) ? (count + (2 * wavbufferRing.size)) : count);
+}
+
+// The buffer the producer fills next
+static inline int soundRingWriteBuffer(void)
+{
+	return ((wavbufferRing.writeIdx >= wavbufferRing.size) ? (wavbufferRing.writeIdx - wavbufferRing.size) : wavbufferRing.writeIdx);
+}
+
+// The oldest filled buffer
+static inline int soundRingReadBuffer(void)
+{
+	return ((wavbufferRing.readIdx >= wavbufferRing.size) ? (wavbufferRing.readIdx - wavbufferRing.size) : wavbufferRing.readIdx);
+}
+
+// Producer only, once the buffer has been filled
+static inline void soundRingAdvanceWrite(void)
+{
+	int idx = wavbufferRing.writeIdx + 1;
+
+	__DMB();// The buffer contents must be visible before the index
+	wavbufferRing.writeIdx = ((idx == (2 * wavbufferRing.size)) ? 0 : idx);
+}
+
+// Consumer only, once the buffer has been used
+static inline void soundRingAdvanceRead(void)
+{
+	int idx = wavbufferRing.readIdx + 1;
+
+	__DMB();
+	wavbufferRing.readIdx = ((idx == (2 * wavbufferRing.size)) ? 0 : idx);
+}
+
+// Drop all the filled buffers
+static inline void soundRingDiscard(void)
+{
+	wavbufferRing.readIdx = wavbufferRing.writeIdx;
+}
+
+// Empty the ring and set its size for the mode: WAV_BUFFER_COUNT, or HOTSPOT_BUFFER_COUNT
+static inline void soundRingReset(int size)
+{
+	wavbufferRing.size = size;
+	wavbufferRing.readIdx = 0;
+	wavbufferRing.writeIdx = 0;
+}
+
 extern uint8_t spi_sound1[WAV_BUFFER_SIZE*2];
 extern uint8_t spi_sound2[WAV_BUFFER_SIZE*2];
 extern uint8_t spi_sound3[WAV_BUFFER_SIZE*2];
@@ -80,9 +151,21 @@ void soundReceiveData(void);
 void soundStoreBuffer(void);
 void soundRetrieveBuffer(void);
 void soundTickRXBuffer(void);
+void soundRXFrameDecoded(void);
+void soundTickRXPlayout(void);
 void soundSetupBuffer(void);
 void soundTickMelody(void);
 
+typedef struct
+{
+	uint32_t delayMs;// current playout delay
+	uint32_t jitterMs;// smoothed arrival jitter of the decoded DMR frames
+	uint32_t underruns;// times the buffer ran dry during an over
+	uint32_t concealedBuffers;
+} soundPlayoutStats_t;
+
+extern soundPlayoutStats_t soundPlayoutStats;
+
 
 //bit masks to track amp usage
 #define AUDIO_AMP_MODE_NONE 	0B00000000
@@ -19,12 +19,16 @@
 #define _FW_TICKS_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 
 #include "FreeRTOS.h"
 #include "task.h"
 
 uint32_t fw_millis(void);
+void fw_operatingTimeInit(void);
+void fw_operatingTimeTick(bool forceSave);
+uint32_t fw_operatingSeconds(void);// Total time the radio has been switched on, over all power cycles
 
 
 #endif /* _FW_TICKS_H_ */
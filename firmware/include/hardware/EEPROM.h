@@ -25,6 +25,17 @@
 #include <stdbool.h>
 
 bool EEPROM_Read(int address,uint8_t *buf, int size);
-bool EEPROM_Write(int address,uint8_t *buf, int size);
+bool EEPROM_Write(int address,uint8_t *buf, int size);// queued, see EEPROM_Flush()
+void EEPROM_Tick(void);
+bool EEPROM_Flush(void);
+bool EEPROM_IsWritePending(void);
+
+typedef struct
+{
+	uint32_t writeFailures;// queued page writes which failed, they are retried by EEPROM_Tick()
+	uint32_t pagesDropped;// pages which still failed after the retries, or when written by EEPROM_Flush()
+} eepromStats_t;
+
+extern eepromStats_t eepromStats;
 
 #endif /* _EEPROM_H_ */
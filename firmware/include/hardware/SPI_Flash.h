@@ -24,16 +24,95 @@
 #include <stdbool.h>
 
 
+/*
+ * Flash map
+ *   0x00000 - 0x0FFFF  OpenGD77 custom data (boot image and melody), and the copy of the calibration data at 0xF000.
+ *                      codeplugGetOpenGD77CustomData() stops at 0x10000.
+ *   0x10000 - 0x29FFF  Unused
+ *   0x2A000 - 0x2DFFF  Call log, see callLog.h
+ *   0x2E000 - 0x2FFFF  Flash store, see flashStore.h
+ *   0x30000 - 0x7AFFF  DMR ID database (the CPS writes it from here). It must end below the codeplug.
+ *   0x7B000 - 0x8FFFF  Codeplug channels, contacts and TG lists
+ *   0xE0000 -          Voice prompts
+ * The CPS never writes to 0x10000 - 0x2FFFF, so the firmware can keep its own data there.
+ */
 extern uint8_t SPI_Flash_sectorbuffer[4096];
 
+#define SPI_FLASH_CACHE_NUM_SLOTS         1 // each slot costs 4k of RAM
+#define SPI_FLASH_CACHE_FLUSH_DELAY_MS 2000
+
+typedef struct
+{
+	int      sector;// sector number + 1. 0 = slot not in use
+	bool     dirty;
+	uint32_t dirtyTime;
+	uint32_t lastUsed;
+} spiFlashCacheSlot_t;
+
+typedef struct
+{
+	uint32_t sectorErases;
+	uint32_t pageWrites;
+} spiFlashStats_t;
+
+extern spiFlashStats_t SPI_Flash_stats;
+
+/*
+ * The flash is accessed through a transport, which is only responsible for moving bytes on the bus.
+ * All the command handling is done in SPI_Flash.c, so an alternative transport (e.g. a host side mock
+ * backed by a file image) only has to implement these four functions.
+ */
+typedef struct
+{
+	void (*select)(void);// assert CS
+	void (*deselect)(void);// release CS
+	void (*writeBuf)(const uint8_t *buf, int size);// clock out bytes, ignoring MISO
+	void (*readBuf)(uint8_t *buf, int size);// clock in bytes, with MOSI held low
+} spiFlashTransport_t;
+
+extern const spiFlashTransport_t SPI_FLASH_TRANSPORT_BITBANG;// Original one byte at a time transfer
+extern const spiFlashTransport_t SPI_FLASH_TRANSPORT_BLOCK;// Unrolled block transfer (default)
+
+/*
+ * Sequential reader.
+ * The stream keeps CS asserted between calls and carries on clocking data out of the same FAST_READ command,
+ * so consecutive reads do not resend the command and address.
+ * If any other flash command is issued while a stream is open, the stream is suspended and transparently
+ * restarted at the correct address on its next read.
+ * With prefetch enabled, data is read ahead in two half windows, so small reads (e.g. one 27 byte AMBE frame)
+ * are normally served from RAM.
+ */
+#define SPI_FLASH_STREAM_HALF_WINDOW_SIZE 32
+
+typedef struct
+{
+	uint32_t busAddress;// flash address of the next byte which will be clocked in from the device
+	bool     prefetch;
+	uint8_t  windowReadPos;
+	uint8_t  windowCount;// number of prefetched bytes not yet consumed
+	uint8_t  window[2 * SPI_FLASH_STREAM_HALF_WINDOW_SIZE];
+} spiFlashStream_t;
+
 // Public functions
 bool SPI_Flash_init(void);
 bool SPI_Flash_read(uint32_t addrress,uint8_t *buf,int size);
 bool SPI_Flash_write(uint32_t addr, uint8_t *dataBuf, int size);
 bool SPI_Flash_writePage(uint32_t address,uint8_t *dataBuf);// page is 256 bytes
 bool SPI_Flash_eraseSector(uint32_t address);// sector is 16 pages  = 4k bytes
+bool SPI_Flash_program(uint32_t addr, const uint8_t *dataBuf, int size);// no erase, bits can only be cleared
 int SPI_Flash_readManufacturer(void);// Not necessarily Winbond !
 int SPI_Flash_readPartID(void);// Should be 4014 for 1M or 4017 for 8M
 int SPI_Flash_readStatusRegister(void);// May come in handy
+bool SPI_Flash_flushCache(void);// Write all pending changes to the Flash. Must be called before power off or reboot
+bool SPI_Flash_cacheIsDirty(void);
+void SPI_Flash_cacheTick(void);
+void SPI_Flash_setTransport(const spiFlashTransport_t *transport);
+const spiFlashTransport_t *SPI_Flash_getTransport(void);
+
+void SPI_Flash_streamOpen(spiFlashStream_t *stream, uint32_t address, bool prefetch);
+bool SPI_Flash_streamRead(spiFlashStream_t *stream, uint8_t *buf, int size);
+void SPI_Flash_streamSeek(spiFlashStream_t *stream, uint32_t address);
+uint32_t SPI_Flash_streamGetPosition(spiFlashStream_t *stream);
+void SPI_Flash_streamClose(spiFlashStream_t *stream);
 
 #endif /* _SPI_FLASH_H_ */
@@ -22,7 +22,9 @@
 
 
 #define MAX_ZONE_SCAN_NUISANCE_CHANNELS       16
-#define NUM_LASTHEARD_STORED                  32
+#if !defined(NUM_LASTHEARD_STORED)
+#define NUM_LASTHEARD_STORED                  32// Can be set for the build, up to 254. Each item takes sizeof(LinkItem_t), 108 bytes
+#endif
 
 #define QSO_TIMER_TIMEOUT                   2400
 
@@ -99,18 +101,50 @@ typedef struct dmrIdDataStruct
 	char text[20];
 } dmrIdDataStruct_t;
 
-#define MIN_ENTRIES_BEFORE_USING_SLICES 40 // Minimal number of available IDs before using slices stuff
-#define ID_SLICES 14 // Number of slices in whole DMRIDs DB
+// The RAM index holds every indexStride'th ID of the DMR ID database, as 24 bit binary values.
+// The stride is the smallest one which fits the database in DMRID_INDEX_MAX_ENTRIES, so a database
+// of up to DMRID_INDEX_MAX_ENTRIES IDs is fully indexed, and a lookup only reads the record text from the Flash.
+#define DMRID_INDEX_MAX_ENTRIES 1024 // RAM cost is 3 bytes per entry
+#define DMRID_CALLSIGN_MAX_LENGTH 8 // Callsigns in the optional callsign index of the compressed format
+#define DMRID_BLOOM_FILTER_MAX_SIZE 4096 // Largest Bloom filter of the compressed format, in bytes, it is loaded into SPI_Flash_sectorbuffer
+#define DMRID_INTERPOLATION_PROBES 3 // Interpolation search probes before falling back to binary search, 0 = binary search only
+
+typedef enum
+{
+	DMRID_FORMAT_FIXED = 0,// "ID-", fixed length records with BCD IDs
+	DMRID_FORMAT_COMPRESSED// "IDZ", blocks of delta encoded IDs and 6 bit packed text
+} dmrIDsFormat_t;
 
 typedef struct
 {
 	uint32_t entries;
+	uint8_t  format;
 	uint8_t  contactLength;
-	int32_t  slices[ID_SLICES]; // [0] is min availabel ID, [ID_SLICES - 1] is max available ID
-	uint32_t IDsPerSlice;
-
+	uint32_t indexStride;
+	uint32_t indexEntries;
+	uint32_t lastId;// binary, not BCD
+	uint32_t blockSize;// compressed format only
+	uint32_t dataStart;
+	uint32_t callsignIndexStart;
+	int      callsignIndexEntries;// 0 if the database has no callsign index
+	uint32_t bloomFilterBitsMask;
+	uint8_t  bloomFilterNumHashes;// 0 if the database has no Bloom filter, or it has been released
+	uint8_t  *bloomFilter;
+	uint8_t  index[DMRID_INDEX_MAX_ENTRIES * 3];
 } dmrIDsCache_t;
 
+// Recently resolved IDs, from either the DMR ID database or the codeplug contacts, including IDs which were not found
+#define DMRID_LOOKUP_CACHE_SIZE 32
+#define DISPLAY_NAME_CACHE_SIZE 16
+
+typedef struct
+{
+	uint32_t hits;
+	uint32_t misses;
+} dmrIDLookupCacheStats_t;
+
+extern dmrIDLookupCacheStats_t dmrIDLookupCacheStats;
+
 typedef struct LinkItem
 {
     struct LinkItem *prev;
@@ -121,6 +155,8 @@ typedef struct LinkItem
     char 		talkerAlias[32];// 4 blocks of data. 6 bytes + 7 bytes + 7 bytes + 7 bytes . plus 1 for termination some more for safety.
     char 		locator[7];
     uint32_t	time;// current system time when this station was heard
+    uint16_t	callCount;// calls in the call log
+    uint32_t	airtime;// seconds
     struct LinkItem *next;
 } LinkItem_t;
 
@@ -181,10 +217,17 @@ int32_t getFirstSpacePos(char *str);
 void dmrIDCacheInit(void);
 bool dmrIDLookup(int targetId, dmrIdDataStruct_t *foundRecord);
 bool contactIDLookup(uint32_t id, int calltype, char *buffer);
+void dmrIDLookupCacheInvalidate(void);
+bool dmrIDBloomFilterRelease(void);
+void displayNameCacheInvalidate(void);
+bool dmrIDCallsignIndexAvailable(void);
+int dmrIDCallsignFind(const char *prefix);
+bool dmrIDCallsignGetEntry(int position, const char *prefix, char *callsign, uint32_t *id);
 void menuUtilityRenderQSOData(void);
 void menuUtilityRenderHeader(void);
 LinkItem_t *lastheardFindInList(uint32_t id);
 void lastheardInitList(void);
+void lastheardRestoreFromCallLog(void);
 bool lastHeardListUpdate(uint8_t *dmrDataBuffer, bool forceOnHotspot);
 void lastHeardClearLastID(void);
 void drawRSSIBarGraph(void);
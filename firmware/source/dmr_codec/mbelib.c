@@ -19,11 +19,8 @@
 
 #include <dmr_codec/mbelib.h>
 
-const int golayGenerator[12] = {
-  0x63a, 0x31d, 0x7b4, 0x3da, 0x1ed, 0x6cc, 0x366, 0x1b3, 0x6e3, 0x54b, 0x49f, 0x475
-};
-
-const int golayMatrix[2048] = {
+// Error pattern of the 12 data bits for each syndrome
+static const uint16_t golayMatrix[2048] = {
   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 72, 0, 0, 0, 0, 0, 0, 0, 2084, 0, 0, 0, 769, 0, 1024, 144,
   2, 0, 0, 0, 0, 0, 0, 0, 72, 0, 0, 0, 72, 0, 72, 72, 72, 0, 0, 0, 16, 0, 1, 1538, 384, 0, 134, 2048, 1056, 288,
   2576, 5, 72, 0, 0, 0, 0, 0, 0, 0, 1280, 0, 0, 0, 4, 0, 546, 144, 2049, 0, 0, 0, 66, 0, 1, 144, 520, 0, 2056, 144,
@@ -95,228 +92,104 @@ const int golayMatrix[2048] = {
   34, 256, 34, 512, 34, 1032, 80
 };
 
-/*
- * DMR AMBE interleave schedule
- */
-
-const int rW[36] = {
-  0, 1, 0, 1, 0, 1,
-  0, 1, 0, 1, 0, 1,
-  0, 1, 0, 1, 0, 1,
-  0, 1, 0, 1, 0, 2,
-  0, 2, 0, 2, 0, 2,
-  0, 2, 0, 2, 0, 2
-};
-
-const int rX[36] = {
-  23, 10, 22, 9, 21, 8,
-  20, 7, 19, 6, 18, 5,
-  17, 4, 16, 3, 15, 2,
-  14, 1, 13, 0, 12, 10,
-  11, 9, 10, 8, 9, 7,
-  8, 6, 7, 5, 6, 4
+// Golay(23,12) parity of the upper and lower 6 data bits
+static const uint16_t golayParityHigh[64] = {
+	0x000, 0x6cc, 0x1ed, 0x721, 0x3da, 0x516, 0x237, 0x4fb, 0x7b4, 0x178, 0x659, 0x095, 0x46e, 0x2a2, 0x583, 0x34f,
+	0x31d, 0x5d1, 0x2f0, 0x43c, 0x0c7, 0x60b, 0x12a, 0x7e6, 0x4a9, 0x265, 0x544, 0x388, 0x773, 0x1bf, 0x69e, 0x052,
+	0x63a, 0x0f6, 0x7d7, 0x11b, 0x5e0, 0x32c, 0x40d, 0x2c1, 0x18e, 0x742, 0x063, 0x6af, 0x254, 0x498, 0x3b9, 0x575,
+	0x527, 0x3eb, 0x4ca, 0x206, 0x6fd, 0x031, 0x710, 0x1dc, 0x293, 0x45f, 0x37e, 0x5b2, 0x149, 0x785, 0x0a4, 0x668
 };
 
-const int rY[36] = {
-  0, 2, 0, 2, 0, 2,
-  0, 2, 0, 3, 0, 3,
-  1, 3, 1, 3, 1, 3,
-  1, 3, 1, 3, 1, 3,
-  1, 3, 1, 3, 1, 3,
-  1, 3, 1, 3, 1, 3
+static const uint16_t golayParityLow[64] = {
+	0x000, 0x475, 0x49f, 0x0ea, 0x54b, 0x13e, 0x1d4, 0x5a1, 0x6e3, 0x296, 0x27c, 0x609, 0x3a8, 0x7dd, 0x737, 0x342,
+	0x1b3, 0x5c6, 0x52c, 0x159, 0x4f8, 0x08d, 0x067, 0x412, 0x750, 0x325, 0x3cf, 0x7ba, 0x21b, 0x66e, 0x684, 0x2f1,
+	0x366, 0x713, 0x7f9, 0x38c, 0x62d, 0x258, 0x2b2, 0x6c7, 0x585, 0x1f0, 0x11a, 0x56f, 0x0ce, 0x4bb, 0x451, 0x024,
+	0x2d5, 0x6a0, 0x64a, 0x23f, 0x79e, 0x3eb, 0x301, 0x774, 0x436, 0x043, 0x0a9, 0x4dc, 0x17d, 0x508, 0x5e2, 0x197
 };
 
-const int rZ[36] = {
-  5, 3, 4, 2, 3, 1,
-  2, 0, 1, 13, 0, 12,
-  22, 11, 21, 10, 20, 9,
-  19, 8, 18, 7, 17, 6,
-  16, 5, 15, 4, 14, 3,
-  13, 2, 12, 1, 11, 0
+/*
+ * DMR AMBE interleave schedule.
+ * For each of the 72 bits of the frame, in transmission order, the codeword (top 3 bits) and the bit in that codeword (lower 5 bits).
+ * The codewords are held with ambe_fr[n] bit i being bit i of codeword Cn.
+ */
+static const uint8_t ambeDeinterleave[72] = {
+	0x17, 0x05, 0x2a, 0x43, 0x16, 0x04, 0x29, 0x42,
+	0x15, 0x03, 0x28, 0x41, 0x14, 0x02, 0x27, 0x40,
+	0x13, 0x01, 0x26, 0x6d, 0x12, 0x00, 0x25, 0x6c,
+	0x11, 0x36, 0x24, 0x6b, 0x10, 0x35, 0x23, 0x6a,
+	0x0f, 0x34, 0x22, 0x69, 0x0e, 0x33, 0x21, 0x68,
+	0x0d, 0x32, 0x20, 0x67, 0x0c, 0x31, 0x4a, 0x66,
+	0x0b, 0x30, 0x49, 0x65, 0x0a, 0x2f, 0x48, 0x64,
+	0x09, 0x2e, 0x47, 0x63, 0x08, 0x2d, 0x46, 0x62,
+	0x07, 0x2c, 0x45, 0x61, 0x06, 0x2b, 0x44, 0x60
 };
 
-void mbe_checkGolayBlock(long int *block)
-{
-	static int i, syndrome, eccexpected, eccbits, databits;
-	long int mask, block_l;
-
-	block_l = *block;
-
-	mask = 0x400000l;
-	eccexpected = 0;
-	for (i = 0; i < 12; i++)
-	{
-		if ((block_l & mask) != 0l)
-		{
-			eccexpected ^= golayGenerator[i];
-		}
-		mask = mask >> 1;
-	}
-	eccbits = (int) (block_l & 0x7ffl);
-	syndrome = eccexpected ^ eccbits;
-
-	databits = (int) (block_l >> 11);
-	databits = databits ^ golayMatrix[syndrome];
-
-	*block = (long) databits;
-}
-
-int mbe_golay2312(char *in, char *out)
-{
-	int i, errs;
-	long block;
-
-	block = 0;
-	for (i = 22; i >= 0; i--)
-	{
-		block = block << 1;
-		block = block + in[i];
-	}
-
-	mbe_checkGolayBlock(&block);
-
-	for (i = 22; i >= 11; i--)
-	{
-		out[i] = (block & 2048) >> 11;
-		block = block << 1;
-	}
-	for (i = 10; i >= 0; i--)
-	{
-		out[i] = in[i];
-	}
-
-	errs = 0;
-	for (i = 22; i >= 11; i--)
-	{
-		if (out[i] != in[i])
-		{
-			errs++;
-		}
-	}
-	return (errs);
-}
-
-int mbe_eccAmbe3600x2450C0(char ambe_fr[4][24])
+// Returns the 12 corrected data bits of the 23 bit codeword
+static uint32_t mbe_golay2312(uint32_t block, int *errs)
 {
-	int j, errs;
-	char in[23], out[23];
+	uint32_t databits = (block >> 11) & 0xFFF;
+	uint32_t syndrome = golayParityHigh[databits >> 6] ^ golayParityLow[databits & 0x3F] ^ (block & 0x7FF);
+	uint32_t errorPattern = golayMatrix[syndrome];
 
-	for (j = 0; j < 23; j++)
-	{
-		in[j] = ambe_fr[0][j + 1];
-	}
-	errs = mbe_golay2312(in, out);
-	// ambe_fr[0][0] should be the C0 golay24 parity bit.
-	// TODO: actually test that here...
-	for (j = 0; j < 23; j++)
-	{
-		ambe_fr[0][j + 1] = out[j];
-	}
+	*errs = __builtin_popcount(errorPattern);
 
-	return (errs);
+	return (databits ^ errorPattern);
 }
 
-int mbe_eccAmbe3600x2450Data(char ambe_fr[4][24], char *ambe_d)
+// The pseudo-random sequence which C1 is modulated with, seeded from the C0 data bits
+static uint32_t mbe_ambe3600x2450PN(uint32_t seed)
 {
-	int j, errs;
-	char *ambe, gin[24], gout[24];
-
-	ambe = ambe_d;
-	// just copy C0
-	for (j = 23; j > 11; j--)
-	{
-		*ambe = ambe_fr[0][j];
-		ambe++;
-	}
+	uint32_t pr = 16 * seed;
+	uint32_t mask = 0;
 
-	// ecc and copy C1
-	for (j = 0; j < 23; j++)
-	{
-		gin[j] = ambe_fr[1][j];
-	}
-	errs = mbe_golay2312(gin, gout);
-	for (j = 22; j > 10; j--)
+	for (int i = 22; i >= 0; i--)
 	{
-		*ambe = gout[j];
-		ambe++;
+		pr = ((173 * pr) + 13849) & 0xFFFF;
+		mask |= (pr >> 15) << i;
 	}
 
-	// just copy C2
-	for (j = 10; j >= 0; j--)
-	{
-		*ambe = ambe_fr[2][j];
-		ambe++;
-	}
-
-	// just copy C3
-	for (j = 13; j >= 0; j--)
-	{
-		*ambe = ambe_fr[3][j];
-		ambe++;
-	}
-
-	return (errs);
+	return mask;
 }
 
-void mbe_demodulateAmbe3600x2450Data(char ambe_fr[4][24])
+// Copies the bits of the codeword into ambe_d one bit per char, most significant bit first
+static char *mbe_unpackBits(char *ambe_d, uint32_t bits, int numBits)
 {
-	int i, j, k;
-	unsigned short pr[115];
-	unsigned short foo = 0;
-
-	// create pseudo-random modulator
-	for (i = 23; i >= 12; i--)
-	{
-		foo <<= 1;
-		foo |= ambe_fr[0][i];
-	}
-	pr[0] = (16 * foo);
-	for (i = 1; i < 24; i++)
+	for (int i = numBits - 1; i >= 0; i--)
 	{
-		pr[i] = (173 * pr[i - 1]) + 13849 - (65536 * (((173 * pr[i - 1]) + 13849) / 65536));
-	}
-	for (i = 1; i < 24; i++)
-	{
-		pr[i] = pr[i] / 32768;
+		*ambe_d++ = (bits >> i) & 1;
 	}
 
-	// demodulate ambe_fr with pr
-	k = 1;
-	for (j = 22; j >= 0; j--)
-	{
-		ambe_fr[1][j] = ((ambe_fr[1][j]) ^ pr[k]);
-		k++;
-	}
+	return ambe_d;
 }
 
 void prepare_framedata(uint8_t *indata, char *ambe_d, int *errs, int *errs2)
 {
-	char ambe_fr[4][24];
-	int *w, *x, *y, *z;
-	uint8_t rampos = 0;
+	uint32_t ambe_fr[4] = { 0, 0, 0, 0 };
+	uint32_t c0Data, c1Data;
+	int c1Errs;
 
-	w = (int*)rW;
-	x = (int*)rX;
-	y = (int*)rY;
-	z = (int*)rZ;
-	for (int i = 0; i < 9; i++)
+	for (int i = 0; i < 72; i += 8)
 	{
-		for (int j = 0; j < 4; j++)
+		uint32_t bits = *indata++;
+		const uint8_t *deinterleave = &ambeDeinterleave[i];
+
+		for (int j = 7; j >= 0; j--)
 		{
-			ambe_fr[*w][*x] = (indata[rampos]>>(7-(2*j))) & 1;
-			ambe_fr[*y][*z] = (indata[rampos]>>(7-(2*j+1))) & 1;
-			w++;
-			x++;
-			y++;
-			z++;
+			ambe_fr[*deinterleave >> 5] |= ((bits >> j) & 1) << (*deinterleave & 0x1F);
+			deinterleave++;
 		}
-		rampos++;
 	}
 
-	*errs = 0;
-	*errs2 = 0;
-	*errs = mbe_eccAmbe3600x2450C0(ambe_fr);
-	mbe_demodulateAmbe3600x2450Data(ambe_fr);
-	*errs2 = *errs;
-	*errs2 += mbe_eccAmbe3600x2450Data(ambe_fr, ambe_d);
+	// C0 is a Golay(24,12) codeword, the parity bit in bit 0 is not checked
+	c0Data = mbe_golay2312(ambe_fr[0] >> 1, errs);
+
+	// C1 is modulated, then Golay(23,12) coded
+	c1Data = mbe_golay2312((ambe_fr[1] ^ mbe_ambe3600x2450PN(c0Data)) & 0x7FFFFF, &c1Errs);
+	*errs2 = *errs + c1Errs;
+
+	// C2 and C3 are not protected
+	ambe_d = mbe_unpackBits(ambe_d, c0Data, 12);
+	ambe_d = mbe_unpackBits(ambe_d, c1Data, 12);
+	ambe_d = mbe_unpackBits(ambe_d, ambe_fr[2], 11);
+	mbe_unpackBits(ambe_d, ambe_fr[3], 14);
 }
@@ -400,7 +400,7 @@ const uint8_t MARKER_BYTES[] = {0xA0 ,0x0F};// ,0x50 ,0x14 ,0xA0 ,0x0F ,0x50 ,0x
 			if (memcmp(MARKER_BYTES, tmp, MARKER_BYTES_LENGTH) == 0)
 			{
 				// found calibration table in variant location.
-				if (SPI_Flash_write(CALIBRATION_BASE, tmp, CALIBRATION_TABLE_LENGTH))
+				if (SPI_Flash_write(CALIBRATION_BASE, tmp, CALIBRATION_TABLE_LENGTH) && SPI_Flash_flushCache())
 				{
 					// Update current calibration data with the calibration data that just been read
 					memcpy(&calibrationData, tmp, CALIBRATION_TABLE_LENGTH);
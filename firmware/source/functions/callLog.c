@@ -0,0 +1,351 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <string.h>
+#include <functions/callLog.h>
+#include <SPI_Flash.h>
+#include <HR-C6000.h>
+#include <trx.h>
+#include <ticks.h>
+#include <hotspot/CRC.h>
+#include <user_interface/uiUtilities.h>
+
+/*
+ * Sector layout:
+ *   32 byte header: magic (2), 0xFFFF (2), sequence number (4), 0xFF padding
+ *   127 records of 32 bytes, written in order. The marker byte is programmed with the rest of the record,
+ *   so the first slot with an erased marker is the end of the log.
+ *
+ * The sectors in use have consecutive sequence numbers, going back from the newest one.
+ */
+#define CALL_LOG_RECORDS_PER_SECTOR  ((4096 / sizeof(callLogRecord_t)) - 1)// the first slot holds the sector header
+
+static const uint32_t CALL_LOG_SECTOR_SIZE = 4096;
+static const uint16_t CALL_LOG_MAGIC = 0x4C43;// "CL"
+static const uint8_t CALL_LOG_RECORD_MARKER = 0x5A;
+
+typedef struct
+{
+	uint16_t magic;
+	uint16_t reserved;
+	uint32_t sequence;
+} callLogSectorHeader_t;
+
+typedef struct
+{
+	uint32_t id;// 0 if there is no call in progress
+	uint32_t talkGroupOrPcId;
+	uint32_t startTime;
+	uint32_t lastHeardTime;
+} callLogCurrentCall_t;
+
+static int callLogNewestSector = -1;
+static int callLogNumSectors;
+static uint32_t callLogSectorSequence;
+static int callLogWriteSlot;// next free record slot in the newest sector
+static uint32_t callLogNextSequence = 1;
+static callLogRecord_t callLogTail[CALL_LOG_RAM_TAIL_SIZE];// Not in RAM2, which is already nearly full
+static int callLogTailCount;
+static uint32_t callLogTailTime;// when the oldest waiting call was added
+static callLogCurrentCall_t callLogCurrentCall;
+
+static uint32_t call_log_sectorAddress(int sector)
+{
+	return CALL_LOG_BASE_ADDRESS + (sector * CALL_LOG_SECTOR_SIZE);
+}
+
+static uint32_t call_log_recordAddress(int sector, int slot)
+{
+	return call_log_sectorAddress(sector) + (slot * sizeof(callLogRecord_t));
+}
+
+// An erase or a program stalls the CPU for milliseconds, which would break up a call being received or sent
+static bool call_log_radioIsBusy(void)
+{
+	return ((slot_state != DMR_STATE_IDLE) || trxTransmissionEnabled);
+}
+
+static uint8_t call_log_recordCRC(callLogRecord_t *record)
+{
+	return CRC_crc8((uint8_t *)record + 2, sizeof(callLogRecord_t) - 2);
+}
+
+// Erase the sector and make it the newest one
+static bool call_log_startSector(int sector, uint32_t sequence)
+{
+	callLogSectorHeader_t header;
+
+	header.magic = CALL_LOG_MAGIC;
+	header.reserved = 0xFFFF;
+	header.sequence = sequence;
+
+	if ((SPI_Flash_eraseSector(call_log_sectorAddress(sector)) == false) ||
+			(SPI_Flash_program(call_log_sectorAddress(sector), (uint8_t *)&header, sizeof(callLogSectorHeader_t)) == false))
+	{
+		return false;
+	}
+
+	callLogNewestSector = sector;
+	callLogSectorSequence = sequence;
+	callLogWriteSlot = 1;
+	if (callLogNumSectors < CALL_LOG_NUM_SECTORS)
+	{
+		callLogNumSectors++;
+	}
+
+	return true;
+}
+
+bool callLogInit(void)
+{
+	callLogSectorHeader_t header[CALL_LOG_NUM_SECTORS];
+	callLogRecord_t record;
+	int low, high;
+
+	callLogNewestSector = -1;
+	callLogNumSectors = 0;
+	callLogTailCount = 0;
+	callLogCurrentCall.id = 0;
+
+	for (int i = 0; i < CALL_LOG_NUM_SECTORS; i++)
+	{
+		SPI_Flash_read(call_log_sectorAddress(i), (uint8_t *)&header[i], sizeof(callLogSectorHeader_t));
+		if ((header[i].magic == CALL_LOG_MAGIC) &&
+				((callLogNewestSector < 0) || ((int32_t)(header[i].sequence - callLogSectorSequence) > 0)))
+		{
+			callLogNewestSector = i;
+			callLogSectorSequence = header[i].sequence;
+		}
+	}
+
+	if (callLogNewestSector < 0)
+	{
+		// First use
+		callLogNextSequence = 1;
+		return call_log_startSector(0, 1);
+	}
+
+	callLogNumSectors = 1;
+	while (callLogNumSectors < CALL_LOG_NUM_SECTORS)
+	{
+		int sector = (callLogNewestSector + CALL_LOG_NUM_SECTORS - callLogNumSectors) % CALL_LOG_NUM_SECTORS;
+
+		if ((header[sector].magic != CALL_LOG_MAGIC) || (header[sector].sequence != (callLogSectorSequence - callLogNumSectors)))
+		{
+			break;
+		}
+		callLogNumSectors++;
+	}
+
+	// Find the end of the log in the newest sector
+	low = 1;
+	high = CALL_LOG_RECORDS_PER_SECTOR + 1;
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		uint8_t marker;
+
+		SPI_Flash_read(call_log_recordAddress(callLogNewestSector, mid), &marker, 1);
+		if (marker != 0xFF)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	callLogWriteSlot = low;
+
+	callLogNextSequence = 1;
+	if (callLogGetNumRecords() > 0)
+	{
+		callLogReadRecord(callLogGetNumRecords() - 1, &record);
+		callLogNextSequence = record.sequence + 1;
+	}
+
+	return true;
+}
+
+int callLogGetNumRecords(void)
+{
+	if (callLogNewestSector < 0)
+	{
+		return callLogTailCount;
+	}
+
+	return ((callLogNumSectors - 1) * CALL_LOG_RECORDS_PER_SECTOR) + (callLogWriteSlot - 1) + callLogTailCount;
+}
+
+bool callLogReadRecord(int index, callLogRecord_t *record)
+{
+	int recordsInFlash = callLogGetNumRecords() - callLogTailCount;
+
+	if ((index < 0) || (index >= (recordsInFlash + callLogTailCount)))
+	{
+		return false;
+	}
+
+	if (index >= recordsInFlash)
+	{
+		memcpy(record, &callLogTail[index - recordsInFlash], sizeof(callLogRecord_t));
+		return true;
+	}
+
+	int oldestSector = (callLogNewestSector + 1 + CALL_LOG_NUM_SECTORS - callLogNumSectors) % CALL_LOG_NUM_SECTORS;
+
+	SPI_Flash_read(call_log_recordAddress((oldestSector + (index / CALL_LOG_RECORDS_PER_SECTOR)) % CALL_LOG_NUM_SECTORS,
+			1 + (index % CALL_LOG_RECORDS_PER_SECTOR)), (uint8_t *)record, sizeof(callLogRecord_t));
+
+	return ((record->marker == CALL_LOG_RECORD_MARKER) && (record->crc == call_log_recordCRC(record)));// Could be torn by a power cut
+}
+
+// Write all the waiting calls to the Flash
+bool callLogFlush(void)
+{
+	int done = 0;
+
+	if (callLogNewestSector < 0)
+	{
+		return false;
+	}
+
+	while (done < callLogTailCount)
+	{
+		int count = callLogTailCount - done;
+		bool ok;
+
+		if (callLogWriteSlot > CALL_LOG_RECORDS_PER_SECTOR)
+		{
+			// Reuse the sector with the oldest calls
+			if (callLogNumSectors == CALL_LOG_NUM_SECTORS)
+			{
+				callLogNumSectors--;
+			}
+
+			if (call_log_startSector((callLogNewestSector + 1) % CALL_LOG_NUM_SECTORS, callLogSectorSequence + 1) == false)
+			{
+				break;
+			}
+		}
+
+		if (count > ((CALL_LOG_RECORDS_PER_SECTOR + 1) - callLogWriteSlot))
+		{
+			count = (CALL_LOG_RECORDS_PER_SECTOR + 1) - callLogWriteSlot;
+		}
+
+		ok = SPI_Flash_program(call_log_recordAddress(callLogNewestSector, callLogWriteSlot), (uint8_t *)&callLogTail[done], count * sizeof(callLogRecord_t));
+		callLogWriteSlot += count;// Skip failed records too, they may be partly programmed
+
+		if (ok == false)
+		{
+			break;
+		}
+		done += count;
+	}
+
+	// Keep anything which couldn't be written for the next try
+	callLogTailCount -= done;
+	memmove(&callLogTail[0], &callLogTail[done], callLogTailCount * sizeof(callLogRecord_t));
+	callLogTailTime = fw_millis();
+
+	return (callLogTailCount == 0);
+}
+
+static void call_log_endCall(void)
+{
+	LinkItem_t *item = lastheardFindInList(callLogCurrentCall.id);
+	uint32_t duration = ((callLogCurrentCall.lastHeardTime - callLogCurrentCall.startTime) + 500) / 1000;
+	callLogRecord_t *record;
+
+	if (duration > 0xFFFF)
+	{
+		duration = 0xFFFF;
+	}
+
+	// This is also called for received LCs, so it never writes to the Flash. callLogTick() does that once the radio is idle.
+	if (callLogTailCount == CALL_LOG_RAM_TAIL_SIZE)
+	{
+		// Lose the oldest waiting call rather than the newest
+		callLogTailCount--;
+		memmove(&callLogTail[0], &callLogTail[1], callLogTailCount * sizeof(callLogRecord_t));
+	}
+
+	if (callLogTailCount == 0)
+	{
+		callLogTailTime = fw_millis();
+	}
+
+	record = &callLogTail[callLogTailCount++];
+	memset(record, 0xFF, sizeof(callLogRecord_t));
+	record->marker = CALL_LOG_RECORD_MARKER;
+	record->duration = duration;
+	record->sequence = callLogNextSequence++;
+	record->id = callLogCurrentCall.id;
+	record->talkGroupOrPcId = callLogCurrentCall.talkGroupOrPcId;
+	record->operatingTime = fw_operatingSeconds() - ((fw_millis() - callLogCurrentCall.lastHeardTime) / 1000);
+	memset(record->locator, 0, sizeof(record->locator));
+
+	if (item != NULL)
+	{
+		memcpy(record->locator, item->locator, sizeof(record->locator));
+		item->callCount++;
+		item->airtime += duration;
+	}
+
+	record->crc = call_log_recordCRC(record);
+
+	callLogCurrentCall.id = 0;
+}
+
+// Called by the last heard list for every received LC
+void callLogCallHeard(uint32_t id, uint32_t talkGroupOrPcId)
+{
+	if ((callLogCurrentCall.id != 0) && ((callLogCurrentCall.id != id) || (callLogCurrentCall.talkGroupOrPcId != talkGroupOrPcId)))
+	{
+		call_log_endCall();
+	}
+
+	if (callLogCurrentCall.id == 0)
+	{
+		callLogCurrentCall.id = id;
+		callLogCurrentCall.talkGroupOrPcId = talkGroupOrPcId;
+		callLogCurrentCall.startTime = fw_millis();
+	}
+
+	callLogCurrentCall.lastHeardTime = fw_millis();
+}
+
+// Called from the main loop. The Flash is only written when the radio is not receiving or transmitting.
+void callLogTick(void)
+{
+	if ((callLogCurrentCall.id != 0) && ((fw_millis() - callLogCurrentCall.lastHeardTime) > CALL_LOG_CALL_END_MS))
+	{
+		if ((callLogTailCount == CALL_LOG_RAM_TAIL_SIZE) && (call_log_radioIsBusy() == false))
+		{
+			callLogFlush();// Make room, rather than losing a call
+		}
+		call_log_endCall();
+	}
+
+	if ((callLogTailCount > 0) && (call_log_radioIsBusy() == false) &&
+			((callLogTailCount >= CALL_LOG_FLUSH_RECORDS) || ((fw_millis() - callLogTailTime) >= CALL_LOG_FLUSH_DELAY_MS)))
+	{
+		callLogFlush();
+	}
+}
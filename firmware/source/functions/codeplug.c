@@ -89,8 +89,48 @@ typedef struct
 
 __attribute__((section(".data.$RAM2"))) codeplugContactsCache_t codeplugContactsCache;
 
+// Open addressing hash of the TG / PC contacts, keyed on tgOrPCNum (call type and number).
+// Each slot holds the position in contactsLookupCache + 1 (0 = empty), so it is rebuilt whenever a contact is added or removed.
+#define CODEPLUG_CONTACTS_HASH_SIZE   (CODEPLUG_CONTACTS_MAX * 2)// must be a power of 2, and always have empty slots
+static uint16_t codeplugContactsHash[CODEPLUG_CONTACTS_HASH_SIZE];// Not in RAM2, which is already nearly full
+
 __attribute__((section(".data.$RAM4"))) uint8_t codeplugRXGroupCache[77] = { 0 };
 
+// Zone number -> zone slot in the EEPROM, and the names of recently used zones
+#define CODEPLUG_ZONE_DIRECTORY_SIZE    256// One entry per In Use bit
+#define CODEPLUG_ZONE_NAME_CACHE_SIZE   16
+
+typedef struct
+{
+	int16_t zoneNum;// -1 = unused
+	char name[16];
+} codeplugZoneNameCacheEntry_t;
+
+__attribute__((section(".data.$RAM4"))) static uint8_t codeplugZonesDirectory[CODEPLUG_ZONE_DIRECTORY_SIZE];
+__attribute__((section(".data.$RAM4"))) static codeplugZoneNameCacheEntry_t codeplugZoneNameCache[CODEPLUG_ZONE_NAME_CACHE_SIZE];
+static int codeplugZonesCount = 0;
+static bool codeplugZonesStale = true;
+
+// In use bits of the 1024 channels, bit 0 of word 0 is channel 1
+__attribute__((section(".data.$RAM4"))) static uint32_t codeplugChannelsValidBitmap[CODEPLUG_CHANNELS_MAX / 32];
+static int codeplugChannelsValidFirst = 0;
+static int codeplugChannelsValidLast = 0;
+static bool codeplugChannelsValidStale = true;
+
+// Decoded channels, so scanning and zone browsing don't re-read and re-convert the same channels
+typedef struct
+{
+	uint16_t index;// 0 = unused
+	uint32_t lastUsed;
+	struct_codeplugChannel_t channel;
+} codeplugChannelCacheEntry_t;
+
+__attribute__((section(".data.$RAM2"))) static codeplugChannelCacheEntry_t codeplugChannelCache[CODEPLUG_CHANNEL_CACHE_SIZE];
+static uint32_t codeplugChannelCacheUseCounter = 0;
+codeplugChannelCacheStats_t codeplugChannelCacheStats;
+
+static void codeplugChannelReadDataForIndex(int index, struct_codeplugChannel_t *channelBuf);
+
 uint32_t byteSwap32(uint32_t n)
 {
     return ((((n) & 0x000000FFU) << 24U) | (((n) & 0x0000FF00U) << 8U) | (((n) & 0x00FF0000U) >> 8U) | (((n) & 0xFF000000U) >> 24U));// from usb_misc.h
@@ -219,17 +259,65 @@ void codeplugUtilConvertStringToBuf(char *inBuf, char *outBuf, int len)
 	}
 }
 
-int codeplugZonesGetCount(void)
+// Build the zone number -> zone slot directory from the In Use bits, which are the first 32 bytes of the Zones data.
+// The Zones data is not guaranteed to be packed by the CPS (though we should attempt to make the CPS always pack the Zones)
+void codeplugInitZonesCache(void)
 {
-	uint8_t buf[CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA_SIZE];
-	int numZones = 0;
+	uint8_t inUseBuf[CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA_SIZE];
+
+	EEPROM_Read(CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA, (uint8_t*)&inUseBuf, CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA_SIZE);
 
-	EEPROM_Read(CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA, (uint8_t*)&buf, CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA_SIZE);
+	codeplugZonesCount = 0;
 	for(int i = 0; i < CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA_SIZE; i++)
 	{
-		numZones += __builtin_popcount(buf[i]);
+		uint8_t bits = inUseBuf[i];
+
+		while ((bits != 0) && (codeplugZonesCount < CODEPLUG_ZONE_MAX_COUNT))
+		{
+			codeplugZonesDirectory[codeplugZonesCount++] = (i * 8) + __builtin_ctz(bits);
+			bits &= (bits - 1);// clear the lowest set bit
+		}
+	}
+
+	for (int i = 0; i < CODEPLUG_ZONE_NAME_CACHE_SIZE; i++)
+	{
+		codeplugZoneNameCache[i].zoneNum = -1;
 	}
-	return (numZones + 1); // Add one extra zone to allow for the special 'All Channels' Zone
+
+	codeplugZonesStale = false;
+}
+
+// The CPS has written to the EEPROM, rebuild the directory when it's next needed
+void codeplugZonesCacheInvalidate(void)
+{
+	codeplugZonesStale = true;
+}
+
+static inline void codeplugZonesCacheCheck(void)
+{
+	if (codeplugZonesStale)
+	{
+		codeplugInitZonesCache();
+	}
+}
+
+static int codeplugZoneGetAddress(int zoneNum)
+{
+	return CODEPLUG_ADDR_EX_ZONE_LIST + (codeplugZonesDirectory[zoneNum] * (16 + (2 * codeplugChannelsPerZone)));
+}
+
+int codeplugZonesGetCount(void)
+{
+	codeplugZonesCacheCheck();
+	return (codeplugZonesCount + 1); // Add one extra zone to allow for the special 'All Channels' Zone
+}
+
+static void codeplugZoneNameCacheStore(int zoneNum, char *name)
+{
+	codeplugZoneNameCacheEntry_t *entry = &codeplugZoneNameCache[zoneNum % CODEPLUG_ZONE_NAME_CACHE_SIZE];
+
+	entry->zoneNum = zoneNum;
+	memcpy(entry->name, name, sizeof(entry->name));
 }
 
 void codeplugZoneGetDataForNumber(int zoneNum, struct_codeplugZone_t *returnBuf)
@@ -248,38 +336,10 @@ void codeplugZoneGetDataForNumber(int zoneNum, struct_codeplugZone_t *returnBuf)
 	}
 	else
 	{
-		// Need to find the index into the Zones data for the specific Zone number.
-		// Because the Zones data is not guaranteed to be packed by the CPS (though we should attempt to make the CPS always pack the Zones)
-
-		// Read the In Use data which is the first 32 byes of the Zones data
-		uint8_t inUseBuf[CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA_SIZE];
-		EEPROM_Read(CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA, (uint8_t*)&inUseBuf, CODEPLUG_ADDR_EX_ZONE_INUSE_PACKED_DATA_SIZE);
-
-		int count = -1;// Need to start counting at -1 because the Zone number is zero indexed
-		int foundIndex = -1;
-
-		// Go though each byte in the In Use table
-		for(int i = 0; ((i < 32) && (foundIndex == -1)); i++)
-		{
-			// Go though each binary bit, counting them one by one
-			for(int j = 0; j < 8; j++)
-			{
-				if ((inUseBuf[i] & 0x01 ) == 0x01)
-				{
-					count++;
-					if (count == zoneNum)
-					{
-						// found it. So save the index before we exit the "for" loops
-						foundIndex = (i * 8) + j;
-						break;// Will break out of this loop, but the outer loop breaks becuase it also checks for foundIndex
-					}
-				}
-				inUseBuf[i] = inUseBuf[i] >> 1;
-			}
-		}
-
 		// IMPORTANT. read size is different from the size of the data, because I added a extra property to the struct to hold the number of channels in the zone.
-		EEPROM_Read(CODEPLUG_ADDR_EX_ZONE_LIST + (foundIndex  * (16 + (2 * codeplugChannelsPerZone))), (uint8_t*)returnBuf, sizeof(struct_codeplugZone_t));
+		EEPROM_Read(codeplugZoneGetAddress(zoneNum), (uint8_t*)returnBuf, sizeof(struct_codeplugZone_t));
+		codeplugZoneNameCacheStore(zoneNum, returnBuf->name);
+
 		returnBuf->NOT_IN_MEMORY_isAllChannelsZone = false;
 		for(int i = 0; i < codeplugChannelsPerZone; i++)
 		{
@@ -295,68 +355,276 @@ void codeplugZoneGetDataForNumber(int zoneNum, struct_codeplugZone_t *returnBuf)
 	}
 }
 
+// Gets the 16 byte codeplug name (not zero terminated) of a zone, without reading the channel list
+void codeplugZoneGetNameForNumber(int zoneNum, char *nameBuf)
+{
+	if (zoneNum == codeplugZonesGetCount() - 1)
+	{
+		memset(nameBuf, 0, 16);
+		strncpy(nameBuf, currentLanguage->all_channels, 15);
+	}
+	else if (codeplugZoneNameCache[zoneNum % CODEPLUG_ZONE_NAME_CACHE_SIZE].zoneNum == zoneNum)
+	{
+		memcpy(nameBuf, codeplugZoneNameCache[zoneNum % CODEPLUG_ZONE_NAME_CACHE_SIZE].name, 16);
+	}
+	else
+	{
+		EEPROM_Read(codeplugZoneGetAddress(zoneNum), (uint8_t*)nameBuf, 16);
+		codeplugZoneNameCacheStore(zoneNum, nameBuf);
+	}
+}
+
+static int codeplugChannelsValidBankAddress(int channelbank)
+{
+	if (channelbank == 0)
+	{
+		return CODEPLUG_ADDR_CHANNEL_EEPROM - 16;
+	}
+
+	return CODEPLUG_ADDR_CHANNEL_FLASH - 16 + (channelbank - 1) * (128 * CODEPLUG_CHANNEL_DATA_SIZE + 16);
+}
+
+static void codeplugChannelsValidFindLimits(void)
+{
+	codeplugChannelsValidFirst = codeplugChannelGetNextValidIndex(CODEPLUG_CHANNELS_MAX, 1);
+	codeplugChannelsValidLast = codeplugChannelGetNextValidIndex(CODEPLUG_CHANNELS_MIN, -1);
+}
+
+// Load the in use bits of all 1024 channels (one 16 byte bitmap per bank of 128), so they don't need to be read each time
+void codeplugInitChannelsValidCache(void)
+{
+	for (int channelbank = 0; channelbank < (CODEPLUG_CHANNELS_MAX / 128); channelbank++)
+	{
+		if (channelbank == 0)
+		{
+			EEPROM_Read(codeplugChannelsValidBankAddress(channelbank), (uint8_t *)&codeplugChannelsValidBitmap[channelbank * 4], 16);
+		}
+		else
+		{
+			SPI_Flash_read(codeplugChannelsValidBankAddress(channelbank), (uint8_t *)&codeplugChannelsValidBitmap[channelbank * 4], 16);
+		}
+	}
+
+	codeplugChannelsValidStale = false;
+	codeplugChannelsValidFirst = 0;
+	codeplugChannelsValidLast = 0;
+	codeplugChannelsValidFindLimits();
+}
+
+// The CPS has written to the codeplug, reload the bitmap when it's next needed
+void codeplugChannelsValidCacheInvalidate(void)
+{
+	codeplugChannelsValidStale = true;
+}
+
+static inline void codeplugChannelsValidCacheCheck(void)
+{
+	if (codeplugChannelsValidStale)
+	{
+		codeplugInitChannelsValidCache();
+	}
+}
+
 bool codeplugChannelIndexIsValid(int index)
 {
-	uint8_t bitarray[16];
+	if ((index < CODEPLUG_CHANNELS_MIN) || (index > CODEPLUG_CHANNELS_MAX))
+	{
+		return false;
+	}
 
+	codeplugChannelsValidCacheCheck();
 	index--;
-	int channelbank = index / 128;
-	int channeloffset = index % 128;
 
-	if(channelbank == 0)
+	return ((codeplugChannelsValidBitmap[index >> 5] >> (index & 0x1F)) & 0x01);
+}
+
+void codeplugChannelIndexSetValid(int index)
+{
+	if ((index < CODEPLUG_CHANNELS_MIN) || (index > CODEPLUG_CHANNELS_MAX))
 	{
-		EEPROM_Read(CODEPLUG_ADDR_CHANNEL_EEPROM - 16, (uint8_t *)bitarray, 16);
+		return;
 	}
-	else
+
+	codeplugChannelsValidCacheCheck();
+
+	int channelbank = (index - 1) / 128;
+
+	codeplugChannelsValidBitmap[(index - 1) >> 5] |= 1U << ((index - 1) & 0x1F);
+
+	if ((codeplugChannelsValidFirst == 0) || (index < codeplugChannelsValidFirst))
 	{
-		SPI_Flash_read(CODEPLUG_ADDR_CHANNEL_FLASH - 16 + (channelbank - 1) * (128 * CODEPLUG_CHANNEL_DATA_SIZE + 16), (uint8_t *)bitarray, 16);
+		codeplugChannelsValidFirst = index;
 	}
 
-	int byteno = channeloffset / 8;
-	int bitno = channeloffset % 8;
-	if (((bitarray[byteno] >> bitno) & 0x01) == 0)
+	if (index > codeplugChannelsValidLast)
 	{
-		return false;
+		codeplugChannelsValidLast = index;
+	}
+
+	if(channelbank == 0)
+	{
+		EEPROM_Write(codeplugChannelsValidBankAddress(channelbank), (uint8_t *)&codeplugChannelsValidBitmap[channelbank * 4], 16);
 	}
 	else
 	{
-		return true;
+		SPI_Flash_write(codeplugChannelsValidBankAddress(channelbank), (uint8_t *)&codeplugChannelsValidBitmap[channelbank * 4], 16);
 	}
 }
 
-void codeplugChannelIndexSetValid(int index)
+// Returns the next valid channel after index, in the given direction (1 or -1), wrapping around. Returns 0 if there are no valid channels.
+int codeplugChannelGetNextValidIndex(int index, int direction)
 {
-	uint8_t bitarray[16];
+	int bit;
+	int word;
+	uint32_t mask;
 
-	index--;
-	int channelbank = index / 128;
-	int channeloffset = index % 128;
+	codeplugChannelsValidCacheCheck();
 
-	if(channelbank == 0)
+	if (direction > 0)
 	{
-		EEPROM_Read(CODEPLUG_ADDR_CHANNEL_EEPROM - 16, (uint8_t *)bitarray, 16);
+		bit = index;// bit of index + 1
+		if ((bit >= CODEPLUG_CHANNELS_MAX) || (bit < 0))
+		{
+			bit = 0;
+		}
+
+		word = bit >> 5;
+		mask = codeplugChannelsValidBitmap[word] & (0xFFFFFFFFU << (bit & 0x1F));
+
+		for (int i = 0; i <= (CODEPLUG_CHANNELS_MAX / 32); i++)
+		{
+			if (mask != 0)
+			{
+				return (word << 5) + __builtin_ctz(mask) + 1;
+			}
+
+			word = (word + 1) % (CODEPLUG_CHANNELS_MAX / 32);
+			mask = codeplugChannelsValidBitmap[word];
+		}
 	}
 	else
 	{
-		SPI_Flash_read(CODEPLUG_ADDR_CHANNEL_FLASH - 16 + (channelbank - 1) * (128 * CODEPLUG_CHANNEL_DATA_SIZE + 16), (uint8_t *)bitarray, 16);
+		bit = index - 2;// bit of index - 1
+		if ((bit < 0) || (bit >= CODEPLUG_CHANNELS_MAX))
+		{
+			bit = CODEPLUG_CHANNELS_MAX - 1;
+		}
+
+		word = bit >> 5;
+		mask = codeplugChannelsValidBitmap[word] & (0xFFFFFFFFU >> (31 - (bit & 0x1F)));
+
+		for (int i = 0; i <= (CODEPLUG_CHANNELS_MAX / 32); i++)
+		{
+			if (mask != 0)
+			{
+				return (word << 5) + (31 - __builtin_clz(mask)) + 1;
+			}
+
+			word = (word + (CODEPLUG_CHANNELS_MAX / 32) - 1) % (CODEPLUG_CHANNELS_MAX / 32);
+			mask = codeplugChannelsValidBitmap[word];
+		}
+	}
+
+	return 0;
+}
+
+int codeplugChannelGetFirstValidIndex(void)
+{
+	codeplugChannelsValidCacheCheck();
+	return codeplugChannelsValidFirst;
+}
+
+int codeplugChannelGetLastValidIndex(void)
+{
+	codeplugChannelsValidCacheCheck();
+	return codeplugChannelsValidLast;
+}
+
+static codeplugChannelCacheEntry_t *codeplugChannelCacheFind(int index)
+{
+	for (int i = 0; i < CODEPLUG_CHANNEL_CACHE_SIZE; i++)
+	{
+		if (codeplugChannelCache[i].index == index)
+		{
+			return &codeplugChannelCache[i];
+		}
 	}
 
-	int byteno = channeloffset / 8;
-	int bitno = channeloffset % 8;
+	return NULL;
+}
 
-	bitarray[byteno] |= 1 << bitno;
+static void codeplugChannelCacheInsert(int index, struct_codeplugChannel_t *channelBuf, bool forScan)
+{
+	codeplugChannelCacheEntry_t *entry = &codeplugChannelCache[0];
 
-	if(channelbank == 0)
+	// Use an unused entry, or replace the least recently used one
+	for (int i = 0; i < CODEPLUG_CHANNEL_CACHE_SIZE; i++)
 	{
-		EEPROM_Write(CODEPLUG_ADDR_CHANNEL_EEPROM - 16, (uint8_t *)bitarray, 16);
+		if (codeplugChannelCache[i].index == 0)
+		{
+			entry = &codeplugChannelCache[i];
+			break;
+		}
+
+		if (codeplugChannelCache[i].lastUsed < entry->lastUsed)
+		{
+			entry = &codeplugChannelCache[i];
+		}
 	}
-	else
+
+	entry->index = index;
+	entry->lastUsed = (forScan ? 0 : ++codeplugChannelCacheUseCounter);
+	memcpy(&entry->channel, channelBuf, sizeof(struct_codeplugChannel_t));
+}
+
+void codeplugChannelCacheInvalidate(void)
+{
+	memset(codeplugChannelCache, 0, sizeof(codeplugChannelCache));
+	codeplugChannelCacheUseCounter = 0;
+}
+
+// Called when the CPS writes to the codeplug
+void codeplugCachesInvalidate(void)
+{
+	codeplugChannelCacheInvalidate();
+	codeplugChannelsValidCacheInvalidate();
+	codeplugZonesCacheInvalidate();
+}
+
+static void codeplugChannelGetData(int index, struct_codeplugChannel_t *channelBuf, bool forScan)
+{
+	codeplugChannelCacheEntry_t *entry = codeplugChannelCacheFind(index);
+
+	if (entry != NULL)
 	{
-		SPI_Flash_write(CODEPLUG_ADDR_CHANNEL_FLASH - 16 + (channelbank - 1) * (128 * CODEPLUG_CHANNEL_DATA_SIZE + 16), (uint8_t *)bitarray, 16);
+		if (forScan == false)
+		{
+			entry->lastUsed = ++codeplugChannelCacheUseCounter;
+		}
+		memcpy(channelBuf, &entry->channel, sizeof(struct_codeplugChannel_t));
+		codeplugChannelCacheStats.hits++;
+		return;
 	}
+
+	codeplugChannelCacheStats.misses++;
+	codeplugChannelReadDataForIndex(index, channelBuf);
+	codeplugChannelCacheInsert(index, channelBuf, forScan);
 }
 
 void codeplugChannelGetDataForIndex(int index, struct_codeplugChannel_t *channelBuf)
+{
+	codeplugChannelGetData(index, channelBuf, false);
+}
+
+// A scan goes round the whole zone, which can be much bigger than the cache, so with LRU every hop would
+// replace the channel which is needed next. Scan reads don't change the LRU order, and the channels they add
+// are the first to be replaced, so the cached channels stay put and are hit on every pass.
+void codeplugChannelGetDataForScan(int index, struct_codeplugChannel_t *channelBuf)
+{
+	codeplugChannelGetData(index, channelBuf, true);
+}
+
+static void codeplugChannelReadDataForIndex(int index, struct_codeplugChannel_t *channelBuf)
 {
 	// lower 128 channels are in EEPROM. Remaining channels are in Flash ! (What a mess...)
 	index--; // I think the channel index numbers start from 1 not zero.
@@ -398,6 +666,13 @@ void codeplugChannelGetDataForIndex(int index, struct_codeplugChannel_t *channel
 bool codeplugChannelSaveDataForIndex(int index, struct_codeplugChannel_t *channelBuf)
 {
 	bool retVal = true;
+	codeplugChannelCacheEntry_t *entry = codeplugChannelCacheFind(index);
+
+	if (entry != NULL)
+	{
+		entry->index = 0;// It will be read back from the codeplug next time
+		entry->lastUsed = 0;
+	}
 
 	channelBuf->chMode = (channelBuf->chMode == RADIO_MODE_ANALOG) ? 0 : 1;
 	// Convert normal integers into legacy codeplug tx and rx freq values
@@ -415,9 +690,6 @@ bool codeplugChannelSaveDataForIndex(int index, struct_codeplugChannel_t *channe
 	else
 	{
 		int flashWritePos = CODEPLUG_ADDR_CHANNEL_FLASH;
-		int flashSector;
-		int flashEndSector;
-		int bytesToWriteInCurrentSector = sizeof(struct_codeplugChannel_t);
 
 		index -= 128;// First 128 channels are in the EEPOM, so subtract 128 from the number when looking in the Flash
 
@@ -425,58 +697,7 @@ bool codeplugChannelSaveDataForIndex(int index, struct_codeplugChannel_t *channe
 		flashWritePos += 16 * (index / 128);// we just need to skip over that these flag bits when calculating the position of the channel data in memory
 		flashWritePos += index * sizeof(struct_codeplugChannel_t);// go to the position of the specific index
 
-		flashSector 	= flashWritePos / 4096;
-		flashEndSector 	= (flashWritePos + sizeof(struct_codeplugChannel_t)) / 4096;
-
-		if (flashSector != flashEndSector)
-		{
-			bytesToWriteInCurrentSector = (flashEndSector * 4096) - flashWritePos;
-		}
-
-		SPI_Flash_read(flashSector * 4096, SPI_Flash_sectorbuffer, 4096);
-		uint8_t *writePos = SPI_Flash_sectorbuffer + flashWritePos - (flashSector * 4096);
-		memcpy(writePos, channelBuf, bytesToWriteInCurrentSector);
-
-		retVal = SPI_Flash_eraseSector(flashSector * 4096);
-		if (!retVal)
-		{
-			return false;
-		}
-
-		for (int i = 0; i < 16; i++)
-		{
-			retVal = SPI_Flash_writePage(flashSector * 4096 + i * 256, SPI_Flash_sectorbuffer + i * 256);
-			if (!retVal)
-			{
-				return false;
-			}
-		}
-
-		if (flashSector != flashEndSector)
-		{
-			uint8_t *channelBufPusOffset = (uint8_t *)channelBuf + bytesToWriteInCurrentSector;
-			bytesToWriteInCurrentSector = sizeof(struct_codeplugChannel_t) - bytesToWriteInCurrentSector;
-
-			SPI_Flash_read(flashEndSector * 4096, SPI_Flash_sectorbuffer, 4096);
-			memcpy(SPI_Flash_sectorbuffer, (uint8_t *)channelBufPusOffset, bytesToWriteInCurrentSector);
-
-			retVal = SPI_Flash_eraseSector(flashEndSector * 4096);
-
-			if (!retVal)
-			{
-				return false;
-			}
-			for (int i = 0; i < 16; i++)
-			{
-				retVal = SPI_Flash_writePage(flashEndSector * 4096 + i * 256, SPI_Flash_sectorbuffer + i * 256);
-
-				if (!retVal)
-				{
-					return false;
-				}
-			}
-
-		}
+		retVal = SPI_Flash_write(flashWritePos, (uint8_t *)channelBuf, sizeof(struct_codeplugChannel_t));
 	}
 
 	// Need to restore the values back to what we need for the operation of the firmware rather than the BCD values the codeplug uses
@@ -577,35 +798,67 @@ int codeplugContactGetDataForNumber(int number, int callType, struct_codeplugCon
 	return pos;
 }
 
-int codeplugContactIndexByTGorPC(int tgorpc, int callType, struct_codeplugContact_t *contact)
+static inline uint32_t codeplugContactsHashSlot(uint32_t tgOrPCNum)
+{
+	return ((tgOrPCNum * 2654435761U) >> 21) & (CODEPLUG_CONTACTS_HASH_SIZE - 1);// Knuth multiplicative hash, top 11 bits
+}
+
+static void codeplugContactsHashRebuild(void)
 {
 	int numContacts = codeplugContactsCache.numTGContacts + codeplugContactsCache.numPCContacts;
+
+	memset(codeplugContactsHash, 0, sizeof(codeplugContactsHash));
+
 	for (int i = 0; i < numContacts; i++)
 	{
-		if (((codeplugContactsCache.contactsLookupCache[i].tgOrPCNum & 0xFFFFFF) == tgorpc) &&
-				((codeplugContactsCache.contactsLookupCache[i].tgOrPCNum >> 24) == callType))
+		uint32_t slot = codeplugContactsHashSlot(codeplugContactsCache.contactsLookupCache[i].tgOrPCNum);
+
+		while (codeplugContactsHash[slot] != 0)
 		{
-			codeplugContactGetDataForIndex(codeplugContactsCache.contactsLookupCache[i].index, contact);
-			return i;
+			slot = (slot + 1) & (CODEPLUG_CONTACTS_HASH_SIZE - 1);
 		}
+		codeplugContactsHash[slot] = i + 1;
 	}
-	return 0;
 }
 
-bool codeplugContactsContainsPC(uint32_t pc)
+// Returns the position in contactsLookupCache, or -1 if there is no contact with this call type and number
+static int codeplugContactsHashFind(uint32_t tgOrPCNum)
 {
-	int numContacts =  codeplugContactsCache.numTGContacts + codeplugContactsCache.numPCContacts;
-	pc = pc & 0x00FFFFFF;
-	pc = pc | (CONTACT_CALLTYPE_PC << 24);
+	uint32_t slot = codeplugContactsHashSlot(tgOrPCNum);
 
-	for (int i = 0; i < numContacts; i++)
+	while (codeplugContactsHash[slot] != 0)
 	{
-		if (codeplugContactsCache.contactsLookupCache[i].tgOrPCNum == pc)
+		int pos = codeplugContactsHash[slot] - 1;
+
+		if (codeplugContactsCache.contactsLookupCache[pos].tgOrPCNum == tgOrPCNum)
 		{
-			return true;
+			return pos;
 		}
+		slot = (slot + 1) & (CODEPLUG_CONTACTS_HASH_SIZE - 1);
 	}
-	return false;
+
+	return -1;
+}
+
+// Returns the contact index (1 to 1024), or 0 if not found
+int codeplugContactIndexByTGorPC(int tgorpc, int callType, struct_codeplugContact_t *contact)
+{
+	int pos = codeplugContactsHashFind((tgorpc & 0xFFFFFF) | (callType << 24));
+
+	if (pos >= 0)
+	{
+		codeplugContactGetDataForIndex(codeplugContactsCache.contactsLookupCache[pos].index, contact);
+		return codeplugContactsCache.contactsLookupCache[pos].index;
+	}
+	return 0;
+}
+
+bool codeplugContactsContainsPC(uint32_t pc)
+{
+	pc = pc & 0x00FFFFFF;
+	pc = pc | (CONTACT_CALLTYPE_PC << 24);
+
+	return (codeplugContactsHashFind(pc) >= 0);
 }
 
 void codeplugInitContactsCache(void)
@@ -613,13 +866,18 @@ void codeplugInitContactsCache(void)
 	struct_codeplugContact_t contact;
 	uint8_t                  c;
 	int codeplugNumContacts = 0;
+	spiFlashStream_t contactsStream;
 	codeplugContactsCache.numTGContacts = 0;
 	codeplugContactsCache.numPCContacts = 0;
 	codeplugContactsCache.numDTMFContacts = 0;
 
+	// The contacts are contiguous, so read them as one stream. Seeking over the unused 3 bytes at the end of each contact is done on the bus without a new read command.
+	SPI_Flash_streamOpen(&contactsStream, CODEPLUG_ADDR_CONTACTS, false);
+
 	for(int i = 0; i < CODEPLUG_CONTACTS_MAX; i++)
 	{
-		if (SPI_Flash_read((CODEPLUG_ADDR_CONTACTS + (i * CODEPLUG_CONTACT_DATA_SIZE)), (uint8_t *)&contact, 16 + 4 + 1))// Name + TG/ID + Call type
+		SPI_Flash_streamSeek(&contactsStream, (CODEPLUG_ADDR_CONTACTS + (i * CODEPLUG_CONTACT_DATA_SIZE)));
+		if (SPI_Flash_streamRead(&contactsStream, (uint8_t *)&contact, 16 + 4 + 1))// Name + TG/ID + Call type
 		{
 			if (contact.name[0] != 0xFF)
 			{
@@ -638,6 +896,8 @@ void codeplugInitContactsCache(void)
 			}
 		}
 	}
+	SPI_Flash_streamClose(&contactsStream);
+	codeplugContactsHashRebuild();
 
 	for (int i = 0; i < CODEPLUG_DTMF_CONTACTS_MAX; i++)
 	{
@@ -679,7 +939,7 @@ void codeplugContactsCacheUpdateOrInsertContactAt(int index, struct_codeplugCont
 			//update the
 			codeplugContactsCache.contactsLookupCache[i].tgOrPCNum = bcd2int(byteSwap32(contact->tgNumber));
 			codeplugContactsCache.contactsLookupCache[i].tgOrPCNum |= (contact->callType << 24);// Store the call type in the upper byte
-
+			codeplugContactsHashRebuild();
 			return;
 		}
 		else
@@ -703,6 +963,7 @@ void codeplugContactsCacheUpdateOrInsertContactAt(int index, struct_codeplugCont
 				codeplugContactsCache.contactsLookupCache[i + 1].tgOrPCNum = bcd2int(byteSwap32(contact->tgNumber));
 				codeplugContactsCache.contactsLookupCache[i + 1].index = index;// Contacts are numbered from 1 to 1024
 				codeplugContactsCache.contactsLookupCache[i + 1].tgOrPCNum |= (contact->callType << 24);// Store the call type in the upper byte
+				codeplugContactsHashRebuild();
 				return;
 			}
 		}
@@ -724,6 +985,7 @@ void codeplugContactsCacheUpdateOrInsertContactAt(int index, struct_codeplugCont
 	codeplugContactsCache.contactsLookupCache[numContacts].tgOrPCNum = bcd2int(byteSwap32(contact->tgNumber));
 	codeplugContactsCache.contactsLookupCache[numContacts].index = index;// Contacts are numbered from 1 to 1024
 	codeplugContactsCache.contactsLookupCache[numContacts].tgOrPCNum |= (contact->callType << 24);// Store the call type in the upper byte
+	codeplugContactsHashRebuild();
 }
 
 void codeplugContactsCacheRemoveContactAt(int index)
@@ -743,6 +1005,7 @@ void codeplugContactsCacheRemoveContactAt(int index)
 			}
 			// Note memcpy should work here, because memcpy normally copys from the lowest memory location upwards
 			memcpy(&codeplugContactsCache.contactsLookupCache[i], &codeplugContactsCache.contactsLookupCache[i + 1], (numContacts - 1 - i) * sizeof(codeplugContactCache_t));
+			codeplugContactsHashRebuild();
 			return;
 		}
 	}
@@ -808,69 +1071,16 @@ bool codeplugContactGetDataForIndex(int index, struct_codeplugContact_t *contact
 int codeplugContactSaveDataForIndex(int index, struct_codeplugContact_t *contact)
 {
 	int retVal;
-	int flashWritePos = CODEPLUG_ADDR_CONTACTS;
-	int flashSector;
-	int flashEndSector;
-	int bytesToWriteInCurrentSector = CODEPLUG_CONTACT_DATA_SIZE;
 
 	index--;
 	contact->tgNumber = byteSwap32(int2bcd(contact->tgNumber));
 
-
-	flashWritePos += index * CODEPLUG_CONTACT_DATA_SIZE;// go to the position of the specific index
-
-	flashSector 	= flashWritePos / 4096;
-	flashEndSector 	= (flashWritePos + CODEPLUG_CONTACT_DATA_SIZE) / 4096;
-
-	if (flashSector != flashEndSector)
-	{
-		bytesToWriteInCurrentSector = (flashEndSector * 4096) - flashWritePos;
-	}
-
-	SPI_Flash_read(flashSector * 4096, SPI_Flash_sectorbuffer, 4096);
-	uint8_t *writePos = SPI_Flash_sectorbuffer + flashWritePos - (flashSector * 4096);
-	memcpy(writePos, contact, bytesToWriteInCurrentSector);
-
-	retVal = SPI_Flash_eraseSector(flashSector * 4096);
+	retVal = SPI_Flash_write(CODEPLUG_ADDR_CONTACTS + index * CODEPLUG_CONTACT_DATA_SIZE, (uint8_t *)contact, CODEPLUG_CONTACT_DATA_SIZE);
 	if (!retVal)
 	{
 		return false;
 	}
 
-	for (int i = 0; i < 16; i++)
-	{
-		retVal = SPI_Flash_writePage(flashSector * 4096 + i * 256, SPI_Flash_sectorbuffer + i * 256);
-		if (!retVal)
-		{
-			return false;
-		}
-	}
-
-	if (flashSector != flashEndSector)
-	{
-		uint8_t *channelBufPusOffset = (uint8_t *)contact + bytesToWriteInCurrentSector;
-		bytesToWriteInCurrentSector = CODEPLUG_CONTACT_DATA_SIZE - bytesToWriteInCurrentSector;
-
-		SPI_Flash_read(flashEndSector * 4096, SPI_Flash_sectorbuffer, 4096);
-		memcpy(SPI_Flash_sectorbuffer, (uint8_t *)channelBufPusOffset, bytesToWriteInCurrentSector);
-
-		retVal = SPI_Flash_eraseSector(flashEndSector * 4096);
-
-		if (!retVal)
-		{
-			return false;
-		}
-		for (int i = 0; i < 16; i++)
-		{
-			retVal = SPI_Flash_writePage(flashEndSector * 4096 + i * 256, SPI_Flash_sectorbuffer + i * 256);
-
-			if (!retVal)
-			{
-				return false;
-			}
-		}
-
-	}
 	if ((contact->name[0] == 0xff) || (contact->callType == 0xFF))
 	{
 		codeplugContactsCacheRemoveContactAt(index + 1);// index was decremented at the start of the function
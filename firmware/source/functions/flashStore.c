@@ -0,0 +1,419 @@
+/*
+ * Copyright (C)2020 Roger Clark. VK3KYY / G4KYF
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <functions/flashStore.h>
+#include <SPI_Flash.h>
+#include <hotspot/CRC.h>
+
+/*
+ * Sector layout:
+ *   8 byte header: magic (2), state (1), 0xFF (1), sequence number (4)
+ *   records, 4 byte aligned: key (1), length (1), data (length), CCITT CRC16 of key, length and data (2)
+ *
+ * A record with a length of 0 deletes the key.
+ * The state byte is only ever programmed from ERASED to COPYING to ACTIVE (clearing bits),
+ * so a compaction interrupted by a power cut leaves the previous sector as the valid one.
+ *
+ * A record torn by a power cut, or which didn't program correctly, is always the last one in the sector,
+ * because nothing more is appended after it: the next write compacts the sector first.
+ */
+#define FLASH_STORE_RECORD_OVERHEAD   4
+#define FLASH_STORE_RECORD_SIZE(len)  ((((len) + FLASH_STORE_RECORD_OVERHEAD) + 3) & ~3)
+
+static const uint32_t FLASH_STORE_SECTOR_SIZE = 4096;
+static const uint16_t FLASH_STORE_MAGIC = 0x5346;// "FS"
+static const int FLASH_STORE_HEADER_SIZE = 8;
+
+enum FLASH_STORE_SECTOR_STATE { FLASH_STORE_SECTOR_ERASED = 0xFF, FLASH_STORE_SECTOR_COPYING = 0x7F, FLASH_STORE_SECTOR_ACTIVE = 0x3F };
+
+typedef struct
+{
+	uint16_t magic;
+	uint8_t  state;
+	uint8_t  reserved;
+	uint32_t sequence;
+} flashStoreSectorHeader_t;
+
+flashStoreStats_t flashStoreStats;
+
+__attribute__((section(".data.$RAM2"))) static uint16_t flashStoreIndex[FLASH_STORE_MAX_KEYS];// Offset of the last record of each key, 0 if none
+__attribute__((section(".data.$RAM2"))) static uint8_t flashStoreLength[FLASH_STORE_MAX_KEYS];
+static int flashStoreActiveSector = -1;
+static uint32_t flashStoreSequence;
+static uint32_t flashStoreWriteOffset;
+static uint32_t flashStoreLiveBytes;// Space used by records which are still current
+
+static uint32_t flash_store_sectorAddress(int sector)
+{
+	return FLASH_STORE_BASE_ADDRESS + (sector * FLASH_STORE_SECTOR_SIZE);
+}
+
+// Returns the size of the record at addr, 0 at the end of the log, or -1 if the log can't be followed past this point
+static int flash_store_loadRecord(uint32_t addr, uint8_t *recBuf, bool *isValid)
+{
+	int length;
+
+	*isValid = false;
+	SPI_Flash_read(addr, recBuf, 2);
+
+	if ((recBuf[0] == 0xFF) && (recBuf[1] == 0xFF))
+	{
+		return 0;
+	}
+
+	length = recBuf[1];
+	if (length > FLASH_STORE_MAX_RECORD_LENGTH)
+	{
+		return -1;// Torn header
+	}
+
+	SPI_Flash_read(addr + 2, recBuf + 2, length + 2);
+	*isValid = ((recBuf[0] < FLASH_STORE_MAX_KEYS) && CRC_checkCCITT162(recBuf, length + FLASH_STORE_RECORD_OVERHEAD));
+
+	return FLASH_STORE_RECORD_SIZE(length);
+}
+
+static void flash_store_scan(void)
+{
+	uint8_t recBuf[FLASH_STORE_MAX_RECORD_LENGTH + FLASH_STORE_RECORD_OVERHEAD];
+	uint32_t sectorAddress = flash_store_sectorAddress(flashStoreActiveSector);
+	uint32_t offset = FLASH_STORE_HEADER_SIZE;
+
+	memset(flashStoreIndex, 0, sizeof(flashStoreIndex));
+	memset(flashStoreLength, 0, sizeof(flashStoreLength));
+	flashStoreLiveBytes = 0;
+
+	while ((offset + 2) <= FLASH_STORE_SECTOR_SIZE)
+	{
+		bool isValid;
+		int key;
+		int size = flash_store_loadRecord(sectorAddress + offset, recBuf, &isValid);
+
+		if (size == 0)
+		{
+			break;
+		}
+
+		if ((size < 0) || ((offset + size) > FLASH_STORE_SECTOR_SIZE) || (isValid == false))
+		{
+			offset = FLASH_STORE_SECTOR_SIZE;// Can't append after a torn record, the next write will compact first
+			break;
+		}
+
+		key = recBuf[0];
+		if (flashStoreIndex[key] != 0)
+		{
+			flashStoreLiveBytes -= FLASH_STORE_RECORD_SIZE(flashStoreLength[key]);
+		}
+
+		if (recBuf[1] == 0)
+		{
+			flashStoreIndex[key] = 0;
+			flashStoreLength[key] = 0;
+		}
+		else
+		{
+			flashStoreIndex[key] = offset;
+			flashStoreLength[key] = recBuf[1];
+			flashStoreLiveBytes += size;
+		}
+
+		offset += size;
+	}
+
+	flashStoreWriteOffset = offset;
+}
+
+// Make sure the whole sector is blank, as an erase may have been interrupted
+static bool flash_store_prepareSector(int sector)
+{
+	uint8_t buf[64];
+	uint32_t sectorAddress = flash_store_sectorAddress(sector);
+
+	for (uint32_t offset = 0; offset < FLASH_STORE_SECTOR_SIZE; offset += sizeof(buf))
+	{
+		SPI_Flash_read(sectorAddress + offset, buf, sizeof(buf));
+		for (int i = 0; i < sizeof(buf); i++)
+		{
+			if (buf[i] != 0xFF)
+			{
+				return SPI_Flash_eraseSector(sectorAddress);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool flashStoreInit(void)
+{
+	flashStoreSectorHeader_t header;
+
+	flashStoreActiveSector = -1;
+
+	for (int i = 0; i < FLASH_STORE_NUM_SECTORS; i++)
+	{
+		SPI_Flash_read(flash_store_sectorAddress(i), (uint8_t *)&header, sizeof(flashStoreSectorHeader_t));
+		if ((header.magic == FLASH_STORE_MAGIC) && (header.state == FLASH_STORE_SECTOR_ACTIVE) &&
+				((flashStoreActiveSector < 0) || ((int32_t)(header.sequence - flashStoreSequence) > 0)))
+		{
+			flashStoreActiveSector = i;
+			flashStoreSequence = header.sequence;
+		}
+	}
+
+	// Clean up after an interrupted compaction
+	for (int i = 0; i < FLASH_STORE_NUM_SECTORS; i++)
+	{
+		if (i != flashStoreActiveSector)
+		{
+			SPI_Flash_read(flash_store_sectorAddress(i), (uint8_t *)&header, sizeof(flashStoreSectorHeader_t));
+			if ((header.magic != 0xFFFF) || (header.state != FLASH_STORE_SECTOR_ERASED))
+			{
+				SPI_Flash_eraseSector(flash_store_sectorAddress(i));
+			}
+		}
+	}
+
+	if (flashStoreActiveSector < 0)
+	{
+		// First use, or both sectors are corrupt
+		if (flash_store_prepareSector(0) == false)
+		{
+			return false;
+		}
+
+		header.magic = FLASH_STORE_MAGIC;
+		header.state = FLASH_STORE_SECTOR_ACTIVE;
+		header.reserved = 0xFF;
+		header.sequence = 1;
+
+		if (SPI_Flash_program(flash_store_sectorAddress(0), (uint8_t *)&header, sizeof(flashStoreSectorHeader_t)) == false)
+		{
+			return false;
+		}
+
+		flashStoreActiveSector = 0;
+		flashStoreSequence = header.sequence;
+	}
+
+	flash_store_scan();
+
+	return true;
+}
+
+int flashStoreRead(int key, uint8_t *buf, int bufSize)
+{
+	if ((flashStoreActiveSector < 0) || (key < 0) || (key >= FLASH_STORE_MAX_KEYS) || (flashStoreIndex[key] == 0))
+	{
+		return -1;
+	}
+
+	if (bufSize > flashStoreLength[key])
+	{
+		bufSize = flashStoreLength[key];
+	}
+
+	SPI_Flash_read(flash_store_sectorAddress(flashStoreActiveSector) + flashStoreIndex[key] + 2, buf, bufSize);
+
+	return flashStoreLength[key];
+}
+
+static bool flash_store_append(int key, const uint8_t *data, int length)
+{
+	uint8_t recBuf[FLASH_STORE_RECORD_SIZE(FLASH_STORE_MAX_RECORD_LENGTH)];
+	uint8_t readBack[FLASH_STORE_RECORD_SIZE(FLASH_STORE_MAX_RECORD_LENGTH)];
+	uint32_t recordAddress;
+	int size = FLASH_STORE_RECORD_SIZE(length);
+	bool ok;
+
+	if ((flashStoreWriteOffset + size) > FLASH_STORE_SECTOR_SIZE)
+	{
+		if ((flashStoreCompact() == false) || ((flashStoreWriteOffset + size) > FLASH_STORE_SECTOR_SIZE))
+		{
+			return false;
+		}
+	}
+
+	memset(recBuf, 0xFF, size);
+	recBuf[0] = key;
+	recBuf[1] = length;
+	if (length > 0)
+	{
+		memcpy(&recBuf[2], data, length);
+	}
+	CRC_addCCITT162(recBuf, length + FLASH_STORE_RECORD_OVERHEAD);
+
+	recordAddress = flash_store_sectorAddress(flashStoreActiveSector) + flashStoreWriteOffset;
+	ok = SPI_Flash_program(recordAddress, recBuf, size);
+	if (ok)
+	{
+		// Programming can't set bits, so the record is bad if that space wasn't blank
+		SPI_Flash_read(recordAddress, readBack, size);
+		ok = (memcmp(readBack, recBuf, size) == 0);
+	}
+	flashStoreStats.recordsWritten++;
+
+	if (ok == false)
+	{
+		flashStoreWriteOffset = FLASH_STORE_SECTOR_SIZE;// Nothing can follow a bad record, so compact before the next write
+		return false;
+	}
+
+	if (flashStoreIndex[key] != 0)
+	{
+		flashStoreLiveBytes -= FLASH_STORE_RECORD_SIZE(flashStoreLength[key]);
+	}
+
+	flashStoreIndex[key] = (length > 0) ? flashStoreWriteOffset : 0;
+	flashStoreLength[key] = length;
+	if (length > 0)
+	{
+		flashStoreLiveBytes += size;
+	}
+	flashStoreWriteOffset += size;
+
+	return true;
+}
+
+// A record which fails to program is retried once, in the newly compacted sector
+static bool flash_store_appendWithRetry(int key, const uint8_t *data, int length)
+{
+	return (flash_store_append(key, data, length) || flash_store_append(key, data, length));
+}
+
+bool flashStoreWrite(int key, const uint8_t *data, int length)
+{
+	if ((flashStoreActiveSector < 0) || (key < 0) || (key >= FLASH_STORE_MAX_KEYS) || (length <= 0) || (length > FLASH_STORE_MAX_RECORD_LENGTH))
+	{
+		return false;
+	}
+
+	if ((flashStoreIndex[key] != 0) && (flashStoreLength[key] == length))
+	{
+		uint8_t current[FLASH_STORE_MAX_RECORD_LENGTH];
+
+		flashStoreRead(key, current, length);
+		if (memcmp(current, data, length) == 0)
+		{
+			return true;// unchanged, don't use any Flash
+		}
+	}
+
+	return flash_store_appendWithRetry(key, data, length);
+}
+
+bool flashStoreDelete(int key)
+{
+	if ((flashStoreActiveSector < 0) || (key < 0) || (key >= FLASH_STORE_MAX_KEYS))
+	{
+		return false;
+	}
+
+	if (flashStoreIndex[key] == 0)
+	{
+		return true;
+	}
+
+	return flash_store_appendWithRetry(key, NULL, 0);
+}
+
+// Copy the current records to the other sector, then erase the old one
+bool flashStoreCompact(void)
+{
+	uint8_t recBuf[FLASH_STORE_MAX_RECORD_LENGTH + FLASH_STORE_RECORD_OVERHEAD];
+	flashStoreSectorHeader_t header;
+	int oldSector = flashStoreActiveSector;
+	int newSector = (oldSector + 1) % FLASH_STORE_NUM_SECTORS;
+	uint32_t oldAddress = flash_store_sectorAddress(oldSector);
+	uint32_t newAddress = flash_store_sectorAddress(newSector);
+	uint32_t offset = FLASH_STORE_HEADER_SIZE;
+	uint8_t state = FLASH_STORE_SECTOR_ACTIVE;
+
+	if ((oldSector < 0) || (flash_store_prepareSector(newSector) == false))
+	{
+		return false;
+	}
+
+	header.magic = FLASH_STORE_MAGIC;
+	header.state = FLASH_STORE_SECTOR_COPYING;
+	header.reserved = 0xFF;
+	header.sequence = flashStoreSequence + 1;
+
+	if (SPI_Flash_program(newAddress, (uint8_t *)&header, sizeof(flashStoreSectorHeader_t)) == false)
+	{
+		return false;
+	}
+
+	for (int key = 0; key < FLASH_STORE_MAX_KEYS; key++)
+	{
+		bool isValid;
+		int size;
+
+		if (flashStoreIndex[key] == 0)
+		{
+			continue;
+		}
+
+		size = flash_store_loadRecord(oldAddress + flashStoreIndex[key], recBuf, &isValid);
+		if ((size <= 0) || (isValid == false))
+		{
+			flashStoreIndex[key] = 0;// Record has gone bad since the index was built
+			flashStoreLength[key] = 0;
+			continue;
+		}
+
+		if (SPI_Flash_program(newAddress + offset, recBuf, recBuf[1] + FLASH_STORE_RECORD_OVERHEAD) == false)
+		{
+			flash_store_scan();// The old sector is still the valid one
+			return false;
+		}
+
+		flashStoreIndex[key] = offset;
+		offset += size;
+	}
+
+	if (SPI_Flash_program(newAddress + offsetof(flashStoreSectorHeader_t, state), &state, 1) == false)
+	{
+		flashStoreActiveSector = oldSector;
+		flash_store_scan();
+		return false;
+	}
+
+	flashStoreActiveSector = newSector;
+	flashStoreSequence = header.sequence;
+	flashStoreWriteOffset = offset;
+	flashStoreLiveBytes = offset - FLASH_STORE_HEADER_SIZE;
+	flashStoreStats.compactions++;
+
+	SPI_Flash_eraseSector(oldAddress);// If this is interrupted, flashStoreInit() will erase it again
+
+	return true;
+}
+
+// Compact in the background once most of the sector is stale, so writes don't have to wait for an erase
+void flashStoreTick(void)
+{
+	if ((flashStoreActiveSector >= 0) && (flashStoreWriteOffset > ((FLASH_STORE_SECTOR_SIZE * 3) / 4)) &&
+			((flashStoreWriteOffset - FLASH_STORE_HEADER_SIZE - flashStoreLiveBytes) > (FLASH_STORE_SECTOR_SIZE / 2)))
+	{
+		flashStoreCompact();
+	}
+}
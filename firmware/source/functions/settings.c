@@ -25,9 +25,38 @@
 #include <user_interface/menuSystem.h>
 #include <user_interface/uiLocalisation.h>
 #include <ticks.h>
+#include <functions/flashStore.h>
 
 static const int STORAGE_BASE_ADDRESS 		= 0x6000;
 static const int STORAGE_MAGIC_NUMBER 		= 0x4748;
+static const int STORAGE_SLOT_SIZE 			= 0x80;// One EEPROM page per slot
+
+/*
+ * The settings are saved alternately in two slots, each followed by a trailer holding a sequence number and a CRC,
+ * so if a save is interrupted the other slot still holds a complete copy.
+ * Each slot keeps the byte range which has changed since it was last written, so only that part is saved.
+ * Slot 0 is the original settings location, which is still loaded (without a valid trailer) after an upgrade.
+ */
+#define SETTINGS_NUM_SLOTS  2
+
+typedef struct
+{
+	uint16_t sequence;
+	uint16_t crc;
+} settingsSlotTrailer_t;
+
+// 0x80 is STORAGE_SLOT_SIZE, which can't be used in a constant expression
+_Static_assert((sizeof(settingsStruct_t) + sizeof(settingsSlotTrailer_t)) <= 0x80, "The settings and their trailer must fit in one slot");
+
+typedef struct
+{
+	uint8_t start;
+	uint8_t end;// start == end when the slot is up to date
+} settingsDirtyRange_t;
+
+static int settingsActiveSlot = 0;// slot holding the most recent save
+static uint16_t settingsSequence = 0;
+static settingsDirtyRange_t settingsSlotDirtyRange[SETTINGS_NUM_SLOTS];
 
 // Bit patterns for DMR Beep
 const uint8_t BEEP_TX_NONE  = 0x00;
@@ -39,7 +68,7 @@ static uint32_t dirtyTime = 0;
 #endif
 
 static bool settingsDirty = false;
-static bool settingsVFODirty = false;
+static bool settingsVFODirty = false;// Changed since they were saved, to the codeplug or the Flash store
 settingsStruct_t nonVolatileSettings;
 struct_codeplugChannel_t *currentChannelData;
 struct_codeplugChannel_t channelScreenChannelData = { .rxFreq = 0 };
@@ -52,39 +81,167 @@ int settingsCurrentChannelNumber = 0;
 
 int *nextKeyBeepMelody = (int *)MELODY_KEY_BEEP;
 
+static uint16_t settingsCRC16(const uint8_t *data, int length, uint16_t crc)
+{
+	while (length-- > 0)
+	{
+		crc ^= (*data++ << 8);
+		for (int i = 0; i < 8; i++)
+		{
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+static uint16_t settingsSlotCRC(settingsStruct_t *settings, uint16_t sequence)
+{
+	return settingsCRC16((uint8_t *)&sequence, sizeof(uint16_t), settingsCRC16((uint8_t *)settings, sizeof(settingsStruct_t), 0xFFFF));
+}
+
+static void settingsSetDirtyRange(void *s, int size)
+{
+	int offset = (uint8_t *)s - (uint8_t *)&nonVolatileSettings;
+
+	if ((offset < 0) || ((offset + size) > sizeof(settingsStruct_t)))
+	{
+		offset = 0;// Not part of nonVolatileSettings, be safe
+		size = sizeof(settingsStruct_t);
+	}
+
+	for (int slot = 0; slot < SETTINGS_NUM_SLOTS; slot++)
+	{
+		if (settingsSlotDirtyRange[slot].start == settingsSlotDirtyRange[slot].end)
+		{
+			settingsSlotDirtyRange[slot].start = offset;
+			settingsSlotDirtyRange[slot].end = offset + size;
+		}
+		else
+		{
+			if (offset < settingsSlotDirtyRange[slot].start)
+			{
+				settingsSlotDirtyRange[slot].start = offset;
+			}
+
+			if ((offset + size) > settingsSlotDirtyRange[slot].end)
+			{
+				settingsSlotDirtyRange[slot].end = offset + size;
+			}
+		}
+	}
+
+	settingsDirty = true;
+
+#if defined(PLATFORM_RD5R)
+	dirtyTime = fw_millis();
+#endif
+}
+
 bool settingsSaveSettings(bool includeVFOs)
 {
+	int slot = (settingsActiveSlot + 1) % SETTINGS_NUM_SLOTS;
+	int slotAddress = STORAGE_BASE_ADDRESS + (slot * STORAGE_SLOT_SIZE);
+	settingsSlotTrailer_t trailer;
+	bool ret;
+
 	if (includeVFOs)
 	{
 		codeplugSetVFO_ChannelData(&settingsVFOChannel[CHANNEL_VFO_A], CHANNEL_VFO_A);
 		codeplugSetVFO_ChannelData(&settingsVFOChannel[CHANNEL_VFO_B], CHANNEL_VFO_B);
 		settingsVFODirty = false;
+
+		settingsDiscardFlashStoreVFOs();// The codeplug copy is now the newest
 	}
 
 	// Never reset this setting (as voicePromptsCacheInit() can change it if voice data are missing)
 #if defined(PLATFORM_GD77S)
-	nonVolatileSettings.audioPromptMode = AUDIO_PROMPT_MODE_VOICE_LEVEL_3;
+	if (nonVolatileSettings.audioPromptMode != AUDIO_PROMPT_MODE_VOICE_LEVEL_3)
+	{
+		settingsSet(nonVolatileSettings.audioPromptMode, AUDIO_PROMPT_MODE_VOICE_LEVEL_3);
+	}
 #endif
 
-	bool ret = EEPROM_Write(STORAGE_BASE_ADDRESS, (uint8_t*)&nonVolatileSettings, sizeof(settingsStruct_t));
+	if (settingsSlotDirtyRange[slot].start == settingsSlotDirtyRange[slot].end)
+	{
+		settingsDirty = false;// Nothing has changed since this slot was written
+		return true;
+	}
+
+	trailer.sequence = settingsSequence + 1;
+	trailer.crc = settingsSlotCRC(&nonVolatileSettings, trailer.sequence);
+
+	// Write from the first changed byte up to the end of the trailer, so the EEPROM write queue can merge it into one page write
+	ret = EEPROM_Write(slotAddress + settingsSlotDirtyRange[slot].start, (uint8_t *)&nonVolatileSettings + settingsSlotDirtyRange[slot].start,
+			sizeof(settingsStruct_t) - settingsSlotDirtyRange[slot].start) &&
+			EEPROM_Write(slotAddress + sizeof(settingsStruct_t), (uint8_t *)&trailer, sizeof(settingsSlotTrailer_t));
 
 	if (ret)
 	{
+		settingsSlotDirtyRange[slot].start = settingsSlotDirtyRange[slot].end = 0;
+		settingsActiveSlot = slot;
+		settingsSequence = trailer.sequence;
 		settingsDirty = false;
 	}
 
 	return ret;
 }
 
+// Returns true if the slot holds settings, and sets isValid if its trailer is correct
+static bool settingsReadSlot(int slot, settingsStruct_t *settings, settingsSlotTrailer_t *trailer, bool *isValid)
+{
+	int slotAddress = STORAGE_BASE_ADDRESS + (slot * STORAGE_SLOT_SIZE);
+
+	*isValid = false;
+
+	if ((EEPROM_Read(slotAddress, (uint8_t *)settings, sizeof(settingsStruct_t)) == false) ||
+			(EEPROM_Read(slotAddress + sizeof(settingsStruct_t), (uint8_t *)trailer, sizeof(settingsSlotTrailer_t)) == false) ||
+			(settings->magicNumber != STORAGE_MAGIC_NUMBER))
+	{
+		return false;
+	}
+
+	*isValid = (trailer->crc == settingsSlotCRC(settings, trailer->sequence));
+
+	return true;
+}
+
 bool settingsLoadSettings(void)
 {
 	bool hasRestoredDefaultsettings=false;
-	bool readOK = EEPROM_Read(STORAGE_BASE_ADDRESS, (uint8_t*)&nonVolatileSettings, sizeof(settingsStruct_t));
-	if ((nonVolatileSettings.magicNumber != STORAGE_MAGIC_NUMBER) || (readOK != true))
+	settingsStruct_t otherSettings;
+	settingsSlotTrailer_t trailer[SETTINGS_NUM_SLOTS];
+	bool isValid[SETTINGS_NUM_SLOTS];
+	bool readOK = settingsReadSlot(0, &nonVolatileSettings, &trailer[0], &isValid[0]);
+
+	settingsReadSlot(1, &otherSettings, &trailer[1], &isValid[1]);
+
+	if (isValid[1] && ((isValid[0] == false) || ((int16_t)(trailer[1].sequence - trailer[0].sequence) > 0)))
+	{
+		memcpy(&nonVolatileSettings, &otherSettings, sizeof(settingsStruct_t));
+		settingsActiveSlot = 1;
+	}
+	else
+	{
+		settingsActiveSlot = 0;// Slot 0 may be valid, or have been saved by firmware without the slot trailer
+	}
+
+	if ((isValid[settingsActiveSlot] == false) && (readOK != true))
 	{
 		settingsRestoreDefaultSettings();
 		hasRestoredDefaultsettings = true;
 	}
+	else
+	{
+		settingsSequence = isValid[settingsActiveSlot] ? trailer[settingsActiveSlot].sequence : 0;
+
+		// The other slot is older (or invalid), so it all needs to be written on its next save
+		settingsSetDirtyRange(&nonVolatileSettings, sizeof(settingsStruct_t));
+		if (isValid[settingsActiveSlot])
+		{
+			settingsSlotDirtyRange[settingsActiveSlot].start = settingsSlotDirtyRange[settingsActiveSlot].end = 0;
+		}
+	}
 
 // Force Hotspot mode to off for existing RD-5R users.
 #if defined(PLATFORM_RD5R)
@@ -110,6 +267,31 @@ bool settingsLoadSettings(void)
 	return hasRestoredDefaultsettings;
 }
 
+_Static_assert(sizeof(struct_codeplugChannel_t) <= FLASH_STORE_MAX_RECORD_LENGTH, "A VFO must fit in one Flash store record");
+
+// The Flash store holds the VFOs saved by settingsSaveIfNeeded() since they were last written to the codeplug.
+// It is only available once the SPI Flash has been initialised, which is after settingsLoadSettings().
+void settingsLoadFlashStoreVFOs(void)
+{
+	struct_codeplugChannel_t vfo;
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (flashStoreRead(FLASH_STORE_KEY_VFO_A + i, (uint8_t *)&vfo, sizeof(struct_codeplugChannel_t)) == sizeof(struct_codeplugChannel_t))
+		{
+			memcpy(&settingsVFOChannel[i], &vfo, sizeof(struct_codeplugChannel_t));
+			settingsInitVFOChannel(i);
+		}
+	}
+}
+
+// Use the codeplug VFOs from now on, e.g. as the CPS may have written new ones
+void settingsDiscardFlashStoreVFOs(void)
+{
+	flashStoreDelete(FLASH_STORE_KEY_VFO_A);
+	flashStoreDelete(FLASH_STORE_KEY_VFO_B);
+}
+
 void settingsInitVFOChannel(int vfoNumber)
 {
 	// temporary hack in case the code plug has no RxGroup selected
@@ -251,7 +433,7 @@ void settingsRestoreDefaultSettings(void)
 
 	currentChannelData = &settingsVFOChannel[nonVolatileSettings.currentVFONumber];// Set the current channel data to point to the VFO data since the default screen will be the VFO
 
-	settingsDirty = true;
+	settingsSetDirty();
 
 	settingsSaveSettings(false);
 }
@@ -265,7 +447,7 @@ void enableVoicePromptsIfLoaded(void)
 #else
 		nonVolatileSettings.audioPromptMode =	AUDIO_PROMPT_MODE_VOICE_LEVEL_1;
 #endif
-		settingsDirty = true;
+		settingsSetDirty();
 		settingsSaveSettings(false);
 	}
 }
@@ -280,126 +462,148 @@ void settingsEraseCustomContent(void)
 void settingsSetBOOL(bool *s, bool v)
 {
 	*s = v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsSetINT8(int8_t *s, int8_t v)
 {
 	*s = v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsSetUINT8(uint8_t *s, uint8_t v)
 {
 	*s = v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsSetINT16(int16_t *s, int16_t v)
 {
 	*s = v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsSetUINT16(uint16_t *s, uint16_t v)
 {
 	*s = v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsSetINT32(int32_t *s, int32_t v)
 {
 	*s = v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsSetUINT32(uint32_t *s, uint32_t v)
 {
 	*s = v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsIncINT8(int8_t *s, int8_t v)
 {
 	*s = *s + v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsIncUINT8(uint8_t *s, uint8_t v)
 {
 	*s = *s + v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsIncINT16(int16_t *s, int16_t v)
 {
 	*s = *s + v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsIncUINT16(uint16_t *s, uint16_t v)
 {
 	*s = *s + v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsIncINT32(int32_t *s, int32_t v)
 {
 	*s = *s + v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsIncUINT32(uint32_t *s, uint32_t v)
 {
 	*s = *s + v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsDecINT8(int8_t *s, int8_t v)
 {
 	*s = *s - v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsDecUINT8(uint8_t *s, uint8_t v)
 {
 	*s = *s - v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsDecINT16(int16_t *s, int16_t v)
 {
 	*s = *s - v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsDecUINT16(uint16_t *s, uint16_t v)
 {
 	*s = *s - v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsDecINT32(int32_t *s, int32_t v)
 {
 	*s = *s - v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 
 void settingsDecUINT32(uint32_t *s, uint32_t v)
 {
 	*s = *s - v;
-	settingsSetDirty();
+	settingsSetDirtyRange(s, sizeof(*s));
 }
 // --- End of Helpers ---
 
 
+// Use this after changing nonVolatileSettings without the settingsSet/Increment/Decrement() macros
 void settingsSetDirty(void)
 {
-	settingsDirty = true;
+	settingsSetDirtyRange(&nonVolatileSettings, sizeof(settingsStruct_t));
+}
 
-#if defined(PLATFORM_RD5R)
-	dirtyTime = fw_millis();
-#endif
+// Use this to put back a copy of nonVolatileSettings (e.g. when a menu is cancelled), so only the bytes that differ get written
+void settingsRestoreFromCopy(const settingsStruct_t *original)
+{
+	const uint8_t *src = (const uint8_t *)original;
+	uint8_t *dst = (uint8_t *)&nonVolatileSettings;
+	int start = 0;
+	int end = sizeof(settingsStruct_t);
+
+	while ((start < end) && (src[start] == dst[start]))
+	{
+		start++;
+	}
+
+	while ((end > start) && (src[end - 1] == dst[end - 1]))
+	{
+		end--;
+	}
+
+	if (start < end)
+	{
+		memcpy(dst + start, src + start, end - start);
+		settingsSetDirtyRange(dst + start, end - start);
+	}
 }
 
 void settingsSetVFODirty(void)
@@ -419,7 +623,16 @@ void settingsSaveIfNeeded(bool immediately)
 
 	if ((settingsDirty || settingsVFODirty) && (immediately || ((fw_millis() - dirtyTime) > DIRTY_DURTION_MILLISECS))) // DIRTY_DURTION_ has passed since last change
 	{
-		settingsSaveSettings(settingsVFODirty);
+		// The VFOs change with every frequency step, so they are appended to the Flash store, which spreads the wear,
+		// rather than rewriting the codeplug EEPROM page every time. They go to the codeplug, where the CPS reads them,
+		// when it asks for them or with SK1 + SK2, in settingsSaveSettings(true).
+		if (settingsVFODirty &&
+				flashStoreWrite(FLASH_STORE_KEY_VFO_A, (uint8_t *)&settingsVFOChannel[CHANNEL_VFO_A], sizeof(struct_codeplugChannel_t)) &&
+				flashStoreWrite(FLASH_STORE_KEY_VFO_B, (uint8_t *)&settingsVFOChannel[CHANNEL_VFO_B], sizeof(struct_codeplugChannel_t)))
+		{
+			settingsVFODirty = false;
+		}
+		settingsSaveSettings(settingsVFODirty);// If the Flash store can't take the VFOs, they go to the codeplug as before
 	}
 #endif
 }
@@ -19,25 +19,58 @@
 #include <HR-C6000.h>
 #include <settings.h>
 #include <sound.h>
+#include <ticks.h>
 
 static void soundBeepTask(void *data);
-typedef union byteSwap16
+
+/*
+ * Beep tone generator (DDS).
+ * The tone has a 32 bit phase accumulator, stepped once per 8kHz sample. The top 10 bits select a point on the sine wave,
+ * which is read from a quarter wave table and linearly interpolated using the next 8 bits.
+ */
+#define SOUND_DDS_SAMPLE_RATE       8000
+#define SOUND_DDS_STEP_PER_HZ       536871// 2^32 / SOUND_DDS_SAMPLE_RATE
+#define SOUND_DDS_QUARTER_BITS      8
+#define SOUND_DDS_QUARTER_SIZE      (1 << SOUND_DDS_QUARTER_BITS)
+#define SOUND_DDS_BLOCK_SAMPLES     16// the size of the C6000 beep buffer
+
+typedef struct
 {
-	int16_t byte16;
-	uint8_t bytes8[2];
-} byteSwap16_t;
-byteSwap16_t swapper;
+	uint32_t phase;
+	uint32_t step;
+	int freq;
+} soundDDSTone_t;
+
+static soundDDSTone_t soundDDSTone;
 
 TaskHandle_t fwBeepTaskHandle;
-__attribute__((section(".data.$RAM2"))) union sharedDataBuffer audioAndHotspotDataBuffer;
-__attribute__((section(".data.$RAM2"))) uint8_t spi_sound[NUM_I2S_BUFFERS][WAV_BUFFER_SIZE*2];
-volatile int  wavbuffer_read_idx;
-volatile int  wavbuffer_write_idx;
-volatile int wavbuffer_count;
+__attribute__((section(".data.$RAM2"), aligned(4))) union sharedDataBuffer audioAndHotspotDataBuffer;// word aligned for soundWaveToI2S() and soundI2SToWave()
+__attribute__((section(".data.$RAM2"), aligned(4))) uint8_t spi_sound[NUM_I2S_BUFFERS][WAV_BUFFER_SIZE*2];
+soundRing_t wavbufferRing = { .writeIdx = 0, .readIdx = 0, .size = WAV_BUFFER_COUNT };
 uint8_t *currentWaveBuffer;
 
 uint8_t *spi_soundBuf;
-static const int16_t sine_beep16[] =  {0,101,201,302,402,503,603,704,804,905,1005,1106,1206,1307,1407,1507,1608,1708,1809,1909,2009,2110,2210,2310,2410,2511,2611,2711,2811,2911,3012,3112,3212,3312,3412,3512,3612,3712,3811,3911,4011,4111,4210,4310,4410,4509,4609,4708,4808,4907,5007,5106,5205,5305,5404,5503,5602,5701,5800,5899,5998,6096,6195,6294,6393,6491,6590,6688,6786,6885,6983,7081,7179,7277,7375,7473,7571,7669,7767,7864,7962,8059,8157,8254,8351,8448,8545,8642,8739,8836,8933,9030,9126,9223,9319,9416,9512,9608,9704,9800,9896,9992,10087,10183,10278,10374,10469,10564,10659,10754,10849,10944,11039,11133,11228,11322,11417,11511,11605,11699,11793,11886,11980,12074,12167,12260,12353,12446,12539,12632,12725,12817,12910,13002,13094,13187,13279,13370,13462,13554,13645,13736,13828,13919,14010,14101,14191,14282,14372,14462,14553,14643,14732,14822,14912,15001,15090,15180,15269,15358,15446,15535,15623,15712,15800,15888,15976,16063,16151,16238,16325,16413,16499,16586,16673,16759,16846,16932,17018,17104,17189,17275,17360,17445,17530,17615,17700,17784,17869,17953,18037,18121,18204,18288,18371,18454,18537,18620,18703,18785,18868,18950,19032,19113,19195,19276,19357,19438,19519,19600,19680,19761,19841,19921,20000,20080,20159,20238,20317,20396,20475,20553,20631,20709,20787,20865,20942,21019,21096,21173,21250,21326,21403,21479,21554,21630,21705,21781,21856,21930,22005,22079,22154,22227,22301,22375,22448,22521,22594,22667,22739,22812,22884,22956,23027,23099,23170,23241,23311,23382,23452,23522,23592,23662,23731,23801,23870,23938,24007,24075,24143,24211,24279,24346,24413,24480,24547,24613,24680,24746,24811,24877,24942,25007,25072,25137,25201,25265,25329,25393,25456,25519,25582,25645,25708,25770,25832,25893,25955,26016,26077,26138,26198,26259,26319,26378,26438,26497,26556,26615,26674,26732,26790,26848,26905,26962,27019,27076,27133,27189,27245,27300,27356,27411,27466,27521,27575,27629,27683,27737,27790,27843,27896,27949,28001,28053,28105,28157,28208,28259,28310,28360,28411,28460,28510,28560,28609,28658,28706,28755,28803,28850,28898,28945,28992,29039,29085,29131,29177,29223,29268,29313,29358,29403,29447,29491,29534,29578,29621,29664,29706,29749,29791,29832,29874,29915,29956,29997,30037,30077,30117,30156,30195,30234,30273,30311,30349,30387,30424,30462,30498,30535,30571,30607,30643,30679,30714,30749,30783,30818,30852,30885,30919,30952,30985,31017,31050,31082,31113,31145,31176,31206,31237,31267,31297,31327,31356,31385,31414,31442,31470,31498,31526,31553,31580,31607,31633,31659,31685,31710,31736,31760,31785,31809,31833,31857,31880,31903,31926,31949,31971,31993,32014,32036,32057,32077,32098,32118,32137,32157,32176,32195,32213,32232,32250,32267,32285,32302,32318,32335,32351,32367,32382,32397,32412,32427,32441,32455,32469,32482,32495,32508,32521,32533,32545,32556,32567,32578,32589,32599,32609,32619,32628,32637,32646,32655,32663,32671,32678,32685,32692,32699,32705,32711,32717,32722,32728,32732,32737,32741,32745,32748,32752,32755,32757,32759,32761,32763,32765,32766,32766,32767,32767,32767,32766,32766,32765,32763,32761,32759,32757,32755,32752,32748,32745,32741,32737,32732,32728,32722,32717,32711,32705,32699,32692,32685,32678,32671,32663,32655,32646,32637,32628,32619,32609,32599,32589,32578,32567,32556,32545,32533,32521,32508,32495,32482,32469,32455,32441,32427,32412,32397,32382,32367,32351,32335,32318,32302,32285,32267,32250,32232,32213,32195,32176,32157,32137,32118,32098,32077,32057,32036,32014,31993,31971,31949,31926,31903,31880,31857,31833,31809,31785,31760,31736,31710,31685,31659,31633,31607,31580,31553,31526,31498,31470,31442,31414,31385,31356,31327,31297,31267,31237,31206,31176,31145,31113,31082,31050,31017,30985,30952,30919,30885,30852,30818,30783,30749,30714,30679,30643,30607,30571,30535,30498,30462,30424,30387,30349,30311,30273,30234,30195,30156,30117,30077,30037,29997,29956,29915,29874,29832,29791,29749,29706,29664,29621,29578,29534,29491,29447,29403,29358,29313,29268,29223,29177,29131,29085,29039,28992,28945,28898,28850,28803,28755,28706,28658,28609,28560,28510,28460,28411,28360,28310,28259,28208,28157,28105,28053,28001,27949,27896,27843,27790,27737,27683,27629,27575,27521,27466,27411,27356,27300,27245,27189,27133,27076,27019,26962,26905,26848,26790,26732,26674,26615,26556,26497,26438,26378,26319,26259,26198,26138,26077,26016,25955,25893,25832,25770,25708,25645,25582,25519,25456,25393,25329,25265,25201,25137,25072,25007,24942,24877,24811,24746,24680,24613,24547,24480,24413,24346,24279,24211,24143,24075,24007,23938,23870,23801,23731,23662,23592,23522,23452,23382,23311,23241,23170,23099,23027,22956,22884,22812,22739,22667,22594,22521,22448,22375,22301,22227,22154,22079,22005,21930,21856,21781,21705,21630,21554,21479,21403,21326,21250,21173,21096,21019,20942,20865,20787,20709,20631,20553,20475,20396,20317,20238,20159,20080,20000,19921,19841,19761,19680,19600,19519,19438,19357,19276,19195,19113,19032,18950,18868,18785,18703,18620,18537,18454,18371,18288,18204,18121,18037,17953,17869,17784,17700,17615,17530,17445,17360,17275,17189,17104,17018,16932,16846,16759,16673,16586,16499,16413,16325,16238,16151,16063,15976,15888,15800,15712,15623,15535,15446,15358,15269,15180,15090,15001,14912,14822,14732,14643,14553,14462,14372,14282,14191,14101,14010,13919,13828,13736,13645,13554,13462,13370,13279,13187,13094,13002,12910,12817,12725,12632,12539,12446,12353,12260,12167,12074,11980,11886,11793,11699,11605,11511,11417,11322,11228,11133,11039,10944,10849,10754,10659,10564,10469,10374,10278,10183,10087,9992,9896,9800,9704,9608,9512,9416,9319,9223,9126,9030,8933,8836,8739,8642,8545,8448,8351,8254,8157,8059,7962,7864,7767,7669,7571,7473,7375,7277,7179,7081,6983,6885,6786,6688,6590,6491,6393,6294,6195,6096,5998,5899,5800,5701,5602,5503,5404,5305,5205,5106,5007,4907,4808,4708,4609,4509,4410,4310,4210,4111,4011,3911,3811,3712,3612,3512,3412,3312,3212,3112,3012,2911,2811,2711,2611,2511,2410,2310,2210,2110,2009,1909,1809,1708,1608,1507,1407,1307,1206,1106,1005,905,804,704,603,503,402,302,201,101,0,-101,-201,-302,-402,-503,-603,-704,-804,-905,-1005,-1106,-1206,-1307,-1407,-1507,-1608,-1708,-1809,-1909,-2009,-2110,-2210,-2310,-2410,-2511,-2611,-2711,-2811,-2911,-3012,-3112,-3212,-3312,-3412,-3512,-3612,-3712,-3811,-3911,-4011,-4111,-4210,-4310,-4410,-4509,-4609,-4708,-4808,-4907,-5007,-5106,-5205,-5305,-5404,-5503,-5602,-5701,-5800,-5899,-5998,-6096,-6195,-6294,-6393,-6491,-6590,-6688,-6786,-6885,-6983,-7081,-7179,-7277,-7375,-7473,-7571,-7669,-7767,-7864,-7962,-8059,-8157,-8254,-8351,-8448,-8545,-8642,-8739,-8836,-8933,-9030,-9126,-9223,-9319,-9416,-9512,-9608,-9704,-9800,-9896,-9992,-10087,-10183,-10278,-10374,-10469,-10564,-10659,-10754,-10849,-10944,-11039,-11133,-11228,-11322,-11417,-11511,-11605,-11699,-11793,-11886,-11980,-12074,-12167,-12260,-12353,-12446,-12539,-12632,-12725,-12817,-12910,-13002,-13094,-13187,-13279,-13370,-13462,-13554,-13645,-13736,-13828,-13919,-14010,-14101,-14191,-14282,-14372,-14462,-14553,-14643,-14732,-14822,-14912,-15001,-15090,-15180,-15269,-15358,-15446,-15535,-15623,-15712,-15800,-15888,-15976,-16063,-16151,-16238,-16325,-16413,-16499,-16586,-16673,-16759,-16846,-16932,-17018,-17104,-17189,-17275,-17360,-17445,-17530,-17615,-17700,-17784,-17869,-17953,-18037,-18121,-18204,-18288,-18371,-18454,-18537,-18620,-18703,-18785,-18868,-18950,-19032,-19113,-19195,-19276,-19357,-19438,-19519,-19600,-19680,-19761,-19841,-19921,-20000,-20080,-20159,-20238,-20317,-20396,-20475,-20553,-20631,-20709,-20787,-20865,-20942,-21019,-21096,-21173,-21250,-21326,-21403,-21479,-21554,-21630,-21705,-21781,-21856,-21930,-22005,-22079,-22154,-22227,-22301,-22375,-22448,-22521,-22594,-22667,-22739,-22812,-22884,-22956,-23027,-23099,-23170,-23241,-23311,-23382,-23452,-23522,-23592,-23662,-23731,-23801,-23870,-23938,-24007,-24075,-24143,-24211,-24279,-24346,-24413,-24480,-24547,-24613,-24680,-24746,-24811,-24877,-24942,-25007,-25072,-25137,-25201,-25265,-25329,-25393,-25456,-25519,-25582,-25645,-25708,-25770,-25832,-25893,-25955,-26016,-26077,-26138,-26198,-26259,-26319,-26378,-26438,-26497,-26556,-26615,-26674,-26732,-26790,-26848,-26905,-26962,-27019,-27076,-27133,-27189,-27245,-27300,-27356,-27411,-27466,-27521,-27575,-27629,-27683,-27737,-27790,-27843,-27896,-27949,-28001,-28053,-28105,-28157,-28208,-28259,-28310,-28360,-28411,-28460,-28510,-28560,-28609,-28658,-28706,-28755,-28803,-28850,-28898,-28945,-28992,-29039,-29085,-29131,-29177,-29223,-29268,-29313,-29358,-29403,-29447,-29491,-29534,-29578,-29621,-29664,-29706,-29749,-29791,-29832,-29874,-29915,-29956,-29997,-30037,-30077,-30117,-30156,-30195,-30234,-30273,-30311,-30349,-30387,-30424,-30462,-30498,-30535,-30571,-30607,-30643,-30679,-30714,-30749,-30783,-30818,-30852,-30885,-30919,-30952,-30985,-31017,-31050,-31082,-31113,-31145,-31176,-31206,-31237,-31267,-31297,-31327,-31356,-31385,-31414,-31442,-31470,-31498,-31526,-31553,-31580,-31607,-31633,-31659,-31685,-31710,-31736,-31760,-31785,-31809,-31833,-31857,-31880,-31903,-31926,-31949,-31971,-31993,-32014,-32036,-32057,-32077,-32098,-32118,-32137,-32157,-32176,-32195,-32213,-32232,-32250,-32267,-32285,-32302,-32318,-32335,-32351,-32367,-32382,-32397,-32412,-32427,-32441,-32455,-32469,-32482,-32495,-32508,-32521,-32533,-32545,-32556,-32567,-32578,-32589,-32599,-32609,-32619,-32628,-32637,-32646,-32655,-32663,-32671,-32678,-32685,-32692,-32699,-32705,-32711,-32717,-32722,-32728,-32732,-32737,-32741,-32745,-32748,-32752,-32755,-32757,-32759,-32761,-32763,-32765,-32766,-32766,-32767,-32767,-32767,-32766,-32766,-32765,-32763,-32761,-32759,-32757,-32755,-32752,-32748,-32745,-32741,-32737,-32732,-32728,-32722,-32717,-32711,-32705,-32699,-32692,-32685,-32678,-32671,-32663,-32655,-32646,-32637,-32628,-32619,-32609,-32599,-32589,-32578,-32567,-32556,-32545,-32533,-32521,-32508,-32495,-32482,-32469,-32455,-32441,-32427,-32412,-32397,-32382,-32367,-32351,-32335,-32318,-32302,-32285,-32267,-32250,-32232,-32213,-32195,-32176,-32157,-32137,-32118,-32098,-32077,-32057,-32036,-32014,-31993,-31971,-31949,-31926,-31903,-31880,-31857,-31833,-31809,-31785,-31760,-31736,-31710,-31685,-31659,-31633,-31607,-31580,-31553,-31526,-31498,-31470,-31442,-31414,-31385,-31356,-31327,-31297,-31267,-31237,-31206,-31176,-31145,-31113,-31082,-31050,-31017,-30985,-30952,-30919,-30885,-30852,-30818,-30783,-30749,-30714,-30679,-30643,-30607,-30571,-30535,-30498,-30462,-30424,-30387,-30349,-30311,-30273,-30234,-30195,-30156,-30117,-30077,-30037,-29997,-29956,-29915,-29874,-29832,-29791,-29749,-29706,-29664,-29621,-29578,-29534,-29491,-29447,-29403,-29358,-29313,-29268,-29223,-29177,-29131,-29085,-29039,-28992,-28945,-28898,-28850,-28803,-28755,-28706,-28658,-28609,-28560,-28510,-28460,-28411,-28360,-28310,-28259,-28208,-28157,-28105,-28053,-28001,-27949,-27896,-27843,-27790,-27737,-27683,-27629,-27575,-27521,-27466,-27411,-27356,-27300,-27245,-27189,-27133,-27076,-27019,-26962,-26905,-26848,-26790,-26732,-26674,-26615,-26556,-26497,-26438,-26378,-26319,-26259,-26198,-26138,-26077,-26016,-25955,-25893,-25832,-25770,-25708,-25645,-25582,-25519,-25456,-25393,-25329,-25265,-25201,-25137,-25072,-25007,-24942,-24877,-24811,-24746,-24680,-24613,-24547,-24480,-24413,-24346,-24279,-24211,-24143,-24075,-24007,-23938,-23870,-23801,-23731,-23662,-23592,-23522,-23452,-23382,-23311,-23241,-23170,-23099,-23027,-22956,-22884,-22812,-22739,-22667,-22594,-22521,-22448,-22375,-22301,-22227,-22154,-22079,-22005,-21930,-21856,-21781,-21705,-21630,-21554,-21479,-21403,-21326,-21250,-21173,-21096,-21019,-20942,-20865,-20787,-20709,-20631,-20553,-20475,-20396,-20317,-20238,-20159,-20080,-20000,-19921,-19841,-19761,-19680,-19600,-19519,-19438,-19357,-19276,-19195,-19113,-19032,-18950,-18868,-18785,-18703,-18620,-18537,-18454,-18371,-18288,-18204,-18121,-18037,-17953,-17869,-17784,-17700,-17615,-17530,-17445,-17360,-17275,-17189,-17104,-17018,-16932,-16846,-16759,-16673,-16586,-16499,-16413,-16325,-16238,-16151,-16063,-15976,-15888,-15800,-15712,-15623,-15535,-15446,-15358,-15269,-15180,-15090,-15001,-14912,-14822,-14732,-14643,-14553,-14462,-14372,-14282,-14191,-14101,-14010,-13919,-13828,-13736,-13645,-13554,-13462,-13370,-13279,-13187,-13094,-13002,-12910,-12817,-12725,-12632,-12539,-12446,-12353,-12260,-12167,-12074,-11980,-11886,-11793,-11699,-11605,-11511,-11417,-11322,-11228,-11133,-11039,-10944,-10849,-10754,-10659,-10564,-10469,-10374,-10278,-10183,-10087,-9992,-9896,-9800,-9704,-9608,-9512,-9416,-9319,-9223,-9126,-9030,-8933,-8836,-8739,-8642,-8545,-8448,-8351,-8254,-8157,-8059,-7962,-7864,-7767,-7669,-7571,-7473,-7375,-7277,-7179,-7081,-6983,-6885,-6786,-6688,-6590,-6491,-6393,-6294,-6195,-6096,-5998,-5899,-5800,-5701,-5602,-5503,-5404,-5305,-5205,-5106,-5007,-4907,-4808,-4708,-4609,-4509,-4410,-4310,-4210,-4111,-4011,-3911,-3811,-3712,-3612,-3512,-3412,-3312,-3212,-3112,-3012,-2911,-2811,-2711,-2611,-2511,-2410,-2310,-2210,-2110,-2009,-1909,-1809,-1708,-1608,-1507,-1407,-1307,-1206,-1106,-1005,-905,-804,-704,-603,-503,-402,-302,-201,-101,};
+// Quarter of a sine wave, with the peak as the last entry so the interpolation doesn't need to wrap
+static const int16_t soundDDSQuarterSine[SOUND_DDS_QUARTER_SIZE + 1] =
+{
+	0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809, 2009, 2210, 2410, 2611, 2811, 3012,
+	3212, 3412, 3612, 3811, 4011, 4210, 4410, 4609, 4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195,
+	6393, 6590, 6786, 6983, 7179, 7375, 7571, 7767, 7962, 8157, 8351, 8545, 8739, 8933, 9126, 9319,
+	9512, 9704, 9896, 10087, 10278, 10469, 10659, 10849, 11039, 11228, 11417, 11605, 11793, 11980, 12167, 12353,
+	12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828, 14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269,
+	15446, 15623, 15800, 15976, 16151, 16325, 16499, 16673, 16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+	18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357, 19519, 19680, 19841, 20000, 20159, 20317, 20475, 20631,
+	20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856, 22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027,
+	23170, 23311, 23452, 23592, 23731, 23870, 24007, 24143, 24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+	25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198, 26319, 26438, 26556, 26674, 26790, 26905, 27019, 27133,
+	27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001, 28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803,
+	28898, 28992, 29085, 29177, 29268, 29358, 29447, 29534, 29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+	30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783, 30852, 30919, 30985, 31050, 31113, 31176, 31237, 31297,
+	31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736, 31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098,
+	32137, 32176, 32213, 32250, 32285, 32318, 32351, 32382, 32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+	32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717, 32728, 32737, 32745, 32752, 32757, 32761, 32765, 32766,
+	32767
+};
 volatile int sine_beep_freq;
 volatile int sine_beep_duration;
 volatile int micAudioSamplesTotal;
@@ -46,6 +79,32 @@ static volatile uint32_t runningMaxValue = 0;
 static const int MIC_AVERAGE_COUNTER_RELOAD = 10;
 static volatile int micAudioAverageCounter = MIC_AVERAGE_COUNTER_RELOAD;
 
+/*
+ * DMR RX playout buffer.
+ * Each decoded DMR frame adds 6 wave buffers (60mS) to the ring. Rather than always waiting for a second frame,
+ * playback of an over starts once the first frame has been held for a delay which follows the arrival jitter of the frames,
+ * so a clean RF signal gets a short delay and jittery network audio (e.g. through a hotspot) gets a longer one.
+ * If the ring runs dry during an over, the last buffer is repeated while fading out, instead of stopping with a click.
+ */
+#define SOUND_DMR_FRAME_MS             60
+#define SOUND_PLAYOUT_MIN_DELAY_MS     20// allows for the decode time and the 10mS HR-C6000 tick
+#define SOUND_PLAYOUT_MAX_DELAY_MS     100// the first two frames must fit in the ring with room for the third
+#define SOUND_PLAYOUT_JITTER_FACTOR    3
+#define SOUND_STREAM_GAP_MS            360// frames further apart than this are in different overs
+#define SOUND_CONCEAL_BUFFERS          3
+
+soundPlayoutStats_t soundPlayoutStats = { .delayMs = SOUND_DMR_FRAME_MS };
+static int32_t soundPlayoutJitterX16;// jitter in mS * 16
+static uint32_t soundPlayoutLastArrival;
+static bool soundPlayoutHasArrival = false;
+static bool soundPlayoutWaiting = false;
+static uint32_t soundPlayoutWaitStart;
+static volatile bool soundConcealEnabled = false;// only DMR RX audio is concealed, not voice prompts
+static volatile int soundConcealRemaining;
+static volatile bool soundPlayoutRanDry = false;
+static volatile uint32_t soundPlayoutRanDryTime;
+static uint8_t *soundLastSentBuf;// the last buffer of real audio, which is not reused by the concealment as there are NUM_I2S_BUFFERS
+
 __attribute__((section(".data.$RAM2"))) int melody_generic[512];// Note. As we don't play long melodies, I think this value can be made smaller.
 #define DIT_LENGTH  60
 #define DAH_LENGTH  3 * DIT_LENGTH
@@ -188,9 +247,11 @@ void soundInit(void)
 {
 	I2SReset();
 	spi_soundBuf=NULL;
-	wavbuffer_read_idx = 0;
-	wavbuffer_write_idx = 0;
-	wavbuffer_count = 0;
+	soundRingReset((settingsUsbMode == USB_MODE_HOTSPOT) ? HOTSPOT_BUFFER_COUNT : WAV_BUFFER_COUNT);
+	soundPlayoutWaiting = false;
+	soundConcealEnabled = false;
+	soundConcealRemaining = 0;
+	soundPlayoutRanDry = false;
 }
 
 void soundTerminateSound(void)
@@ -200,64 +261,120 @@ void soundTerminateSound(void)
 
 void soundSetupBuffer(void)
 {
-	currentWaveBuffer = (uint8_t *)audioAndHotspotDataBuffer.wavbuffer[wavbuffer_write_idx];// cast just to prevent compiler warning
+	currentWaveBuffer = (uint8_t *)audioAndHotspotDataBuffer.wavbuffer[soundRingWriteBuffer()];// cast just to prevent compiler warning
 }
 
+// If the ring is full the buffer is decoded into again, as before
 void soundStoreBuffer(void)
 {
-	taskENTER_CRITICAL();
-	int tmp_wavbuffer_count = wavbuffer_count;
-
-	if (tmp_wavbuffer_count < WAV_BUFFER_COUNT)
+	if (soundRingCount() < WAV_BUFFER_COUNT)
 	{
-		wavbuffer_write_idx++;
-		if (wavbuffer_write_idx >= WAV_BUFFER_COUNT)
-		{
-			wavbuffer_write_idx = 0;
-		}
-		wavbuffer_count++;
+		soundRingAdvanceWrite();
 	}
-	taskEXIT_CRITICAL();
 }
 
+// If the ring is empty currentWaveBuffer is left as it is
 void soundRetrieveBuffer(void)
 {
-	taskENTER_CRITICAL();
-	if (wavbuffer_count > 0)
+	if (soundRingCount() > 0)
+	{
+		currentWaveBuffer = (uint8_t *)audioAndHotspotDataBuffer.wavbuffer[soundRingReadBuffer()];// cast just to prevent compiler warning
+		soundRingAdvanceRead();
+	}
+}
+
+/*
+ * The I2S buffers hold a 32 bit stereo frame per sample, with the sample in the upper 16 bits (the channel used by the C6000)
+ * and the other channel in the lower 16 bits. Both layouts are little endian, so there is no byte swapping to do, and the
+ * samples are moved two at a time with word reads and writes.
+ */
+static void soundWaveToI2S(const volatile uint8_t *wave, uint8_t *i2s)
+{
+	const uint32_t *src = (const uint32_t *)wave;
+	uint32_t *dst = (uint32_t *)i2s;
+
+	for (int i = 0; i < (WAV_BUFFER_SIZE / 4); i++)
+	{
+		uint32_t samples = *src++;
+
+		*dst++ = samples << 16;// the other channel is sent as silence
+		*dst++ = samples & 0xFFFF0000;
+	}
+}
+
+// Returns the peak level of the samples
+static uint32_t soundI2SToWave(const uint8_t *i2s, volatile uint8_t *wave)
+{
+	const uint32_t *src = (const uint32_t *)i2s;
+	uint32_t *dst = (uint32_t *)wave;
+	uint32_t peak = 0;
+
+	for (int i = 0; i < (WAV_BUFFER_SIZE / 4); i++)
 	{
-		currentWaveBuffer = (uint8_t *)audioAndHotspotDataBuffer.wavbuffer[wavbuffer_read_idx];// cast just to prevent compiler warning
-		wavbuffer_read_idx++;
-		if (wavbuffer_read_idx >= WAV_BUFFER_COUNT)
+		uint32_t frame1 = *src++;
+		uint32_t frame2 = *src++;
+		uint32_t level1 = abs((int16_t)(frame1 >> 16));
+		uint32_t level2 = abs((int16_t)(frame2 >> 16));
+
+		*dst++ = __PKHTB(frame2, frame1, 16);
+
+		if (level1 > peak)
+		{
+			peak = level1;
+		}
+
+		if (level2 > peak)
 		{
-			wavbuffer_read_idx = 0;
+			peak = level2;
 		}
-		wavbuffer_count--;
 	}
-	taskEXIT_CRITICAL();
+
+	return peak;
 }
 
+// Repeat the last buffer of audio, with the volume ramping down to zero over SOUND_CONCEAL_BUFFERS buffers
+static void soundConcealBuffer(const uint8_t *lastI2S, uint8_t *i2s)
+{
+	const uint32_t *src = (const uint32_t *)lastI2S;
+	uint32_t *dst = (uint32_t *)i2s;
+	int startGain = (soundConcealRemaining * 256) / SOUND_CONCEAL_BUFFERS;// 256 is full volume
+
+	for (int i = 0; i < (WAV_BUFFER_SIZE / 2); i++)
+	{
+		int gain = startGain - ((i * 256) / (SOUND_CONCEAL_BUFFERS * (WAV_BUFFER_SIZE / 2)));
+		int32_t sample = (((int16_t)(src[i] >> 16)) * gain) >> 8;
+
+		dst[i] = ((uint32_t)sample) << 16;
+	}
+}
 
 // This function is used when receiving
 void soundSendData(void)
 {
-	if (wavbuffer_count > 0)
+	if (soundRingCount() > 0)
 	{
 		spi_soundBuf = spi_sound[g_SAI_TX_Handle.queueUser];
+		soundWaveToI2S(audioAndHotspotDataBuffer.wavbuffer[soundRingReadBuffer()], spi_soundBuf);
 
-		for (int i = 0; i < (WAV_BUFFER_SIZE / 2); i++)
+		soundRingAdvanceRead();// The data has been copied, so the buffer can be reused while it is being sent
+		soundConcealRemaining = (soundConcealEnabled ? SOUND_CONCEAL_BUFFERS : 0);
+		soundLastSentBuf = spi_soundBuf;
+		I2STransferTransmit(spi_soundBuf,WAV_BUFFER_SIZE * 2);
+	}
+	else if (soundConcealRemaining > 0)
+	{
+		if (soundPlayoutRanDry == false)
 		{
-			*(spi_soundBuf + 4 * i + 3) = audioAndHotspotDataBuffer.wavbuffer[wavbuffer_read_idx][2 * i + 1];
-			*(spi_soundBuf + 4 * i + 2) = audioAndHotspotDataBuffer.wavbuffer[wavbuffer_read_idx][2 * i];
+			soundPlayoutRanDryTime = fw_millis();
+			soundPlayoutRanDry = true;
 		}
 
-		I2STransferTransmit(spi_soundBuf,WAV_BUFFER_SIZE * 2);
+		spi_soundBuf = spi_sound[g_SAI_TX_Handle.queueUser];
+		soundConcealBuffer(soundLastSentBuf, spi_soundBuf);
 
-		wavbuffer_read_idx++;
-		if (wavbuffer_read_idx >= WAV_BUFFER_COUNT)
-		{
-			wavbuffer_read_idx = 0;
-		}
-		wavbuffer_count--;
+		soundConcealRemaining--;
+		soundPlayoutStats.concealedBuffers++;
+		I2STransferTransmit(spi_soundBuf,WAV_BUFFER_SIZE * 2);
 	}
 }
 
@@ -269,22 +386,18 @@ void soundReceiveData(void)
 		return;
 	}
 
-	if (wavbuffer_count < WAV_BUFFER_COUNT)
+	if (soundRingCount() < WAV_BUFFER_COUNT)
 	{
 		// spi_soundBuf == NULL  happens the first time through there is no previously sampled buffer to load into the wave buffer
 		if (spi_soundBuf != NULL)
 		{
-			for (int i = 0; i < (WAV_BUFFER_SIZE / 2); i++)
+			uint32_t peak = soundI2SToWave(spi_soundBuf, audioAndHotspotDataBuffer.wavbuffer[soundRingWriteBuffer()]);
+
+			if (peak > runningMaxValue)
 			{
-				swapper.bytes8[1] = *(spi_soundBuf + 4 * i + 3);
-				audioAndHotspotDataBuffer.wavbuffer[wavbuffer_write_idx][ 2 * i + 1] = swapper.bytes8[1];
-				swapper.bytes8[0] = *(spi_soundBuf + 4 * i + 2);
-				audioAndHotspotDataBuffer.wavbuffer[wavbuffer_write_idx][2 * i] = swapper.bytes8[0];
-				if (abs(swapper.byte16) > runningMaxValue)
-				{
-					runningMaxValue = abs(swapper.byte16);
-				}
+				runningMaxValue = peak;
 			}
+
 			if (micAudioAverageCounter-- == 0)
 			{
 				micAudioAverageCounter = MIC_AVERAGE_COUNTER_RELOAD;
@@ -292,13 +405,7 @@ void soundReceiveData(void)
 				runningMaxValue = 0;
 			}
 
-			wavbuffer_write_idx++;
-
-			if (wavbuffer_write_idx >= WAV_BUFFER_COUNT)
-			{
-				wavbuffer_write_idx = 0;
-			}
-			wavbuffer_count++;
+			soundRingAdvanceWrite();
 		}
 
 		spi_soundBuf = spi_sound[g_SAI_RX_Handle.queueUser];
@@ -306,13 +413,73 @@ void soundReceiveData(void)
 	}
 }
 
+// Called after each DMR frame has been decoded into the wave buffers
+void soundRXFrameDecoded(void)
+{
+	uint32_t now = fw_millis();
+
+	if (soundPlayoutHasArrival && ((now - soundPlayoutLastArrival) < SOUND_STREAM_GAP_MS))
+	{
+		// Smoothed as in RFC 3550
+		int32_t deviation = abs((int32_t)(now - soundPlayoutLastArrival) - SOUND_DMR_FRAME_MS);
+
+		soundPlayoutJitterX16 += deviation - (soundPlayoutJitterX16 >> 4);
+		soundPlayoutStats.jitterMs = soundPlayoutJitterX16 >> 4;
+	}
+	soundPlayoutLastArrival = now;
+	soundPlayoutHasArrival = true;
+
+	if (soundPlayoutRanDry)
+	{
+		// The ring emptied before this frame arrived. Only count it if it was during the same over
+		if ((now - soundPlayoutRanDryTime) < SOUND_STREAM_GAP_MS)
+		{
+			soundPlayoutStats.underruns++;
+		}
+		soundPlayoutRanDry = false;
+	}
+
+	if (!g_TX_SAI_in_use && !soundPlayoutWaiting)
+	{
+		soundPlayoutWaiting = true;
+		soundPlayoutWaitStart = now;
+	}
+}
+
+// Called from the HR-C6000 tick, starts the playback once the first frame of an over has been held for the playout delay
+void soundTickRXPlayout(void)
+{
+	uint32_t delay;
+
+	if (!soundPlayoutWaiting || g_TX_SAI_in_use)
+	{
+		return;
+	}
+
+	delay = SOUND_PLAYOUT_MIN_DELAY_MS + (SOUND_PLAYOUT_JITTER_FACTOR * soundPlayoutStats.jitterMs);
+	if (delay > SOUND_PLAYOUT_MAX_DELAY_MS)
+	{
+		delay = SOUND_PLAYOUT_MAX_DELAY_MS;
+	}
+	soundPlayoutStats.delayMs = delay;
+
+	if (((fw_millis() - soundPlayoutWaitStart) >= delay) || (soundRingCount() > (WAV_BUFFER_COUNT - 6)))
+	{
+		soundPlayoutWaiting = false;
+		soundConcealEnabled = true;
+		soundSendData();
+	}
+}
+
+// Used by the voice prompts, which fill the ring as fast as it empties
 void soundTickRXBuffer(void)
 {
 	// The AMBE codec decodes 1 DMR frame into 6 buffers.
 	// Hence waiting for more than 6 buffers delays the sound playback by 1 DMR frame which gives some effective bufffering
 	// Max value for this is 12, as the total number of buffers is 18.
-    if (!g_TX_SAI_in_use && wavbuffer_count > 6)
+    if (!g_TX_SAI_in_use && (soundRingCount() > 6))
     {
+    	soundConcealEnabled = false;
     	soundSendData();
     }
 }
@@ -373,12 +540,65 @@ void soundTickMelody(void)
 }
 
 
+static int16_t soundDDSSample(soundDDSTone_t *tone)
+{
+	uint32_t index = tone->phase >> (32 - (SOUND_DDS_QUARTER_BITS + 2));
+	uint32_t fraction = (tone->phase >> (32 - (SOUND_DDS_QUARTER_BITS + 2) - 8)) & 0xFF;
+	uint32_t position = index & (SOUND_DDS_QUARTER_SIZE - 1);
+	int32_t sample1, sample2;
+
+	if (index & SOUND_DDS_QUARTER_SIZE)
+	{
+		// second and fourth quarters run back down the table
+		sample1 = soundDDSQuarterSine[SOUND_DDS_QUARTER_SIZE - position];
+		sample2 = soundDDSQuarterSine[SOUND_DDS_QUARTER_SIZE - position - 1];
+	}
+	else
+	{
+		sample1 = soundDDSQuarterSine[position];
+		sample2 = soundDDSQuarterSine[position + 1];
+	}
+
+	sample1 += ((sample2 - sample1) * (int32_t)fraction) >> 8;
+
+	tone->phase += tone->step;
+
+	return ((index & (2 * SOUND_DDS_QUARTER_SIZE)) ? -sample1 : sample1);// second half of the wave is negative
+}
+
+static void soundDDSSetFrequency(soundDDSTone_t *tone, int freq)
+{
+	if (freq != tone->freq)
+	{
+		// The phase is kept, so there is no click when the frequency changes
+		tone->freq = freq;
+		tone->step = freq * SOUND_DDS_STEP_PER_HZ;
+	}
+}
+
+// Renders a whole block for the C6000 beep buffer, as big endian samples
+static void soundDDSRenderBlock(uint32_t *block)
+{
+	soundDDSSetFrequency(&soundDDSTone, sine_beep_freq);
+
+	for (int i = 0; i < (SOUND_DDS_BLOCK_SAMPLES / 2); i++)
+	{
+		int32_t samples[2];
+
+		for (int j = 0; j < 2; j++)
+		{
+			samples[j] = soundDDSSample(&soundDDSTone) >> soundBeepVolumeDivider;
+		}
+
+		block[i] = __REV16(((uint32_t)samples[0] & 0xFFFF) | ((uint32_t)samples[1] << 16));// unsigned, as shifting a negative sample is undefined
+	}
+}
+
 static void soundBeepTask(void *data)
 {
 	uint8_t tmp_val;
-	int beep_idx = 0;
 	bool beep = false;
-	uint8_t spi_sound[32];
+	uint32_t spi_sound[SOUND_DDS_BLOCK_SAMPLES / 2];
 
     while (1U)
     {
@@ -402,21 +622,8 @@ static void soundBeepTask(void *data)
     			SPI0ReadPageRegByte(0x04, 0x88, &tmp_val);
     			if ( !(tmp_val & 1))
     			{
-    				for (int i = 0; i < 16; i++)
-    				{
-    					swapper.byte16 = ((int)sine_beep16[beep_idx]) >> soundBeepVolumeDivider;
-    					spi_sound[2 * i + 1] = swapper.bytes8[0];// low byte
-    					spi_sound[2 * i] = swapper.bytes8[1];// high byte
-    					if (sine_beep_freq != 0)
-    					{
-							beep_idx = beep_idx + (int)(sine_beep_freq / 3.915f);
-    						if (beep_idx >= 0x0800)
-    						{
-    							beep_idx = beep_idx - 0x0800;
-    						}
-    					}
-    				}
-    				SPI0WritePageRegByteArray(0x03, 0x00, spi_sound, 0x20);
+    				soundDDSRenderBlock(spi_sound);
+    				SPI0WritePageRegByteArray(0x03, 0x00, (uint8_t *)spi_sound, sizeof(spi_sound));
     			}
 
     			sine_beep_duration--;
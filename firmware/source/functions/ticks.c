@@ -17,13 +17,57 @@
  */
 
 #include <ticks.h>
+#include <functions/flashStore.h>
 
-#define PIT_COUNTS_PER_MS  10U
+#define PIT_COUNTS_PER_MS               10U
+#define OPERATING_TIME_SAVE_INTERVAL_S  (10U * 60U)// one 8 byte record, so a Flash store sector lasts about 3 days
 
 extern volatile uint32_t PITCounter;
 
+static uint32_t operatingTimeSeconds;
+static uint32_t operatingTimeSavedSeconds;
+static uint32_t operatingTimeLastMillis;
+static uint32_t operatingTimeRemainderMs;
+
 uint32_t fw_millis(void)
 {
 	return (PITCounter / PIT_COUNTS_PER_MS);
 }
 
+// The operating time is kept in the Flash store, so it carries on from where it was at the last power off
+void fw_operatingTimeInit(void)
+{
+	if (flashStoreRead(FLASH_STORE_KEY_OPERATING_TIME, (uint8_t *)&operatingTimeSeconds, sizeof(uint32_t)) != sizeof(uint32_t))
+	{
+		operatingTimeSeconds = 0;
+	}
+
+	operatingTimeSavedSeconds = operatingTimeSeconds;
+	operatingTimeLastMillis = fw_millis();
+	operatingTimeRemainderMs = operatingTimeLastMillis;// time since power on
+}
+
+// Called from the main loop, and with forceSave at power off
+void fw_operatingTimeTick(bool forceSave)
+{
+	uint32_t now = fw_millis();
+
+	// fw_millis() wraps at (2^32 / PIT_COUNTS_PER_MS), not at 2^32
+	operatingTimeRemainderMs += ((now >= operatingTimeLastMillis) ? (now - operatingTimeLastMillis) :
+			(((UINT32_MAX / PIT_COUNTS_PER_MS) - operatingTimeLastMillis) + now + 1));
+	operatingTimeLastMillis = now;
+	operatingTimeSeconds += (operatingTimeRemainderMs / 1000U);
+	operatingTimeRemainderMs %= 1000U;
+
+	if ((forceSave || ((operatingTimeSeconds - operatingTimeSavedSeconds) >= OPERATING_TIME_SAVE_INTERVAL_S)) &&
+			flashStoreWrite(FLASH_STORE_KEY_OPERATING_TIME, (uint8_t *)&operatingTimeSeconds, sizeof(uint32_t)))
+	{
+		operatingTimeSavedSeconds = operatingTimeSeconds;
+	}
+}
+
+uint32_t fw_operatingSeconds(void)
+{
+	return operatingTimeSeconds;
+}
+
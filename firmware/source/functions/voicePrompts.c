@@ -26,7 +26,7 @@ const uint32_t VOICE_PROMPTS_DATA_VERSION_V2 = 0x0002;
 const uint32_t VOICE_PROMPTS_DATA_VERSION_V1 = 0x0001;
 #define VOICE_PROMPTS_TOC_SIZE 256
 
-static void getAmbeData(int offset,int length);
+static void voicePromptsStartPrompt(int promptNumber);
 static void voicePromptsTerminateAndInit(void);
 
 typedef struct
@@ -37,14 +37,15 @@ typedef struct
 
 const uint32_t VOICE_PROMPTS_FLASH_HEADER_ADDRESS = 0xE0000;
 const uint32_t VOICE_PROMPTS_FLASH_DATA_ADDRESS = VOICE_PROMPTS_FLASH_HEADER_ADDRESS + sizeof(VoicePromptsDataHeader_t) + sizeof(uint32_t)*VOICE_PROMPTS_TOC_SIZE ;
-// 76 x 27 byte ambe frames
-#define AMBE_DATA_BUFFER_SIZE  2052
+#define AMBE_FRAMES_DATA_SIZE  27 // 3 x 9 byte ambe frames
 bool voicePromptDataIsLoaded = false;
 bool voicePromptIsActive = false;
 static int promptDataPosition = -1;
 static int currentPromptLength = -1;
 
-__attribute__((section(".data.$RAM4")))static uint8_t ambeData[AMBE_DATA_BUFFER_SIZE];
+// The prompt data is streamed from the Flash one 27 byte block at a time, so playback can start as soon as the first block has been read.
+__attribute__((section(".data.$RAM4"))) static spiFlashStream_t ambeDataStream;
+__attribute__((section(".data.$RAM4"))) static uint8_t ambeData[AMBE_FRAMES_DATA_SIZE];
 
 #define VOICE_PROMPTS_SEQUENCE_BUFFER_SIZE 128
 
@@ -93,23 +94,23 @@ void voicePromptsCacheInit(void)
 	}
 }
 
-static void getAmbeData(int offset,int length)
+static void voicePromptsStartPrompt(int promptNumber)
 {
-	if (length <= AMBE_DATA_BUFFER_SIZE)
-	{
-		SPI_Flash_read(VOICE_PROMPTS_FLASH_DATA_ADDRESS + offset, (uint8_t *)ambeData, length);
-	}
+	promptDataPosition = 0;
+	currentPromptLength = tableOfContents[promptNumber + 1] - tableOfContents[promptNumber];
+	SPI_Flash_streamOpen(&ambeDataStream, VOICE_PROMPTS_FLASH_DATA_ADDRESS + tableOfContents[promptNumber], true);
 }
 
 void voicePromptsTick(void)
 {
 	if (promptDataPosition < currentPromptLength)
 	{
-		if (wavbuffer_count < (WAV_BUFFER_COUNT- 6))
+		if (soundRingCount() < (WAV_BUFFER_COUNT- 6))
 		{
-			codecDecode((uint8_t *)&ambeData[promptDataPosition], 3);
+			SPI_Flash_streamRead(&ambeDataStream, ambeData, AMBE_FRAMES_DATA_SIZE);
+			codecDecode(ambeData, 3);
 			soundTickRXBuffer();
-			promptDataPosition += 27;
+			promptDataPosition += AMBE_FRAMES_DATA_SIZE;
 		}
 	}
 	else
@@ -117,18 +118,15 @@ void voicePromptsTick(void)
 		if (voicePromptsCurrentSequence.Pos < (voicePromptsCurrentSequence.Length - 1))
 		{
 			voicePromptsCurrentSequence.Pos++;
-			promptDataPosition = 0;
-			int promptNumber = voicePromptsCurrentSequence.Buffer[voicePromptsCurrentSequence.Pos];
-
-			currentPromptLength = tableOfContents[promptNumber + 1] - tableOfContents[promptNumber];
-			getAmbeData(tableOfContents[promptNumber],currentPromptLength);
+			voicePromptsStartPrompt(voicePromptsCurrentSequence.Buffer[voicePromptsCurrentSequence.Pos]);
 
 		}
 		else
 		{
 			// wait for wave buffer to empty when prompt has finished playing
-			if (wavbuffer_count == 0)
+			if (soundRingCount() == 0)
 			{
+				SPI_Flash_streamClose(&ambeDataStream);
 				voicePromptsTerminate();
 			}
 		}
@@ -146,6 +144,7 @@ void voicePromptsTerminate(void)
 		}
 		voicePromptIsActive = false;
 		voicePromptsCurrentSequence.Pos = 0;
+		SPI_Flash_streamClose(&ambeDataStream);
 		soundTerminateSound();
 		soundInit();
 	}
@@ -277,16 +276,13 @@ void voicePromptsPlay(void)
 
 	if ((voicePromptIsActive == false) && (voicePromptsCurrentSequence.Length != 0))
 	{
-		int promptNumber = voicePromptsCurrentSequence.Buffer[0];
 		voicePromptsCurrentSequence.Pos = 0;
-		currentPromptLength = tableOfContents[promptNumber + 1] - tableOfContents[promptNumber];
-		getAmbeData(tableOfContents[promptNumber], currentPromptLength);
+		voicePromptsStartPrompt(voicePromptsCurrentSequence.Buffer[0]);
 
 		GPIO_PinWrite(GPIO_RX_audio_mux, Pin_RX_audio_mux, 0);// set the audio mux   HR-C6000 -> audio amp
 		enableAudioAmp(AUDIO_AMP_MODE_PROMPT);
 
 		codecInit();
-		promptDataPosition = 0;
 		voicePromptIsActive = true;// Start the playback
 		voicePromptsTick();
 	}
@@ -20,66 +20,258 @@
 #include <SeggerRTT/RTT/SEGGER_RTT.h>
 #endif
 
+#include <ticks.h>
+
 const uint8_t EEPROM_ADDRESS 	= 0x50;
-const uint8_t EEPROM_PAGE_SIZE 	= 128;
+#define EEPROM_PAGE_SIZE         128
 
-static bool _EEPROM_Write(int address, uint8_t *buf, int size);
+/*
+ * Writes are queued a page at a time and written by EEPROM_Tick(), so the caller doesn't wait for the I2C transfer
+ * or the EEPROM write cycle. Writes to a page which is still queued are merged, so e.g. the CPS writing a page
+ * in 32 byte chunks, or a settings save soon after a VFO save, results in a single page write.
+ * The EEPROM doesn't ACK its address while a write cycle is in progress, so rather than waiting a fixed time,
+ * EEPROM_Tick() tries once and leaves the page queued if the EEPROM (or the I2C bus) is still busy.
+ * A page whose write fails is also left queued, and retried up to EEPROM_WRITE_MAX_RETRIES times before it is dropped.
+ * Both are counted in eepromStats, which the CPS can read.
+ * EEPROM_Read() returns the queued data, and EEPROM_Flush() must be called before power off or reboot.
+ */
+#define EEPROM_WRITE_QUEUE_SIZE      4
+#define EEPROM_WRITE_QUEUE_HOLD_MS   20// Give the next chunk of a sequential write a chance to be merged
+#define EEPROM_WRITE_MAX_RETRIES     3
 
-bool EEPROM_Write(int address, uint8_t *buf, int size)
+typedef enum
 {
-	bool retVal;
+	EEPROM_WRITE_OK = 0,
+	EEPROM_WRITE_BUSY,
+	EEPROM_WRITE_FAILED
+} eepromWriteStatus_t;
 
-	if (address / 128 == (address + size) / 128)
+typedef struct
+{
+	int      page;// page + 1, 0 = unused
+	uint8_t  start;// dirty range in data[]
+	uint8_t  end;
+	uint8_t  failures;// failed write attempts
+	uint32_t lastUsed;
+	uint8_t  data[EEPROM_PAGE_SIZE];
+} eepromQueuedPage_t;
+
+__attribute__((section(".data.$RAM4"))) static eepromQueuedPage_t eepromWriteQueue[EEPROM_WRITE_QUEUE_SIZE];
+eepromStats_t eepromStats;
+
+static eepromWriteStatus_t _EEPROM_Write(int address, uint8_t *buf, int size, int ackPolls);
+static bool eeprom_readRaw(int address, uint8_t *buf, int size);
+static bool eeprom_waitReady(int ackPolls);
+
+static eepromQueuedPage_t *eeprom_queueFindPage(int page)
+{
+	for (int i = 0; i < EEPROM_WRITE_QUEUE_SIZE; i++)
 	{
-		// All of the data is in the same page in the EEPROM so can just be written sequentially in one write
-		retVal = _EEPROM_Write(address, buf, size);
+		if (eepromWriteQueue[i].page == (page + 1))
+		{
+			return &eepromWriteQueue[i];
+		}
 	}
-	else
+
+	return NULL;
+}
+
+static eepromQueuedPage_t *eeprom_queueGetOldest(void)
+{
+	eepromQueuedPage_t *oldest = NULL;
+
+	for (int i = 0; i < EEPROM_WRITE_QUEUE_SIZE; i++)
 	{
-		// Either there is more data than the page size or the data needs to be split across multiple page boundaries
-		int writeSize = 128 - (address % 128);
-		retVal = true;// First time though need to prime the while loop
+		if ((eepromWriteQueue[i].page != 0) && ((oldest == NULL) || ((int32_t)(eepromWriteQueue[i].lastUsed - oldest->lastUsed) < 0)))
+		{
+			oldest = &eepromWriteQueue[i];
+		}
+	}
+
+	return oldest;
+}
 
-		while ((writeSize > 0) && (retVal == true))
+// A failed write is retried up to EEPROM_WRITE_MAX_RETRIES times, by later calls when ackPolls is 0, otherwise straight away.
+// With ackPolls of 0 the page also stays queued if the EEPROM is busy. Otherwise the page is always removed from the queue
+static eepromWriteStatus_t eeprom_queueWritePage(eepromQueuedPage_t *queuedPage, int ackPolls)
+{
+	eepromWriteStatus_t status;
+
+	do
+	{
+		status = _EEPROM_Write(((queuedPage->page - 1) * EEPROM_PAGE_SIZE) + queuedPage->start,
+				&queuedPage->data[queuedPage->start], queuedPage->end - queuedPage->start, ackPolls);
+
+		if (status == EEPROM_WRITE_FAILED)
 		{
-			retVal = _EEPROM_Write(address, buf, writeSize);
-			address += writeSize;
-			buf += writeSize;
-			size -= writeSize;
-			if (size > 128)
-			{
-				writeSize = 128;
-			}
-			else
+			eepromStats.writeFailures++;
+			queuedPage->failures++;
+		}
+	} while ((status == EEPROM_WRITE_FAILED) && (ackPolls > 0) && (queuedPage->failures < EEPROM_WRITE_MAX_RETRIES));
+
+	if ((status == EEPROM_WRITE_OK) || (ackPolls > 0) || (queuedPage->failures >= EEPROM_WRITE_MAX_RETRIES))
+	{
+		if (status != EEPROM_WRITE_OK)
+		{
+			eepromStats.pagesDropped++;
+		}
+		queuedPage->page = 0;
+	}
+	else if (status == EEPROM_WRITE_FAILED)
+	{
+		queuedPage->lastUsed = fw_millis();// Let the other pages go first
+	}
+
+	return status;
+}
+
+// The data must not cross a page boundary
+static bool eeprom_queueWrite(int address, uint8_t *buf, int size)
+{
+	int page = address / EEPROM_PAGE_SIZE;
+	int start = address % EEPROM_PAGE_SIZE;
+	int end = start + size;
+	eepromQueuedPage_t *queuedPage = eeprom_queueFindPage(page);
+	bool retVal = true;
+
+	if (queuedPage != NULL)
+	{
+		// Fill any gap between the queued range and the new data, so the page can still be written in one go
+		if (((start > queuedPage->end) && (eeprom_readRaw((page * EEPROM_PAGE_SIZE) + queuedPage->end, &queuedPage->data[queuedPage->end], start - queuedPage->end) == false)) ||
+				((end < queuedPage->start) && (eeprom_readRaw((page * EEPROM_PAGE_SIZE) + end, &queuedPage->data[end], queuedPage->start - end) == false)))
+		{
+			retVal = (eeprom_queueWritePage(queuedPage, 50) == EEPROM_WRITE_OK);
+			queuedPage = NULL;
+		}
+	}
+
+	if (queuedPage == NULL)
+	{
+		queuedPage = eeprom_queueFindPage(-1);// free slot
+
+		if (queuedPage == NULL)
+		{
+			queuedPage = eeprom_queueGetOldest();
+			if (eeprom_queueWritePage(queuedPage, 50) != EEPROM_WRITE_OK)
 			{
-				writeSize = size;
+				retVal = false;
 			}
 		}
+
+		queuedPage->page = page + 1;
+		queuedPage->start = start;
+		queuedPage->end = end;
+		queuedPage->failures = 0;
+	}
+	else
+	{
+		if (start < queuedPage->start)
+		{
+			queuedPage->start = start;
+		}
+
+		if (end > queuedPage->end)
+		{
+			queuedPage->end = end;
+		}
+	}
+
+	memcpy(&queuedPage->data[start], buf, size);
+	queuedPage->lastUsed = fw_millis();
+
+	return retVal;
+}
+
+bool EEPROM_Write(int address, uint8_t *buf, int size)
+{
+	bool retVal = true;
+
+	// Split the data at the 128 byte page boundaries
+	while (size > 0)
+	{
+		int writeSize = EEPROM_PAGE_SIZE - (address % EEPROM_PAGE_SIZE);
+
+		if (writeSize > size)
+		{
+			writeSize = size;
+		}
+
+		if (eeprom_queueWrite(address, buf, writeSize) == false)
+		{
+			retVal = false;
+		}
+
+		address += writeSize;
+		buf += writeSize;
+		size -= writeSize;
 	}
+
 	return retVal;
 }
 
-/* This was the original EEPROM_Write function, but its now been wrapped by the new EEPROM_Write
- * While calls this function as necessary to handle write across 128 byte page boundaries
- * and also for writes larger than 128 bytes.
+// Write the least recently used page, if the EEPROM is ready. Called from the main loop
+void EEPROM_Tick(void)
+{
+	eepromQueuedPage_t *queuedPage = eeprom_queueGetOldest();
+
+	if ((queuedPage != NULL) && ((fw_millis() - queuedPage->lastUsed) >= EEPROM_WRITE_QUEUE_HOLD_MS))
+	{
+		eeprom_queueWritePage(queuedPage, 0);
+	}
+}
+
+// Write all the queued pages and wait for the last write cycle to complete
+bool EEPROM_Flush(void)
+{
+	eepromQueuedPage_t *queuedPage;
+	bool retVal = true;
+
+	while ((queuedPage = eeprom_queueGetOldest()) != NULL)
+	{
+		if (eeprom_queueWritePage(queuedPage, 50) != EEPROM_WRITE_OK)
+		{
+			retVal = false;
+		}
+	}
+
+	return (eeprom_waitReady(50) && retVal);
+}
+
+bool EEPROM_IsWritePending(void)
+{
+	return (eeprom_queueGetOldest() != NULL);
+}
+
+/* This was the original EEPROM_Write function, it now writes the pages from the write queue.
+ * The I2C bus and the EEPROM ACK are polled up to ackPolls times, 1mS apart, before giving up with EEPROM_WRITE_BUSY.
  */
-static bool _EEPROM_Write(int address, uint8_t *buf, int size)
+static eepromWriteStatus_t _EEPROM_Write(int address, uint8_t *buf, int size, int ackPolls)
 {
 	const int COMMAND_SIZE = 2;
 	int transferSize;
 	uint8_t tmpBuf[COMMAND_SIZE];
     i2c_master_transfer_t masterXfer;
     status_t status;
+	int timeoutCount = ackPolls;
 
-	taskENTER_CRITICAL();
-    if (isI2cInUse)
-    {
+	while (1U)
+	{
+		taskENTER_CRITICAL();
+		if (isI2cInUse == 0)
+		{
+			break;
+		}
+		taskEXIT_CRITICAL();
+
+		if (timeoutCount-- <= 0)
+		{
 #if defined(USE_SEGGER_RTT)
-    	SEGGER_RTT_printf(0, "Clash in EEPROM_Write (2) with %d\n",isI2cInUse);
+			SEGGER_RTT_printf(0, "Clash in EEPROM_Write (2) with %d\n",isI2cInUse);
 #endif
-    	taskEXIT_CRITICAL();
-    	return false;
-    }
+			return EEPROM_WRITE_BUSY;
+		}
+		vTaskDelay(portTICK_PERIOD_MS * 1);
+	}
     isI2cInUse = 1;
 
 
@@ -99,10 +291,9 @@ static bool _EEPROM_Write(int address, uint8_t *buf, int size)
 		masterXfer.flags = kI2C_TransferNoStopFlag;//kI2C_TransferDefaultFlag;
 
 		// EEPROM Will not respond if it is busy completing the previous write.
-		// So repeat the write command until it responds or timeout after 50
+		// So repeat the write command until it responds or timeout after ackPolls
 		// attempts 1mS apart
 
-		int timeoutCount = 50;
 		status = kStatus_Success;
 		do
 		{
@@ -119,7 +310,7 @@ static bool _EEPROM_Write(int address, uint8_t *buf, int size)
 		{
 	    	isI2cInUse = 0;
 	    	taskEXIT_CRITICAL();
-			return false;
+			return EEPROM_WRITE_BUSY;
 		}
 
 		memset(&masterXfer, 0, sizeof(masterXfer));
@@ -136,7 +327,7 @@ static bool _EEPROM_Write(int address, uint8_t *buf, int size)
 		{
 	    	isI2cInUse = 0;
 	    	taskEXIT_CRITICAL();
-			return status;
+			return EEPROM_WRITE_FAILED;
 		}
 		address += transferSize;
 		size -= transferSize;
@@ -145,10 +336,88 @@ static bool _EEPROM_Write(int address, uint8_t *buf, int size)
 	isI2cInUse = 0;
 	taskEXIT_CRITICAL();
 
-	return true;
+	return EEPROM_WRITE_OK;
 }
 
 bool EEPROM_Read(int address, uint8_t *buf, int size)
+{
+	if (eeprom_readRaw(address, buf, size) == false)
+	{
+		return false;
+	}
+
+	// Overlay the data still waiting in the write queue
+	for (int i = 0; i < EEPROM_WRITE_QUEUE_SIZE; i++)
+	{
+		if (eepromWriteQueue[i].page != 0)
+		{
+			int pageAddress = (eepromWriteQueue[i].page - 1) * EEPROM_PAGE_SIZE;
+			int from = pageAddress + eepromWriteQueue[i].start;
+			int to = pageAddress + eepromWriteQueue[i].end;
+
+			if (from < address)
+			{
+				from = address;
+			}
+
+			if (to > (address + size))
+			{
+				to = address + size;
+			}
+
+			if (from < to)
+			{
+				memcpy(buf + (from - address), &eepromWriteQueue[i].data[from - pageAddress], to - from);
+			}
+		}
+	}
+
+	return true;
+}
+
+// Acknowledge polling, the EEPROM only responds once the current write cycle is complete
+static bool eeprom_waitReady(int ackPolls)
+{
+	uint8_t tmpBuf[2] = { 0, 0 };
+	i2c_master_transfer_t masterXfer;
+	status_t status;
+
+	do
+	{
+		taskENTER_CRITICAL();
+		if (isI2cInUse)
+		{
+			status = kStatus_Fail;
+		}
+		else
+		{
+			isI2cInUse = 1;
+
+			memset(&masterXfer, 0, sizeof(masterXfer));
+			masterXfer.slaveAddress = EEPROM_ADDRESS;
+			masterXfer.direction = kI2C_Write;
+			masterXfer.data = tmpBuf;
+			masterXfer.dataSize = sizeof(tmpBuf);
+			masterXfer.flags = kI2C_TransferDefaultFlag;
+
+			status = I2C_MasterTransferBlocking(I2C0, &masterXfer);
+			isI2cInUse = 0;
+		}
+		taskEXIT_CRITICAL();
+
+		if (status == kStatus_Success)
+		{
+			return true;
+		}
+
+		vTaskDelay(portTICK_PERIOD_MS * 1);
+
+	} while (ackPolls-- > 0);
+
+	return false;
+}
+
+static bool eeprom_readRaw(int address, uint8_t *buf, int size)
 {
 	const int COMMAND_SIZE = 2;
 	uint8_t tmpBuf[COMMAND_SIZE];
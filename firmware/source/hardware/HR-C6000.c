@@ -1451,9 +1451,9 @@ void tick_HR_C6000(void)
 				{
 					// Note. We don't increment the buffer indexes, becuase this is also the first frame of audio and we need it later
 					NVIC_DisableIRQ(PORTC_IRQn);
-					SPI0WritePageRegByteArray(0x02, 0x00, (uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[wavbuffer_read_idx], 0x0c);// put LC into hardware
+					SPI0WritePageRegByteArray(0x02, 0x00, (uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[soundRingReadBuffer()], 0x0c);// put LC into hardware
 					NVIC_EnableIRQ(PORTC_IRQn);
-					memcpy((uint8_t *)deferredUpdateBuffer, (uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[wavbuffer_read_idx], 27 + 0x0C);
+					memcpy((uint8_t *)deferredUpdateBuffer, (uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[soundRingReadBuffer()], 27 + 0x0C);
 					hotspotDMRTxFrameBufferEmpty = false;
 				}
 				slot_state = DMR_STATE_TX_START_1;
@@ -1526,19 +1526,10 @@ void tick_HR_C6000(void)
 			// normal operation. Not waking the repeater
 			if (settingsUsbMode == USB_MODE_HOTSPOT)
 			{
-				if ((hotspotDMRTxFrameBufferEmpty == true) && (wavbuffer_count > 0))
+				if ((hotspotDMRTxFrameBufferEmpty == true) && (soundRingCount() > 0))
 				{
-					memcpy((uint8_t *)deferredUpdateBuffer, (uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[wavbuffer_read_idx], 27 + 0x0C);
-					wavbuffer_read_idx++;
-					if (wavbuffer_read_idx > (HOTSPOT_BUFFER_COUNT - 1))
-					{
-						wavbuffer_read_idx = 0;
-					}
-
-					if (wavbuffer_count > 0)
-					{
-						wavbuffer_count--;
-					}
+					memcpy((uint8_t *)deferredUpdateBuffer, (uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[soundRingReadBuffer()], 27 + 0x0C);
+					soundRingAdvanceRead();
 					hotspotDMRTxFrameBufferEmpty = false;
 				}
 			}
@@ -1547,7 +1538,7 @@ void tick_HR_C6000(void)
 				// Once there are 6 buffers available they can be encoded into one DMR frame
 				// The will happen  prior to the data being needed in the TS ISR, so that by the time tick_codec_encode encodes complete,
 				// the data is ready to be used in the TS ISR
-				if (wavbuffer_count >= 6)
+				if (soundRingCount() >= 6)
 				{
 					codecEncode((uint8_t *)deferredUpdateBuffer, 3);
 				}
@@ -1573,11 +1564,15 @@ void tick_HR_C6000(void)
 		else
 		{
 			// voice prompts take priority over incoming DMR audio
-			if (!voicePromptsIsPlaying() && hasEncodedAudio)
+			if (!voicePromptsIsPlaying())
 			{
-				hasEncodedAudio = false;
-				codecDecode((uint8_t *)DMR_frame_buffer + 0x0C, 3);
-				soundTickRXBuffer();
+				if (hasEncodedAudio)
+				{
+					hasEncodedAudio = false;
+					codecDecode((uint8_t *)DMR_frame_buffer + 0x0C, 3);
+					soundRXFrameDecoded();
+				}
+				soundTickRXPlayout();
 			}
 		}
 
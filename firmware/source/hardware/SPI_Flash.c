@@ -18,16 +18,46 @@
 
 #include <SPI_Flash.h>
 #include <gpio.h>
+#include <ticks.h>
 
 // private functions
 static bool spi_flash_busy(void);
-static void spi_flash_transfer_buf(uint8_t *inBuf,uint8_t *outBuf,int size);
 static uint8_t spi_flash_transfer(uint8_t c);
 static void spi_flash_setWriteEnable(bool cmd);
-static inline void spi_flash_enable(void);
-static inline void spi_flash_disable(void);
+static void spi_flash_enable(void);
+static void spi_flash_disable(void);
+static void spi_flash_bitbang_writeBuf(const uint8_t *buf, int size);
+static void spi_flash_bitbang_readBuf(uint8_t *buf, int size);
+static void spi_flash_block_writeBuf(const uint8_t *buf, int size);
+static void spi_flash_block_readBuf(uint8_t *buf, int size);
+static void spi_flash_streamSuspend(void);
+static bool spi_flash_writePage(uint32_t addr_start, uint8_t *dataBuf);
+static bool spi_flash_eraseSector(uint32_t addr_start);
+static void spi_flash_readRaw(uint32_t addr, uint8_t *dataBuf, int size);
+static bool spi_flash_cacheFlushSlot(int slot);
+static void spi_flash_cacheOverlay(uint32_t addr, uint8_t *dataBuf, int size);
+static void spi_flash_cacheDiscardSector(int sector);
 __attribute__((section(".data.$RAM2"))) uint8_t SPI_Flash_sectorbuffer[4096];
 
+const spiFlashTransport_t SPI_FLASH_TRANSPORT_BITBANG =
+{
+	.select = spi_flash_enable,
+	.deselect = spi_flash_disable,
+	.writeBuf = spi_flash_bitbang_writeBuf,
+	.readBuf = spi_flash_bitbang_readBuf
+};
+
+const spiFlashTransport_t SPI_FLASH_TRANSPORT_BLOCK =
+{
+	.select = spi_flash_enable,
+	.deselect = spi_flash_disable,
+	.writeBuf = spi_flash_block_writeBuf,
+	.readBuf = spi_flash_block_readBuf
+};
+
+static const spiFlashTransport_t *spiFlashTransport = &SPI_FLASH_TRANSPORT_BLOCK;
+static spiFlashStream_t *spiFlashActiveStream = NULL;// Stream which currently has CS asserted, if any
+
 
 //COMMANDS. Not all implemented or used
 #define W_EN 			0x06	//write enable
@@ -57,6 +87,17 @@ __attribute__((section(".data.$RAM2"))) uint8_t SPI_Flash_sectorbuffer[4096];
 #define SR1_WEN_MASK	0x02
 #define WINBOND_MANUF	0xef
   
+void SPI_Flash_setTransport(const spiFlashTransport_t *transport)
+{
+	spi_flash_streamSuspend();
+	spiFlashTransport = transport;
+}
+
+const spiFlashTransport_t *SPI_Flash_getTransport(void)
+{
+	return spiFlashTransport;
+}
+
 bool SPI_Flash_init(void)
 {
 	int partNumber;
@@ -82,7 +123,6 @@ bool SPI_Flash_init(void)
 // Note. There is no error checking that the device is not initially busy.
 bool SPI_Flash_read(uint32_t addr, uint8_t *dataBuf, int size)
 {
-  uint8_t commandBuf[4]= { READ, addr >> 16, addr >> 8, addr };// command
   /*
    * This is very ineffecient and the Flash never seems to be busy
   if(spi_flash_busy())
@@ -90,91 +130,410 @@ bool SPI_Flash_read(uint32_t addr, uint8_t *dataBuf, int size)
     return false;
   }
   */
-  spi_flash_enable();
-  spi_flash_transfer_buf(commandBuf, commandBuf, 4);
-  for(int i = 0; i < size; i++)
-  {
-	  *dataBuf++ = spi_flash_transfer(0x00);
-  }
-  spi_flash_disable();
+  spi_flash_readRaw(addr, dataBuf, size);
+  spi_flash_cacheOverlay(addr, dataBuf, size);
   return true;
 }
 
+// Reads what is actually in the Flash, ignoring the cache
+static void spi_flash_readRaw(uint32_t addr, uint8_t *dataBuf, int size)
+{
+  uint8_t commandBuf[4]= { READ, addr >> 16, addr >> 8, addr };// command
+
+  spi_flash_streamSuspend();
+  spiFlashTransport->select();
+  spiFlashTransport->writeBuf(commandBuf, 4);
+  spiFlashTransport->readBuf(dataBuf, size);
+  spiFlashTransport->deselect();
+}
+
+/*
+ * Write-back sector cache.
+ *
+ * SPI_Flash_write() only updates a RAM copy of the sector(s) being written. Dirty sectors are written to the Flash
+ * when a slot is needed for another sector, when SPI_Flash_flushCache() is called, or by SPI_Flash_cacheTick()
+ * once the sector has not been modified for SPI_FLASH_CACHE_FLUSH_DELAY_MS.
+ * So a sequence of small edits in the same sector costs one erase, and if an edit only clears bits (1 -> 0)
+ * the sector is not erased at all.
+ *
+ * Each slot has its own buffer. SPI_Flash_sectorbuffer belongs to the CPS, which fills it between reading
+ * and programming a sector, so the cache must never use it.
+ */
+static spiFlashCacheSlot_t spiFlashCache[SPI_FLASH_CACHE_NUM_SLOTS];
+static uint8_t spiFlashCacheBuffer[SPI_FLASH_CACHE_NUM_SLOTS][4096];// Not in RAM2, which is already nearly full
+static uint32_t spiFlashCacheUseCounter = 0;
+spiFlashStats_t SPI_Flash_stats;
+
+static uint8_t *spi_flash_cacheSlotBuffer(int slot)
+{
+	return spiFlashCacheBuffer[slot];
+}
+
+static int spi_flash_cacheGetSlot(int sector)
+{
+	int slot;
+	int lruSlot = 0;
+
+	for (slot = 0; slot < SPI_FLASH_CACHE_NUM_SLOTS; slot++)
+	{
+		if (spiFlashCache[slot].sector == (sector + 1))
+		{
+			spiFlashCache[slot].lastUsed = ++spiFlashCacheUseCounter;
+			return slot;
+		}
+
+		if (spiFlashCache[slot].lastUsed < spiFlashCache[lruSlot].lastUsed)
+		{
+			lruSlot = slot;
+		}
+	}
+
+	// Not cached, so re-use the least recently used slot
+	if (spi_flash_cacheFlushSlot(lruSlot) == false)
+	{
+		return -1;
+	}
+
+	spi_flash_readRaw(sector * 4096, spi_flash_cacheSlotBuffer(lruSlot), 4096);
+	spiFlashCache[lruSlot].sector = sector + 1;
+	spiFlashCache[lruSlot].dirty = false;
+	spiFlashCache[lruSlot].lastUsed = ++spiFlashCacheUseCounter;
+
+	return lruSlot;
+}
+
 bool SPI_Flash_write(uint32_t addr, uint8_t *dataBuf, int size)
 {
-	bool retVal = true;
-	int flashWritePos = addr;
-	int flashSector;
-	int flashEndSector;
-	int bytesToWriteInCurrentSector = size;
+	while (size > 0)
+	{
+		int sector = addr / 4096;
+		int offset = addr % 4096;
+		int bytesToWriteInCurrentSector = ((offset + size) > 4096) ? (4096 - offset) : size;
+		int slot = spi_flash_cacheGetSlot(sector);
+
+		if (slot < 0)
+		{
+			return false;
+		}
+
+		uint8_t *writePos = spi_flash_cacheSlotBuffer(slot) + offset;
+		if (memcmp(writePos, dataBuf, bytesToWriteInCurrentSector) != 0)
+		{
+			memcpy(writePos, dataBuf, bytesToWriteInCurrentSector);
+			spiFlashCache[slot].dirty = true;
+			spiFlashCache[slot].dirtyTime = fw_millis();
+		}
 
-	flashSector	= flashWritePos / 4096;
-	flashEndSector = (flashWritePos + size) / 4096;
+		addr += bytesToWriteInCurrentSector;
+		dataBuf += bytesToWriteInCurrentSector;
+		size -= bytesToWriteInCurrentSector;
+	}
 
-	if (flashSector != flashEndSector)
+	return true;
+}
+
+// Writes the slot to the Flash, if it has been modified. The slot stays valid.
+static bool spi_flash_cacheFlushSlot(int slot)
+{
+	uint8_t pageBuf[256];
+	uint8_t *sectorBuf = spi_flash_cacheSlotBuffer(slot);
+	uint32_t sectorAddress;
+	bool needsErase = false;
+	bool pageNeedsWrite[16];
+
+	if ((spiFlashCache[slot].sector == 0) || (spiFlashCache[slot].dirty == false))
 	{
-		bytesToWriteInCurrentSector = (flashEndSector * 4096) - flashWritePos;
+		return true;
 	}
 
-	SPI_Flash_read(flashSector * 4096, SPI_Flash_sectorbuffer, 4096);
-	uint8_t *writePos = SPI_Flash_sectorbuffer + flashWritePos - (flashSector * 4096);
-	memcpy(writePos, dataBuf, bytesToWriteInCurrentSector);
+	sectorAddress = (spiFlashCache[slot].sector - 1) * 4096;
 
-	retVal = SPI_Flash_eraseSector(flashSector * 4096);
-	if (!retVal)
+	// Compare with what is actually in the Flash, page by page.
+	// Programming can only change bits from 1 to 0, so an erase is only needed if any bit has to go from 0 to 1
+	for (int i = 0; i < 16; i++)
 	{
-		return false;
+		spi_flash_readRaw(sectorAddress + i * 256, pageBuf, 256);
+		pageNeedsWrite[i] = false;
+		for (int j = 0; j < 256; j++)
+		{
+			uint8_t newByte = sectorBuf[i * 256 + j];
+
+			if (newByte != pageBuf[j])
+			{
+				pageNeedsWrite[i] = true;
+				if ((pageBuf[j] & newByte) != newByte)
+				{
+					needsErase = true;
+				}
+			}
+		}
+	}
+
+	if (needsErase)
+	{
+		if (!spi_flash_eraseSector(sectorAddress))
+		{
+			return false;
+		}
+
+		// After the erase, only the pages which are not blank need to be programmed
+		for (int i = 0; i < 16; i++)
+		{
+			pageNeedsWrite[i] = false;
+			for (int j = 0; j < 256; j++)
+			{
+				if (sectorBuf[i * 256 + j] != 0xFF)
+				{
+					pageNeedsWrite[i] = true;
+					break;
+				}
+			}
+		}
 	}
 
 	for (int i = 0; i < 16; i++)
 	{
-		retVal = SPI_Flash_writePage(flashSector * 4096 + i * 256, SPI_Flash_sectorbuffer + i * 256);
-		if (!retVal)
+		if (pageNeedsWrite[i] && !spi_flash_writePage(sectorAddress + i * 256, sectorBuf + i * 256))
 		{
 			return false;
 		}
 	}
 
-	if (flashSector != flashEndSector)
+	spiFlashCache[slot].dirty = false;
+
+	return true;
+}
+
+// Writes all the modified sectors to the Flash and empties the cache
+bool SPI_Flash_flushCache(void)
+{
+	bool retVal = true;
+
+	for (int slot = 0; slot < SPI_FLASH_CACHE_NUM_SLOTS; slot++)
+	{
+		if (spi_flash_cacheFlushSlot(slot) == false)
+		{
+			retVal = false;
+		}
+		spiFlashCache[slot].sector = 0;
+		spiFlashCache[slot].dirty = false;
+	}
+
+	return retVal;
+}
+
+bool SPI_Flash_cacheIsDirty(void)
+{
+	for (int slot = 0; slot < SPI_FLASH_CACHE_NUM_SLOTS; slot++)
+	{
+		if (spiFlashCache[slot].dirty)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Called from the main task. Write back any sector which has not been modified recently.
+void SPI_Flash_cacheTick(void)
+{
+	for (int slot = 0; slot < SPI_FLASH_CACHE_NUM_SLOTS; slot++)
 	{
-		uint8_t *bufPusOffset = (uint8_t *) dataBuf + bytesToWriteInCurrentSector;
-		bytesToWriteInCurrentSector = size - bytesToWriteInCurrentSector;
+		if (spiFlashCache[slot].dirty && ((fw_millis() - spiFlashCache[slot].dirtyTime) > SPI_FLASH_CACHE_FLUSH_DELAY_MS))
+		{
+			spi_flash_cacheFlushSlot(slot);
+		}
+	}
+}
 
-		SPI_Flash_read(flashEndSector * 4096, SPI_Flash_sectorbuffer, 4096);
-		memcpy(SPI_Flash_sectorbuffer, (uint8_t *) bufPusOffset, bytesToWriteInCurrentSector);
+// Replace any part of the buffer which is held in the cache, with the cached data, as that may be newer than the Flash
+static void spi_flash_cacheOverlay(uint32_t addr, uint8_t *dataBuf, int size)
+{
+	for (int slot = 0; slot < SPI_FLASH_CACHE_NUM_SLOTS; slot++)
+	{
+		if (spiFlashCache[slot].sector != 0)
+		{
+			uint32_t sectorStart = (spiFlashCache[slot].sector - 1) * 4096;
+			uint32_t start = (addr > sectorStart) ? addr : sectorStart;
+			uint32_t end = ((addr + size) < (sectorStart + 4096)) ? (addr + size) : (sectorStart + 4096);
 
-		retVal = SPI_Flash_eraseSector(flashEndSector * 4096);
+			if (start < end)
+			{
+				memcpy(dataBuf + (start - addr), spi_flash_cacheSlotBuffer(slot) + (start - sectorStart), end - start);
+			}
+		}
+	}
+}
 
-		if (!retVal)
+// Direct erases and page writes bypass the cache, so any cached copy of that sector is now stale
+static void spi_flash_cacheDiscardSector(int sector)
+{
+	for (int slot = 0; slot < SPI_FLASH_CACHE_NUM_SLOTS; slot++)
+	{
+		if (spiFlashCache[slot].sector == (sector + 1))
 		{
-			return false;
+			spiFlashCache[slot].sector = 0;
+			spiFlashCache[slot].dirty = false;
 		}
-		for (int i = 0; i < 16; i++)
+	}
+}
+
+void SPI_Flash_streamOpen(spiFlashStream_t *stream, uint32_t address, bool prefetch)
+{
+	if (spiFlashActiveStream == stream)
+	{
+		spi_flash_streamSuspend();
+	}
+	stream->busAddress = address;
+	stream->prefetch = prefetch;
+	stream->windowReadPos = 0;
+	stream->windowCount = 0;
+}
+
+// Clocks data straight from the bus, (re)issuing the FAST_READ command only if this stream does not already own the bus
+static void spi_flash_streamTransfer(spiFlashStream_t *stream, uint8_t *buf, int size)
+{
+	if (spiFlashActiveStream != stream)
+	{
+		uint8_t commandBuf[5] = { FAST_READ, stream->busAddress >> 16, stream->busAddress >> 8, stream->busAddress, 0x00 };// last byte is the dummy byte
+
+		spi_flash_streamSuspend();
+		spiFlashTransport->select();
+		spiFlashTransport->writeBuf(commandBuf, 5);
+		spiFlashActiveStream = stream;
+	}
+
+	spiFlashTransport->readBuf(buf, size);
+	spi_flash_cacheOverlay(stream->busAddress, buf, size);
+	stream->busAddress += size;
+}
+
+// Refill whichever half of the window is free. The halves are always filled whole, so the write position is half aligned.
+static void spi_flash_streamFillWindow(spiFlashStream_t *stream)
+{
+	while (stream->windowCount <= SPI_FLASH_STREAM_HALF_WINDOW_SIZE)
+	{
+		int writePos = (stream->windowReadPos + stream->windowCount) % sizeof(stream->window);
+
+		spi_flash_streamTransfer(stream, &stream->window[writePos], SPI_FLASH_STREAM_HALF_WINDOW_SIZE);
+		stream->windowCount += SPI_FLASH_STREAM_HALF_WINDOW_SIZE;
+	}
+}
+
+bool SPI_Flash_streamRead(spiFlashStream_t *stream, uint8_t *buf, int size)
+{
+	while (size > 0)
+	{
+		if (stream->windowCount == 0)
 		{
-			retVal = SPI_Flash_writePage(flashEndSector * 4096 + i * 256, SPI_Flash_sectorbuffer + i * 256);
+			stream->windowReadPos = 0;
 
-			if (!retVal)
+			if ((stream->prefetch == false) || (size >= SPI_FLASH_STREAM_HALF_WINDOW_SIZE))
 			{
-				return false;
+				// Nothing buffered, so large reads go straight into the destination buffer
+				int len = (stream->prefetch ? (size & ~(SPI_FLASH_STREAM_HALF_WINDOW_SIZE - 1)) : size);
+
+				spi_flash_streamTransfer(stream, buf, len);
+				buf += len;
+				size -= len;
+				continue;
 			}
+
+			spi_flash_streamFillWindow(stream);
 		}
 
+		// Copy up to the end of the current half
+		int len = SPI_FLASH_STREAM_HALF_WINDOW_SIZE - (stream->windowReadPos % SPI_FLASH_STREAM_HALF_WINDOW_SIZE);
+		if (len > stream->windowCount)
+		{
+			len = stream->windowCount;
+		}
+		if (len > size)
+		{
+			len = size;
+		}
+
+		memcpy(buf, &stream->window[stream->windowReadPos], len);
+		buf += len;
+		size -= len;
+		stream->windowReadPos = (stream->windowReadPos + len) % sizeof(stream->window);
+		stream->windowCount -= len;
+
+		// A whole half has been consumed, so read the next one while the other half is being used.
+		if ((stream->windowReadPos % SPI_FLASH_STREAM_HALF_WINDOW_SIZE) == 0)
+		{
+			if (stream->windowCount == 0)
+			{
+				stream->windowReadPos = 0;
+			}
+			spi_flash_streamFillWindow(stream);
+		}
 	}
+
 	return true;
 }
 
+// Logical position of the stream, i.e. the address of the next byte that SPI_Flash_streamRead() will return
+uint32_t SPI_Flash_streamGetPosition(spiFlashStream_t *stream)
+{
+	return stream->busAddress - stream->windowCount;
+}
+
+void SPI_Flash_streamSeek(spiFlashStream_t *stream, uint32_t address)
+{
+	const uint32_t MAX_BYTES_TO_SKIP_ON_BUS = 5;// Clocking out more than this is slower than sending a new FAST_READ command
+	uint32_t position = SPI_Flash_streamGetPosition(stream);
+
+	if ((address >= position) && ((address - position) <= stream->windowCount))
+	{
+		// Already in the prefetch window
+		uint32_t skip = address - position;
+
+		stream->windowReadPos = (stream->windowReadPos + skip) % sizeof(stream->window);
+		stream->windowCount -= skip;
+	}
+	else if ((spiFlashActiveStream == stream) && (address >= stream->busAddress) && ((address - stream->busAddress) <= MAX_BYTES_TO_SKIP_ON_BUS))
+	{
+		uint8_t discard[MAX_BYTES_TO_SKIP_ON_BUS];
+
+		stream->windowReadPos = 0;
+		stream->windowCount = 0;
+		spi_flash_streamTransfer(stream, discard, address - stream->busAddress);
+	}
+	else
+	{
+		SPI_Flash_streamOpen(stream, address, stream->prefetch);
+	}
+}
+
+void SPI_Flash_streamClose(spiFlashStream_t *stream)
+{
+	if (spiFlashActiveStream == stream)
+	{
+		spi_flash_streamSuspend();
+	}
+	stream->windowReadPos = 0;
+	stream->windowCount = 0;
+}
+
+// Release the bus from an open stream. The stream will restart from its busAddress on its next read.
+static void spi_flash_streamSuspend(void)
+{
+	if (spiFlashActiveStream != NULL)
+	{
+		spiFlashTransport->deselect();
+		spiFlashActiveStream = NULL;
+	}
+}
+
 int SPI_Flash_readStatusRegister(void)
 {
 	int r1,r2;
 
-	spi_flash_enable();
-	spi_flash_transfer(R_SR1);
-	r1 = spi_flash_transfer(0xff);
-	spi_flash_disable();
-	spi_flash_enable();
-	spi_flash_transfer(R_SR2);
-	r2 = spi_flash_transfer(0xff);
-	spi_flash_disable();
+	spi_flash_streamSuspend();
+	r1 = spi_flash_transfer(R_SR1);
+	r2 = spi_flash_transfer(R_SR2);
 
 	return (((uint16_t)r2) << 8) | r1;
 }
@@ -183,9 +542,11 @@ int SPI_Flash_readManufacturer(void)
 {
 	uint8_t commandBuf[4] = { R_JEDEC_ID, 0x00, 0x00, 0x00};
 
-	spi_flash_enable();
-	spi_flash_transfer_buf(commandBuf, commandBuf, 4);
-	spi_flash_disable();
+	spi_flash_streamSuspend();
+	spiFlashTransport->select();
+	spiFlashTransport->writeBuf(commandBuf, 1);
+	spiFlashTransport->readBuf(&commandBuf[1], 3);
+	spiFlashTransport->deselect();
 
 	return commandBuf[1];
 }
@@ -194,31 +555,35 @@ int SPI_Flash_readPartID(void)
 {
 	uint8_t commandBuf[4] = { R_JEDEC_ID, 0x00, 0x00, 0x00};
 
-	spi_flash_enable();
-	spi_flash_transfer_buf(commandBuf, commandBuf, 4);
-	spi_flash_disable();
+	spi_flash_streamSuspend();
+	spiFlashTransport->select();
+	spiFlashTransport->writeBuf(commandBuf, 1);
+	spiFlashTransport->readBuf(&commandBuf[1], 3);
+	spiFlashTransport->deselect();
 
 	return (commandBuf[2] << 8) | commandBuf[3];
 }
 
-bool SPI_Flash_writePage(uint32_t addr_start,uint8_t *dataBuf)
+bool SPI_Flash_writePage(uint32_t addr_start, uint8_t *dataBuf)
+{
+	spi_flash_cacheDiscardSector(addr_start / 4096);
+	return spi_flash_writePage(addr_start, dataBuf);
+}
+
+static bool spi_flash_writePage(uint32_t addr_start, uint8_t *dataBuf)
 {
 	bool isBusy;
 	int waitCounter = 5;// Worst case is something like 3mS
 	uint8_t commandBuf[4]= { PAGE_PGM, addr_start >> 16, addr_start >> 8, 0x00} ;
 
+	spi_flash_streamSuspend();
 	spi_flash_setWriteEnable(true);
 
-	spi_flash_enable();
-
-	spi_flash_transfer_buf(commandBuf, commandBuf, 4);// send the command and the address
-
-	for(int i = 0; i < 0x100; i++)
-	{
-		spi_flash_transfer(*dataBuf++);
-	}
-
-	spi_flash_disable();
+	spiFlashTransport->select();
+	spiFlashTransport->writeBuf(commandBuf, 4);// send the command and the address
+	spiFlashTransport->writeBuf(dataBuf, 0x100);
+	spiFlashTransport->deselect();
+	SPI_Flash_stats.pageWrites++;
 
 	do
 	{
@@ -229,20 +594,70 @@ bool SPI_Flash_writePage(uint32_t addr_start,uint8_t *dataBuf)
 	return !isBusy;
 }
 
+// Program bytes without erasing, so only 1 to 0 bit transitions take effect. The range may start mid page and span pages.
+bool SPI_Flash_program(uint32_t addr, const uint8_t *dataBuf, int size)
+{
+	while (size > 0)
+	{
+		bool isBusy;
+		int waitCounter = 5;
+		int chunk = 0x100 - (addr & 0xFF);// PAGE_PGM wraps at the end of the page
+		uint8_t commandBuf[4]= { PAGE_PGM, addr >> 16, addr >> 8, addr};
+
+		if (chunk > size)
+		{
+			chunk = size;
+		}
+
+		spi_flash_cacheDiscardSector(addr / 4096);
+		spi_flash_streamSuspend();
+		spi_flash_setWriteEnable(true);
+
+		spiFlashTransport->select();
+		spiFlashTransport->writeBuf(commandBuf, 4);
+		spiFlashTransport->writeBuf(dataBuf, chunk);
+		spiFlashTransport->deselect();
+		SPI_Flash_stats.pageWrites++;
+
+		do
+		{
+		    vTaskDelay(portTICK_PERIOD_MS * 1);
+			isBusy = spi_flash_busy();
+		} while ((waitCounter-- > 0) && isBusy);
+
+		if (isBusy)
+		{
+			return false;
+		}
+
+		addr += chunk;
+		dataBuf += chunk;
+		size -= chunk;
+	}
+
+	return true;
+}
+
 // Returns true if erased and false if failed.
 bool SPI_Flash_eraseSector(uint32_t addr_start)
+{
+	spi_flash_cacheDiscardSector(addr_start / 4096);
+	return spi_flash_eraseSector(addr_start);
+}
+
+static bool spi_flash_eraseSector(uint32_t addr_start)
 {
 	int waitCounter = 500;// erase can take up to 500 mS
 	bool isBusy;
 	uint8_t commandBuf[4] = { SECTOR_E, addr_start >> 16, addr_start >> 8, 0x00};
 
-	spi_flash_enable();
+	spi_flash_streamSuspend();
 	spi_flash_setWriteEnable(true);
-	spi_flash_disable();
 
-	spi_flash_enable();
-	spi_flash_transfer_buf(commandBuf, commandBuf, 4);
-	spi_flash_disable();
+	spiFlashTransport->select();
+	spiFlashTransport->writeBuf(commandBuf, 4);
+	spiFlashTransport->deselect();
+	SPI_Flash_stats.sectorErases++;
 
 	do
 	{
@@ -253,7 +668,7 @@ bool SPI_Flash_eraseSector(uint32_t addr_start)
 	return !isBusy;// If still busy after
 }
 
-static inline void spi_flash_enable(void)
+static void spi_flash_enable(void)
 {
 	//GPIO_PinWrite(GPIO_SPI_FLASH_CS_U, Pin_SPI_FLASH_CS_U, 0);
 	GPIO_SPI_FLASH_CS_U->PCOR = 1U << Pin_SPI_FLASH_CS_U;
@@ -265,7 +680,7 @@ static void spi_flash_disable(void)
 	GPIO_SPI_FLASH_CS_U->PSOR = 1U << Pin_SPI_FLASH_CS_U;
 }
 
-static uint8_t spi_flash_transfer(uint8_t c)
+static uint8_t spi_flash_bitbang_transfer(uint8_t c)
 {
 	for (uint8_t bit = 0; bit < 8; bit++)
 	{
@@ -290,24 +705,103 @@ static uint8_t spi_flash_transfer(uint8_t c)
 	return c;
 }
 
-static void spi_flash_transfer_buf(uint8_t *inBuf, uint8_t *outBuf, int size)
+static void spi_flash_bitbang_writeBuf(const uint8_t *buf, int size)
 {
 	while(size-- > 0)
 	{
-		*outBuf++ = spi_flash_transfer(*inBuf++);
+		spi_flash_bitbang_transfer(*buf++);
 	}
 }
 
-static bool spi_flash_busy(void)
+static void spi_flash_bitbang_readBuf(uint8_t *buf, int size)
+{
+	while(size-- > 0)
+	{
+		*buf++ = spi_flash_bitbang_transfer(0x00);
+	}
+}
+
+/*
+ * Block transfer backend.
+ *
+ * The flash pins are not routed to any of the DSPI peripherals on any of the supported platforms
+ * (e.g. the clock is on PTE5, which can only be SPI1_PCS2), so neither the DSPI nor the eDMA can be used.
+ * Instead the whole block is clocked in a single tight loop. The register addresses and pin masks are
+ * loaded once per block, the bit loop is unrolled and, for reads, MOSI is set low once rather than for every bit,
+ * which halves the number of GPIO bus accesses per bit compared with the original per byte transfer.
+ */
+#define SPI_FLASH_CLOCK_OUT_BIT(bit) \
+		clkPort->PCOR = clkMask; \
+		if (c & (bit)) { doPort->PSOR = doMask; } else { doPort->PCOR = doMask; } \
+		clkPort->PSOR = clkMask;
+
+#define SPI_FLASH_CLOCK_IN_BIT() \
+		clkPort->PCOR = clkMask; \
+		c = (c << 1) | ((diPort->PDIR >> Pin_SPI_FLASH_DI_U) & 0x01U); \
+		clkPort->PSOR = clkMask;
+
+static void spi_flash_block_writeBuf(const uint8_t *buf, int size)
+{
+	GPIO_Type *clkPort = GPIO_SPI_FLASH_CLK_U;
+	GPIO_Type *doPort = GPIO_SPI_FLASH_DO_U;
+	const uint32_t clkMask = 1U << Pin_SPI_FLASH_CLK_U;
+	const uint32_t doMask = 1U << Pin_SPI_FLASH_DO_U;
+	uint8_t c;
+
+	while(size-- > 0)
+	{
+		c = *buf++;
+		SPI_FLASH_CLOCK_OUT_BIT(0x80);
+		SPI_FLASH_CLOCK_OUT_BIT(0x40);
+		SPI_FLASH_CLOCK_OUT_BIT(0x20);
+		SPI_FLASH_CLOCK_OUT_BIT(0x10);
+		SPI_FLASH_CLOCK_OUT_BIT(0x08);
+		SPI_FLASH_CLOCK_OUT_BIT(0x04);
+		SPI_FLASH_CLOCK_OUT_BIT(0x02);
+		SPI_FLASH_CLOCK_OUT_BIT(0x01);
+	}
+}
+
+static void spi_flash_block_readBuf(uint8_t *buf, int size)
 {
-	uint8_t r1;
+	GPIO_Type *clkPort = GPIO_SPI_FLASH_CLK_U;
+	GPIO_Type *diPort = GPIO_SPI_FLASH_DI_U;
+	const uint32_t clkMask = 1U << Pin_SPI_FLASH_CLK_U;
+	uint32_t c;
 
-	spi_flash_enable();
-	spi_flash_transfer(R_SR1);
-	r1 = spi_flash_transfer(0xff);
-	spi_flash_disable();
+	GPIO_SPI_FLASH_DO_U->PCOR = 1U << Pin_SPI_FLASH_DO_U;// MOSI is ignored by the flash while data is being read out
 
-	if(r1 & SR1_BUSY_MASK)
+	while(size-- > 0)
+	{
+		c = 0;
+		SPI_FLASH_CLOCK_IN_BIT();
+		SPI_FLASH_CLOCK_IN_BIT();
+		SPI_FLASH_CLOCK_IN_BIT();
+		SPI_FLASH_CLOCK_IN_BIT();
+		SPI_FLASH_CLOCK_IN_BIT();
+		SPI_FLASH_CLOCK_IN_BIT();
+		SPI_FLASH_CLOCK_IN_BIT();
+		SPI_FLASH_CLOCK_IN_BIT();
+		*buf++ = c;
+	}
+}
+
+// Sends a single byte command and returns the byte which follows it
+static uint8_t spi_flash_transfer(uint8_t c)
+{
+	uint8_t r;
+
+	spiFlashTransport->select();
+	spiFlashTransport->writeBuf(&c, 1);
+	spiFlashTransport->readBuf(&r, 1);
+	spiFlashTransport->deselect();
+
+	return r;
+}
+
+static bool spi_flash_busy(void)
+{
+	if(spi_flash_transfer(R_SR1) & SR1_BUSY_MASK)
 	{
 		return true;
 	}
@@ -316,7 +810,9 @@ static bool spi_flash_busy(void)
 
 static void spi_flash_setWriteEnable(bool cmd)
 {
-	spi_flash_enable();
-	spi_flash_transfer(cmd ? W_EN : W_DE);
-	spi_flash_disable();
+	uint8_t c = (cmd ? W_EN : W_DE);
+
+	spiFlashTransport->select();
+	spiFlashTransport->writeBuf(&c, 1);
+	spiFlashTransport->deselect();
 }
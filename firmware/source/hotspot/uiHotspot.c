@@ -760,6 +760,9 @@ static void hotspotExit(void)
 	settingsUsbMode = USB_MODE_CPS;
 	mmdvmHostIsConnected = false;
 
+	// The ring was HOTSPOT_BUFFER_COUNT long, but there are only WAV_BUFFER_COUNT wave buffers
+	soundRingReset(WAV_BUFFER_COUNT);
+
 	menuHotspotRestoreSettings();
 	menuSystemPopAllAndDisplayRootMenu();
 }
@@ -1130,20 +1133,20 @@ static void storeNetFrame(volatile const uint8_t *com_requestbuffer)
 		hotspotState == HOTSPOT_STATE_TX_SHUTDOWN  ||
 		hotspotState == HOTSPOT_STATE_TX_START_BUFFERING)
 	{
-		if (wavbuffer_count >= HOTSPOT_BUFFER_COUNT)
+		if (soundRingCount() >= HOTSPOT_BUFFER_COUNT)
 		{
-			// Buffer overflow
+			// Buffer overflow. Drop the frame, MMDVMHost is told there is no space by getStatus()
+			return;
 		}
 
-		taskENTER_CRITICAL();
-		memcpy((uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[wavbuffer_write_idx][0x0C], (uint8_t *)com_requestbuffer + 4, 13);//copy the first 13, whole bytes of audio
-		audioAndHotspotDataBuffer.hotspotBuffer[wavbuffer_write_idx][0x0C + 13] = (com_requestbuffer[17] & 0xF0) | (com_requestbuffer[23] & 0x0F);
-		memcpy((uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[wavbuffer_write_idx][0x0C + 14], (uint8_t *)&com_requestbuffer[24], 13);//copy the last 13, whole bytes of audio
+		int writeBuffer = soundRingWriteBuffer();
+
+		memcpy((uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[writeBuffer][0x0C], (uint8_t *)com_requestbuffer + 4, 13);//copy the first 13, whole bytes of audio
+		audioAndHotspotDataBuffer.hotspotBuffer[writeBuffer][0x0C + 13] = (com_requestbuffer[17] & 0xF0) | (com_requestbuffer[23] & 0x0F);
+		memcpy((uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[writeBuffer][0x0C + 14], (uint8_t *)&com_requestbuffer[24], 13);//copy the last 13, whole bytes of audio
 
-		memcpy((uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[wavbuffer_write_idx], hotspotTxLC, 9);// copy the current LC into the data (mainly for use with the embedded data);
-		wavbuffer_count++;
-		wavbuffer_write_idx = ((wavbuffer_write_idx + 1) % HOTSPOT_BUFFER_COUNT);
-		taskEXIT_CRITICAL();
+		memcpy((uint8_t *)&audioAndHotspotDataBuffer.hotspotBuffer[writeBuffer], hotspotTxLC, 9);// copy the current LC into the data (mainly for use with the embedded data);
+		soundRingAdvanceWrite();
 	}
 
 }
@@ -1408,7 +1411,7 @@ static void hotspotStateMachine(void)
 				if ((nonVolatileSettings.hotspotType == HOTSPOT_TYPE_MMDVM) &&
 						((fw_millis() - mmdvmHostLastActiveTime) > MMDVMHOST_TIMEOUT))
 				{
-					wavbuffer_count = 0;
+					soundRingDiscard();
 
 					hotspotExit();
 					break;
@@ -1417,9 +1420,7 @@ static void hotspotStateMachine(void)
 			break;
 
 		case HOTSPOT_STATE_INITIALISE:
-			wavbuffer_read_idx = 0;
-			wavbuffer_write_idx = 0;
-			wavbuffer_count = 0;
+			soundRingReset(HOTSPOT_BUFFER_COUNT);
 			rfFrameBufCount = 0;
 
 			overriddenLCAvailable = false;
@@ -1435,9 +1436,7 @@ static void hotspotStateMachine(void)
 				disableTransmission();
 			}
 
-			wavbuffer_read_idx = 0;
-			wavbuffer_write_idx = 0;
-			wavbuffer_count = 0;
+			soundRingReset(HOTSPOT_BUFFER_COUNT);
 			rxFrameTime = fw_millis();
 
 			hotspotState = HOTSPOT_STATE_RX_PROCESS;
@@ -1453,7 +1452,7 @@ static void hotspotStateMachine(void)
 					mmdvmHostIsConnected = false;
 					hotspotState = HOTSPOT_STATE_NOT_CONNECTED;
 					rfFrameBufCount = 0;
-					wavbuffer_count = 0;
+					soundRingDiscard();
 
 					hotspotExit();
 					break;
@@ -1463,7 +1462,7 @@ static void hotspotStateMachine(void)
 			{
 				hotspotState = HOTSPOT_STATE_NOT_CONNECTED;
 				rfFrameBufCount = 0;
-				wavbuffer_count = 0;
+				soundRingDiscard();
 
 				if (trxTransmissionEnabled)
 				{
@@ -1597,7 +1596,7 @@ static void hotspotStateMachine(void)
 			}
 			else
 			{
-				if (wavbuffer_count > TX_BUFFER_MIN_BEFORE_TRANSMISSION)
+				if (soundRingCount() > TX_BUFFER_MIN_BEFORE_TRANSMISSION)
 				{
 					if (cwKeying == false)
 					{
@@ -1619,7 +1618,7 @@ static void hotspotStateMachine(void)
 
 		case HOTSPOT_STATE_TRANSMITTING:
 			// Stop transmitting when there is no data in the buffer or if MMDVMHost sends the idle command
-			if (wavbuffer_count == 0 || modemState == STATE_IDLE)
+			if (soundRingCount() == 0 || modemState == STATE_IDLE)
 			{
 				hotspotState = HOTSPOT_STATE_TX_SHUTDOWN;
 				trxTransmissionEnabled = false;
@@ -1631,7 +1630,7 @@ static void hotspotStateMachine(void)
 			if (txstopdelay > 0)
 			{
 				txstopdelay--;
-				if (wavbuffer_count > 0)
+				if (soundRingCount() > 0)
 				{
 					// restart
 					enableTransmission();
@@ -1739,7 +1738,7 @@ static bool hasRXOverflow(void)
 
 static bool hasTXOverflow(void)
 {
-	return ((HOTSPOT_BUFFER_COUNT - wavbuffer_count) <= 0);
+	return ((HOTSPOT_BUFFER_COUNT - soundRingCount()) <= 0);
 }
 
 static void getStatus(void)
@@ -1770,7 +1769,7 @@ static void getStatus(void)
 	buf[6U]  = 0U; // No DSTAR space
 
 	buf[7U]  = 10U; // DMR Simplex
-	buf[8U]  = (HOTSPOT_BUFFER_COUNT - wavbuffer_count); // DMR space
+	buf[8U]  = (HOTSPOT_BUFFER_COUNT - soundRingCount()); // DMR space
 
 	buf[9U]  = 0U; // No YSF space
 	buf[10U] = 0U; // No P25 space
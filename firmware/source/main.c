@@ -24,6 +24,8 @@
 #include <user_interface/uiUtilities.h>
 #include <user_interface/uiLocalisation.h>
 #include <functions/voicePrompts.h>
+#include <functions/flashStore.h>
+#include <functions/callLog.h>
 
 
 #if defined(USE_SEGGER_RTT)
@@ -67,8 +69,6 @@ void mainTaskInit(void)
 
 void powerOffFinalStage(void)
 {
-	uint32_t m;
-
 	// If user was in a private call when they turned the radio off we need to restore the last Tg prior to stating the Private call.
 	// to the nonVolatile Setting overrideTG, otherwise when the radio is turned on again it be in PC mode to that station.
 	if ((trxTalkGroupOrPcId >> 24) == PC_CALL_FLAG)
@@ -78,18 +78,15 @@ void powerOffFinalStage(void)
 
 	menuHotspotRestoreSettings();
 
-	m = fw_millis();
+	fw_operatingTimeTick(true);
+	callLogFlush();
+	SPI_Flash_flushCache();
+
 	settingsSaveSettings(true);
 
-	// Give it a bit of time before pulling the plug as DM-1801 EEPROM looks slower
-	// than GD-77 to write, then quickly power cycling triggers settings reset.
-	while (1U)
-	{
-		if ((fw_millis() - m) > 50)
-		{
-			break;
-		}
-	}
+	// Wait for the EEPROM to complete the write before pulling the plug, as quickly
+	// power cycling during the write (DM-1801 EEPROM looks slower than GD-77) triggers settings reset.
+	EEPROM_Flush();
 
 	settingsSet(nonVolatileSettings.displayBacklightPercentageOff, 0);
 	displayEnableBacklight(false);
@@ -270,10 +267,17 @@ void mainTask(void *data)
 		settingsEraseCustomContent();
 	}
 
+	flashStoreInit();
+	settingsLoadFlashStoreVFOs();
+	fw_operatingTimeInit();
+	callLogInit();
 	lastheardInitList();
 	codeplugInitContactsCache();
+	codeplugInitChannelsValidCache();
+	codeplugInitZonesCache();
 	dmrIDCacheInit();
 	voicePromptsCacheInit();
+	lastheardRestoreFromCallLog();
 
 	if (wasRestoringDefaultsettings)
 	{
@@ -875,6 +879,11 @@ void mainTask(void *data)
 			}
 			soundTickMelody();
 			voxTick();
+			EEPROM_Tick();
+			SPI_Flash_cacheTick();
+			flashStoreTick();
+			fw_operatingTimeTick(false);
+			callLogTick();
 
 #if defined(PLATFORM_RD5R) // Needed for platforms which can't control the poweroff
 			settingsSaveIfNeeded(false);
@@ -18,6 +18,7 @@
 #include <hotspot/uiHotspot.h>
 #include <settings.h>
 #include <user_interface/uiUtilities.h>
+#include <functions/callLog.h>
 #include <user_interface/menuSystem.h>
 #include <stdarg.h>
 #include <usb_com.h>
@@ -37,6 +38,7 @@ __attribute__((section(".data.$RAM2"))) volatile uint8_t com_requestbuffer[COM_R
 __attribute__((section(".data.$RAM2"))) USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE) uint8_t usbComSendBuf[COM_BUFFER_SIZE];//DATA_BUFF_SIZE
 int sector = -1;
 static bool flashingDMRIDs = false;
+static bool dmrIDBloomFilterReleased = false;
 
 
 void tick_com_request(void)
@@ -64,7 +66,27 @@ void tick_com_request(void)
 	}
 }
 
-enum CPS_ACCESS_AREA { CPS_ACCESS_FLASH = 1,CPS_ACCESS_EEPROM = 2, CPS_ACCESS_MCU_ROM=5,CPS_ACCESS_DISPLAY_BUFFER=6,CPS_ACCESS_WAV_BUFFER=7,CPS_COMPRESS_AND_ACCESS_AMBE_BUFFER=8};
+enum CPS_ACCESS_AREA { CPS_ACCESS_FLASH = 1,CPS_ACCESS_EEPROM = 2, CPS_ACCESS_MCU_ROM=5,CPS_ACCESS_DISPLAY_BUFFER=6,CPS_ACCESS_WAV_BUFFER=7,CPS_COMPRESS_AND_ACCESS_AMBE_BUFFER=8,CPS_ACCESS_STATS=9,CPS_ACCESS_CALL_LOG=10};
+
+// Statistics which can be read by the CPS, as little endian uint32_t values. The address is the byte offset.
+// New values must be added at the end, so the existing offsets don't change.
+enum CPS_STATS { CPS_STATS_DMRID_LOOKUP_CACHE_HITS = 0, CPS_STATS_DMRID_LOOKUP_CACHE_MISSES, CPS_STATS_CALL_LOG_RECORDS,
+	CPS_STATS_PLAYOUT_DELAY_MS, CPS_STATS_PLAYOUT_JITTER_MS, CPS_STATS_PLAYOUT_UNDERRUNS, CPS_STATS_PLAYOUT_CONCEALED_BUFFERS,
+	CPS_STATS_OPERATING_TIME, CPS_STATS_EEPROM_WRITE_FAILURES, CPS_STATS_EEPROM_PAGES_DROPPED, NUM_CPS_STATS };
+
+static void cpsGetStats(uint32_t *stats)
+{
+	stats[CPS_STATS_DMRID_LOOKUP_CACHE_HITS] = dmrIDLookupCacheStats.hits;
+	stats[CPS_STATS_DMRID_LOOKUP_CACHE_MISSES] = dmrIDLookupCacheStats.misses;
+	stats[CPS_STATS_CALL_LOG_RECORDS] = callLogGetNumRecords();
+	stats[CPS_STATS_PLAYOUT_DELAY_MS] = soundPlayoutStats.delayMs;
+	stats[CPS_STATS_PLAYOUT_JITTER_MS] = soundPlayoutStats.jitterMs;
+	stats[CPS_STATS_PLAYOUT_UNDERRUNS] = soundPlayoutStats.underruns;
+	stats[CPS_STATS_PLAYOUT_CONCEALED_BUFFERS] = soundPlayoutStats.concealedBuffers;
+	stats[CPS_STATS_OPERATING_TIME] = fw_operatingSeconds();
+	stats[CPS_STATS_EEPROM_WRITE_FAILURES] = eepromStats.writeFailures;
+	stats[CPS_STATS_EEPROM_PAGES_DROPPED] = eepromStats.pagesDropped;
+}
 
 static void cpsHandleReadCommand(void)
 {
@@ -112,6 +134,40 @@ static void cpsHandleReadCommand(void)
 				result = true;
 			}
 			break;
+		case CPS_ACCESS_STATS:
+			{
+				uint32_t stats[NUM_CPS_STATS];
+
+				if (address < sizeof(stats))
+				{
+					cpsGetStats(stats);
+					if (length > (sizeof(stats) - address))
+					{
+						length = sizeof(stats) - address;
+					}
+					memcpy(&usbComSendBuf[3], (uint8_t *)stats + address, length);
+					result = true;
+				}
+			}
+			break;
+		case CPS_ACCESS_CALL_LOG:// the address is the record number, 0 = oldest call. Corrupt records are sent as they are, the CPS checks the CRC
+			{
+				callLogRecord_t record;
+
+				if ((int)address < callLogGetNumRecords())
+				{
+					taskEXIT_CRITICAL();
+					callLogReadRecord(address, &record);
+					taskENTER_CRITICAL();
+					if (length > sizeof(callLogRecord_t))
+					{
+						length = sizeof(callLogRecord_t);
+					}
+					memcpy(&usbComSendBuf[3], (uint8_t *)&record, length);
+					result = true;
+				}
+			}
+			break;
 	}
 
 	if (result)
@@ -144,6 +200,11 @@ static void cpsHandleWriteCommand(void)
 					flashingDMRIDs = true;
 				}
 
+				if (dmrIDBloomFilterRelease())// It was using SPI_Flash_sectorbuffer
+				{
+					dmrIDBloomFilterReleased = true;
+				}
+
 				taskEXIT_CRITICAL();
 				ok = SPI_Flash_read(sector * 4096, SPI_Flash_sectorbuffer, 4096);
 				taskENTER_CRITICAL();
@@ -179,7 +240,7 @@ static void cpsHandleWriteCommand(void)
 				// A better solution will be added to the CPS and firmware at a later date.
 				if ((sector * 4096) == VOICE_PROMPTS_FLASH_HEADER_ADDRESS)
 				{
-					nonVolatileSettings.audioPromptMode =	AUDIO_PROMPT_MODE_VOICE_LEVEL_1;
+					settingsSet(nonVolatileSettings.audioPromptMode, AUDIO_PROMPT_MODE_VOICE_LEVEL_1);
 				}
 #endif
 				taskEXIT_CRITICAL();
@@ -199,6 +260,8 @@ static void cpsHandleWriteCommand(void)
 					}
 				}
 				sector = -1;
+				codeplugCachesInvalidate();
+				dmrIDLookupCacheInvalidate();// The contacts or the DMR ID database may have changed
 			}
 			break;
 		case 4:
@@ -212,6 +275,7 @@ static void cpsHandleWriteCommand(void)
 				}
 
 				ok = EEPROM_Write(address, (uint8_t*)com_requestbuffer + 8, length);
+				codeplugCachesInvalidate();
 			}
 			break;
 		case CPS_ACCESS_WAV_BUFFER:// write to raw audio buffer
@@ -219,7 +283,9 @@ static void cpsHandleWriteCommand(void)
 				uint32_t address = (com_requestbuffer[2] << 24) + (com_requestbuffer[3] << 16) + (com_requestbuffer[4] << 8) + (com_requestbuffer[5] << 0);
 				uint32_t length = (com_requestbuffer[6] << 8) + (com_requestbuffer[7] << 0);
 
-				wavbuffer_count = (address + length) / WAV_BUFFER_SIZE;
+				// The encoder reads the wave buffers from the start of the buffer every time
+				soundRingReset(WAV_BUFFER_COUNT);
+				wavbufferRing.writeIdx = (address + length) / WAV_BUFFER_SIZE;
 				memcpy((uint8_t *)&audioAndHotspotDataBuffer.rawBuffer[address], (uint8_t *)&com_requestbuffer[8], length);
 				ok = true;
 			}
@@ -267,38 +333,40 @@ static void cpsHandleCommand(void)
 			break;
 		case 5:
 			// Close
-			if (flashingDMRIDs)
+			if (flashingDMRIDs || dmrIDBloomFilterReleased)
 			{
 				dmrIDCacheInit();
 				flashingDMRIDs = false;
+				dmrIDBloomFilterReleased = false;
 			}
 			uiCPSUpdate(CPS2UI_COMMAND_END, 0, 0, FONT_SIZE_1, TEXT_ALIGN_LEFT, 0, NULL);
 			break;
 		case 6:
 			{
 				int subCommand = com_requestbuffer[2];
-				uint32_t m = fw_millis();
 
 				// Do some other processing
 				switch(subCommand)
 				{
 					case 0:
 						// save current settings and reboot
-						m = fw_millis();
+						fw_operatingTimeTick(true);
+						callLogFlush();
+						settingsDiscardFlashStoreVFOs();// The CPS may have written new VFOs to the codeplug
+						SPI_Flash_flushCache();
 						settingsSaveSettings(false);// Need to save these channels prior to reboot, as reboot does not save
 
-						// Give it a bit of time before pulling the plug as DM-1801 EEPROM looks slower
+						// Wait for the EEPROM to complete the write before pulling the plug, as DM-1801 EEPROM looks slower
 						// than GD-77 to write, then quickly power cycling triggers settings reset.
-						while (1U)
-						{
-							if ((fw_millis() - m) > 50)
-							{
-								break;
-							}
-						}
+						EEPROM_Flush();
 						watchdogReboot();
 					break;
 					case 1:
+						fw_operatingTimeTick(true);
+						callLogFlush();
+						settingsDiscardFlashStoreVFOs();// The CPS may have written new VFOs to the codeplug
+						SPI_Flash_flushCache();
+						EEPROM_Flush();
 						watchdogReboot();
 						break;
 					case 2:
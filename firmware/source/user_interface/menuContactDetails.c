@@ -420,6 +420,7 @@ static void handleEvent(uiEvent_t *ev)
 											}
 										}
 										codeplugContactSaveDataForIndex(contactDetailsIndex, &tmpContact);
+										dmrIDLookupCacheInvalidate();
 										menuContactDetailsTimeout = 2000;
 										menuContactDetailsState = MENU_CONTACT_DETAILS_SAVED;
 										voicePromptsInit();
@@ -325,6 +325,7 @@ static void handleEvent(uiEvent_t *ev)
 				contact.tgNumber = 0;
 				contact.callType = 0xFF;
 				codeplugContactSaveDataForIndex(contactListContactIndex, &contact);
+				dmrIDLookupCacheInvalidate();
 				contactListContactIndex = 0;
 				menuContactListTimeout = 2000;
 				menuContactListDisplayState = MENU_CONTACT_LIST_DELETED;
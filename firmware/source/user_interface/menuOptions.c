@@ -396,6 +396,8 @@ static void handleEvent(uiEvent_t *ev)
 		if (doFactoryReset == true)
 		{
 			settingsRestoreDefaultSettings();
+			SPI_Flash_flushCache();
+			EEPROM_Flush();
 			watchdogReboot();
 		}
 
@@ -406,7 +408,7 @@ static void handleEvent(uiEvent_t *ev)
 	else if (KEYCHECK_SHORTUP(ev->keys, KEY_RED))
 	{
 		// Restore original settings.
-		memcpy(&nonVolatileSettings, &originalNonVolatileSettings, sizeof(settingsStruct_t));
+		settingsRestoreFromCopy(&originalNonVolatileSettings);
 		settingsSaveIfNeeded(true);
 		menuSystemPopPreviousMenu();
 		return;
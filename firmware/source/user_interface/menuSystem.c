@@ -291,6 +291,7 @@ void menuSystemLanguageHasChanged(void)
 {
 	// Force full update of menuChannelMode() on next call (if isFirstRun arg. is true)
 	uiChannelModeColdStart();
+	displayNameCacheInvalidate();// Some names include translated text
 }
 
 const menuItemNewData_t mainMenuItems[] =
@@ -57,7 +57,7 @@ static void updateScreen(bool isFirstRun)
 {
 	char nameBuf[17];
 	int mNum;
-	struct_codeplugZone_t zoneBuf;
+	char zoneName[16];
 
 	ucClearBuf();
 	menuDisplayTitle(currentLanguage->zones);
@@ -71,8 +71,8 @@ static void updateScreen(bool isFirstRun)
 
 		mNum = menuGetMenuOffset(gMenusEndIndex, i);
 
-		codeplugZoneGetDataForNumber(mNum, &zoneBuf);
-		codeplugUtilConvertBufToString(zoneBuf.name, nameBuf, 16);// need to convert to zero terminated string
+		codeplugZoneGetNameForNumber(mNum, zoneName);
+		codeplugUtilConvertBufToString(zoneName, nameBuf, 16);// need to convert to zero terminated string
 
 		menuDisplayEntry(i, mNum, (char *)nameBuf);
 
@@ -272,29 +272,10 @@ static void searchNextChannel(void)
 
 	if (currentZone.NOT_IN_MEMORY_isAllChannelsZone)
 	{
-		do
-		{
-			nextChannelIndex += scanDirection;
-			if (scanDirection == 1)
-			{
-				if (nextChannelIndex > CODEPLUG_CONTACTS_MAX)
-				{
-					nextChannelIndex = CODEPLUG_CONTACTS_MIN;
-				}
-			}
-			else
-			{
-				// Note this is inefficient check all the index down from 1024 until it gets to the first valid index from the end.
-				// To improve this. Highest valid channel number would need to be found and cached when the radio boots up
-				if (nextChannelIndex < CODEPLUG_CONTACTS_MIN)
-				{
-					nextChannelIndex = CODEPLUG_CONTACTS_MAX;
-				}
-			}
-		} while(!codeplugChannelIndexIsValid(nextChannelIndex));
+		nextChannelIndex = codeplugChannelGetNextValidIndex(nextChannelIndex, scanDirection);
 
 		channel = nextChannelIndex;
-		codeplugChannelGetDataForIndex(nextChannelIndex, &channelNextChannelData);
+		codeplugChannelGetDataForScan(nextChannelIndex, &channelNextChannelData);
 	}
 	else
 	{
@@ -313,7 +294,7 @@ static void searchNextChannel(void)
 				nextChannelIndex = currentZone.NOT_IN_MEMORY_numChannelsInZone - 1;
 			}
 		}
-		codeplugChannelGetDataForIndex(currentZone.channels[nextChannelIndex], &channelNextChannelData);
+		codeplugChannelGetDataForScan(currentZone.channels[nextChannelIndex], &channelNextChannelData);
 		channel = currentZone.channels[nextChannelIndex];
 	}
 
@@ -356,7 +337,8 @@ static void setNextChannel(void)
 
 	lastHeardClearLastID();
 
-	loadChannelData(false, true);
+	memcpy(&channelScreenChannelData, &channelNextChannelData, sizeof(struct_codeplugChannel_t));// Already read by searchNextChannel()
+	loadChannelData(true, true);
 	menuDisplayQSODataState = QSO_DISPLAY_DEFAULT_SCREEN;
 	uiChannelModeUpdateScreen(0);
 
@@ -1192,14 +1174,8 @@ static void handleEvent(uiEvent_t *ev)
 				lastHeardClearLastID();
 				if (currentZone.NOT_IN_MEMORY_isAllChannelsZone)
 				{
-					do
-					{
-						settingsDecrement(nonVolatileSettings.currentChannelIndexInAllZone, 1);
-						if (nonVolatileSettings.currentChannelIndexInAllZone < CODEPLUG_CONTACTS_MIN)
-						{
-							settingsSet(nonVolatileSettings.currentChannelIndexInAllZone, CODEPLUG_CONTACTS_MAX);
-						}
-					} while(!codeplugChannelIndexIsValid(nonVolatileSettings.currentChannelIndexInAllZone));
+					settingsSet(nonVolatileSettings.currentChannelIndexInAllZone,
+							(int16_t)codeplugChannelGetNextValidIndex(nonVolatileSettings.currentChannelIndexInAllZone, -1));
 
 					if (nonVolatileSettings.currentChannelIndexInAllZone == 1)
 					{
@@ -1334,17 +1310,13 @@ static void handleUpKey(uiEvent_t *ev)
 		lastHeardClearLastID();
 		if (currentZone.NOT_IN_MEMORY_isAllChannelsZone)
 		{
-			do
-			{
-				settingsIncrement(nonVolatileSettings.currentChannelIndexInAllZone, 1);
+			int16_t nextIndex = codeplugChannelGetNextValidIndex(nonVolatileSettings.currentChannelIndexInAllZone, 1);
 
-				if (nonVolatileSettings.currentChannelIndexInAllZone > CODEPLUG_CONTACTS_MAX)
-				{
-					settingsSet(nonVolatileSettings.currentChannelIndexInAllZone, 1);
-					menuChannelExitStatus |= (MENU_STATUS_LIST_TYPE | MENU_STATUS_FORCE_FIRST);
-				}
-
-			} while(!codeplugChannelIndexIsValid(nonVolatileSettings.currentChannelIndexInAllZone));
+			if (nextIndex <= nonVolatileSettings.currentChannelIndexInAllZone)
+			{
+				menuChannelExitStatus |= (MENU_STATUS_LIST_TYPE | MENU_STATUS_FORCE_FIRST);// wrapped around
+			}
+			settingsSet(nonVolatileSettings.currentChannelIndexInAllZone, nextIndex);
 		}
 		else
 		{
@@ -2386,8 +2358,12 @@ static void handleEventForGD77S(uiEvent_t *ev)
 					break;
 
 				case GD77S_UIMODE_ZONE: // Zones
+				{
 					// No "All Channels" on GD77S
-					menuSystemMenuIncrement((int32_t *)&nonVolatileSettings.currentZone, (codeplugZonesGetCount() - 1));
+					int32_t zone = nonVolatileSettings.currentZone;// currentZone is only 16 bits, and must be marked as changed
+
+					menuSystemMenuIncrement(&zone, (codeplugZonesGetCount() - 1));
+					settingsSet(nonVolatileSettings.currentZone, (int16_t)zone);
 
 					settingsSet(nonVolatileSettings.overrideTG, 0); // remove any TG override
 					tsSetOverride(CHANNEL_CHANNEL, TS_NO_OVERRIDE);
@@ -2398,7 +2374,8 @@ static void handleEventForGD77S(uiEvent_t *ev)
 					GD77SParameters.uiMode = GD77S_UIMODE_ZONE;
 
 					announceItem(PROMPT_SEQUENCE_ZONE, PROMPT_THRESHOLD_3);
-					break;
+				}
+				break;
 
 				case GD77S_UIMODE_POWER: // Power
 					if (nonVolatileSettings.txPowerLevel < MAX_POWER_SETTING_NUM)
@@ -2560,8 +2537,12 @@ static void handleEventForGD77S(uiEvent_t *ev)
 					break;
 
 				case GD77S_UIMODE_ZONE: // Zones
+				{
 					// No "All Channels" on GD77S
-					menuSystemMenuDecrement((int32_t *)&nonVolatileSettings.currentZone, (codeplugZonesGetCount() - 1));
+					int32_t zone = nonVolatileSettings.currentZone;// currentZone is only 16 bits, and must be marked as changed
+
+					menuSystemMenuDecrement(&zone, (codeplugZonesGetCount() - 1));
+					settingsSet(nonVolatileSettings.currentZone, (int16_t)zone);
 
 					settingsSet(nonVolatileSettings.overrideTG, 0); // remove any TG override
 					tsSetOverride(CHANNEL_CHANNEL, TS_NO_OVERRIDE);
@@ -2572,7 +2553,8 @@ static void handleEventForGD77S(uiEvent_t *ev)
 					GD77SParameters.uiMode = GD77S_UIMODE_ZONE;
 
 					announceItem(PROMPT_SEQUENCE_ZONE, PROMPT_THRESHOLD_3);
-					break;
+				}
+				break;
 
 				case GD77S_UIMODE_POWER: // Power
 					if (nonVolatileSettings.txPowerLevel > 0)
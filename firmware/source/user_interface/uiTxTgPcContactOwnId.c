@@ -28,10 +28,18 @@ static char digits[9];
 static int pcIdx;
 static struct_codeplugContact_t contact;
 
+// Private Call entry by callsign, when the DMR ID database has a callsign index
+static bool callsignMode;
+static char callsignPrefix[DMRID_CALLSIGN_MAX_LENGTH + 1];
+static char callsignPreviewChar;
+static char callsignMatch[DMRID_CALLSIGN_MAX_LENGTH + 1];
+static int callsignPos;
+
 static void updateCursor(void);
 static void updateScreen(bool inputModeHasChanged);
 static void handleEvent(uiEvent_t *ev);
 static void announceContactName(void);
+static void handleCallsignEntry(uiEvent_t *ev);
 
 static const uint32_t CURSOR_UPDATE_TIMEOUT = 500;
 
@@ -53,6 +61,7 @@ menuStatus_t menuNumericalEntry(uiEvent_t *ev, bool isFirstRun)
 		gMenusCurrentItemIndex = ENTRY_TG;
 		digits[0] = 0;
 		pcIdx = 0;
+		callsignMode = false;
 		updateScreen(true);
 		return (MENU_STATUS_INPUT_TYPE | MENU_STATUS_SUCCESS);
 	}
@@ -88,7 +97,7 @@ static void updateCursor(void)
 	size_t sLen;
 
 	// Display blinking cursor only when digits could be entered.
-	if ((gMenusCurrentItemIndex != ENTRY_SELECT_CONTACT) && ((sLen = strlen(digits)) <= NUM_PC_OR_TG_DIGITS))
+	if ((gMenusCurrentItemIndex != ENTRY_SELECT_CONTACT) && (callsignMode == false) && ((sLen = strlen(digits)) <= NUM_PC_OR_TG_DIGITS))
 	{
 		static uint32_t lastBlink = 0;
 		static bool     blink = false;
@@ -148,7 +157,22 @@ static void updateScreen(bool inputModeHasChanged)
 		voicePromptsPlay();
 	}
 
-	if (pcIdx == 0)
+	if (callsignMode)
+	{
+		snprintf(buf, sizeof(buf), "%s%c", callsignPrefix, ((callsignPreviewChar != 0) ? callsignPreviewChar : '_'));
+		ucPrintCentered((DISPLAY_SIZE_Y / 2), buf, FONT_SIZE_3);
+
+		if (callsignPos >= 0)
+		{
+			snprintf(buf, sizeof(buf), "%s %s", callsignMatch, digits);
+		}
+		else
+		{
+			snprintf(buf, sizeof(buf), "%s", ((strlen(callsignPrefix) > 0) ? "?" : ""));
+		}
+		ucPrintCentered((DISPLAY_SIZE_Y - 12), buf, FONT_SIZE_1);
+	}
+	else if (pcIdx == 0)
 	{
 		ucPrintCentered((DISPLAY_SIZE_Y / 2), (char *)digits, FONT_SIZE_3);
 	}
@@ -191,6 +215,82 @@ static void announceContactName(void)
 	}
 }
 
+// Show the callsign at callsignPos, and put its ID in digits, so it is used when Green is pressed
+static void updateCallsignMatch(void)
+{
+	uint32_t id;
+
+	if ((callsignPos >= 0) && dmrIDCallsignGetEntry(callsignPos, callsignPrefix, callsignMatch, &id))
+	{
+		snprintf(digits, sizeof(digits), "%u", id);
+
+		if (nonVolatileSettings.audioPromptMode >= AUDIO_PROMPT_MODE_VOICE_LEVEL_1)
+		{
+			voicePromptsInit();
+			voicePromptsAppendString(callsignMatch);
+			voicePromptsPlay();
+		}
+	}
+	else
+	{
+		callsignPos = -1;
+		callsignMatch[0] = 0;
+		digits[0] = 0;
+	}
+}
+
+static void handleCallsignEntry(uiEvent_t *ev)
+{
+	size_t sLen = strlen(callsignPrefix);
+	char c = ev->keys.key;
+
+	if (ev->keys.event == KEY_MOD_PREVIEW)
+	{
+		callsignPreviewChar = c;
+		updateScreen(false);
+		return;
+	}
+
+	if (KEYCHECK_PRESS(ev->keys, KEY_LEFT))
+	{
+		if (sLen > 0)
+		{
+			callsignPrefix[sLen - 1] = 0;
+			callsignPos = dmrIDCallsignFind(callsignPrefix);
+			updateCallsignMatch();
+		}
+	}
+	else if (KEYCHECK_PRESS(ev->keys, KEY_DOWN) || KEYCHECK_PRESS(ev->keys, KEY_UP))
+	{
+		// Step through the callsigns which start with the prefix
+		int pos = callsignPos + (KEYCHECK_PRESS(ev->keys, KEY_DOWN) ? 1 : -1);
+		uint32_t id;
+
+		if ((callsignPos >= 0) && dmrIDCallsignGetEntry(pos, callsignPrefix, callsignMatch, &id))
+		{
+			callsignPos = pos;
+		}
+		updateCallsignMatch();
+	}
+	else if ((ev->keys.event == KEY_MOD_PRESS) && (((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9'))))
+	{
+		if (sLen < DMRID_CALLSIGN_MAX_LENGTH)
+		{
+			callsignPrefix[sLen] = ((c >= 'a') && (c <= 'z')) ? (c - ('a' - 'A')) : c;
+			callsignPrefix[sLen + 1] = 0;
+			callsignPos = dmrIDCallsignFind(callsignPrefix);
+			updateCallsignMatch();
+		}
+	}
+	else
+	{
+		return;
+	}
+
+	callsignPreviewChar = 0;
+	updateScreen(false);
+}
+
 static void handleEvent(uiEvent_t *ev)
 {
 	size_t sLen;
@@ -291,6 +391,8 @@ static void handleEvent(uiEvent_t *ev)
 			if (KEYCHECK_SHORTUP(ev->keys, KEY_HASH))
 			{
 				pcIdx = 0;
+				callsignMode = false;
+				keypadAlphaEnable = false;
 
 				menuNumericalExitStatus |= MENU_STATUS_INPUT_TYPE;
 
@@ -326,9 +428,27 @@ static void handleEvent(uiEvent_t *ev)
 				}
 				updateScreen(true);
 			}
+			else if ((gMenusCurrentItemIndex == ENTRY_PC) && (callsignMode == false) && KEYCHECK_SHORTUP(ev->keys, KEY_STAR) && dmrIDCallsignIndexAvailable())
+			{
+				// Switch to entering the callsign, using the alpha keypad
+				callsignMode = true;
+				keypadAlphaEnable = true;
+				callsignPrefix[0] = 0;
+				callsignPreviewChar = 0;
+				callsignPos = -1;
+				digits[0] = 0;
+				updateScreen(false);
+				return;
+			}
 		}
 	}
 
+	if (callsignMode)
+	{
+		handleCallsignEntry(ev);
+		return;
+	}
+
 	if (gMenusCurrentItemIndex == ENTRY_SELECT_CONTACT)
 	{
 		int idx = pcIdx;
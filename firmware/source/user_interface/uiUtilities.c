@@ -26,6 +26,10 @@
 #include <SPI_Flash.h>
 #include <ticks.h>
 #include <trx.h>
+#include <functions/callLog.h>
+#if defined(USE_SEGGER_RTT)
+#include <SeggerRTT/RTT/SEGGER_RTT.h>
+#endif
 
 settingsStruct_t originalNonVolatileSettings;
 
@@ -39,10 +43,35 @@ static const int BAR_Y_POS = 10;
 
 
 static const int DMRID_MEMORY_STORAGE_START = 0x30000;
+static const uint32_t DMRID_MEMORY_STORAGE_END = 0x7B000;// the codeplug starts here, see the Flash map in SPI_Flash.h
 static const int DMRID_HEADER_LENGTH = 0x0C;
+static const uint8_t DMRID_COMPRESSED_VERSION = 1;
+static const char DMRID_COMPRESSED_CHARSET[64] = " ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-";
+#define DMRID_COMPRESSED_MAX_TEXT_LENGTH 16
+#define DMRID_COMPRESSED_FLAG_CALLSIGN_INDEX 0x01
+#define DMRID_COMPRESSED_FLAG_BLOOM_FILTER   0x02
+#define DMRID_CALLSIGN_INDEX_ENTRY_SIZE 9
 __attribute__((section(".data.$RAM4"))) LinkItem_t callsList[NUM_LASTHEARD_STORED];
 LinkItem_t *LinkHead = callsList;
 int numLastHeard=0;
+
+// Hash of the last heard items on their DMR ID, chained through lastheardHashNext. Both hold the callsList index + 1, 0 = end of chain.
+// The list itself is kept in most recently heard order, with LinkHead at the top and lastheardTail the item to be reused next.
+#if (NUM_LASTHEARD_STORED <= 32)
+#define LASTHEARD_HASH_BITS 6
+#elif (NUM_LASTHEARD_STORED <= 64)
+#define LASTHEARD_HASH_BITS 7
+#elif (NUM_LASTHEARD_STORED <= 128)
+#define LASTHEARD_HASH_BITS 8
+#else
+#define LASTHEARD_HASH_BITS 9
+#endif
+#define LASTHEARD_HASH_SIZE (1 << LASTHEARD_HASH_BITS)
+_Static_assert(LASTHEARD_HASH_SIZE >= (2 * NUM_LASTHEARD_STORED), "The last heard hash chains get long");
+_Static_assert(NUM_LASTHEARD_STORED < 255, "The hash links are uint8_t callsList index + 1");
+static uint8_t lastheardHashBuckets[LASTHEARD_HASH_SIZE];
+static uint8_t lastheardHashNext[NUM_LASTHEARD_STORED];
+static LinkItem_t *lastheardTail = &callsList[NUM_LASTHEARD_STORED - 1];
 int menuDisplayQSODataState = QSO_DISPLAY_DEFAULT_SCREEN;
 int qsodata_timer;
 const uint32_t RSSI_UPDATE_COUNTER_RELOAD = 100;
@@ -64,6 +93,36 @@ volatile uint32_t lastID = 0;// This needs to be volatile as lastHeardClearLastI
 uint32_t lastTG = 0;
 
 static dmrIDsCache_t dmrIDsCache;
+static spiFlashStream_t dmrIDStream;
+
+typedef struct
+{
+	uint32_t key;// Source in the top byte, ID in the lower 24 bits, 0 = unused
+	uint32_t lastUsed;
+	bool     found;
+	char     text[20];
+} dmrIDLookupCacheEntry_t;
+
+#define DMRID_LOOKUP_SOURCE_DMRIDS      1
+#define DMRID_LOOKUP_SOURCE_CONTACTS    2// + call type
+
+static dmrIDLookupCacheEntry_t dmrIDLookupCache[DMRID_LOOKUP_CACHE_SIZE];
+static uint32_t dmrIDLookupCacheUseCounter = 0;
+dmrIDLookupCacheStats_t dmrIDLookupCacheStats;
+
+// The formatted names shown on the QSO screen and in the last heard list
+typedef struct
+{
+	uint32_t key;// Kind in the top byte, TG or PC number in the lower 24 bits, 0 = unused
+	uint32_t lastUsed;
+	uint8_t  contactDisplayPriority;
+	char     text[21];
+} displayNameCacheEntry_t;
+
+enum DISPLAY_NAME_KIND { DISPLAY_NAME_CALLER = 1, DISPLAY_NAME_PC_DESTINATION, DISPLAY_NAME_TALKGROUP, DISPLAY_NAME_TX_TG, DISPLAY_NAME_TX_PC };
+
+static displayNameCacheEntry_t displayNameCache[DISPLAY_NAME_CACHE_SIZE];
+static uint32_t displayNameCacheUseCounter = 0;
 
 int nuisanceDelete[MAX_ZONE_SCAN_NUISANCE_CHANNELS];
 int nuisanceDeleteIndex;
@@ -223,9 +282,67 @@ int32_t getFirstSpacePos(char *str)
 	return -1;
 }
 
+static inline uint32_t lastheardHashBucket(uint32_t id)
+{
+	return ((id * 2654435761U) >> (32 - LASTHEARD_HASH_BITS));// Knuth multiplicative hash
+}
+
+static void lastheardHashInsert(LinkItem_t *item)
+{
+	uint32_t bucket = lastheardHashBucket(item->id);
+	int itemIndex = item - callsList;
+
+	lastheardHashNext[itemIndex] = lastheardHashBuckets[bucket];
+	lastheardHashBuckets[bucket] = itemIndex + 1;
+}
+
+static void lastheardHashRemove(LinkItem_t *item)
+{
+	uint8_t *link = &lastheardHashBuckets[lastheardHashBucket(item->id)];
+	int itemIndex = item - callsList;
+
+	while (*link != 0)
+	{
+		if (*link == (itemIndex + 1))
+		{
+			*link = lastheardHashNext[itemIndex];
+			return;
+		}
+		link = &lastheardHashNext[*link - 1];
+	}
+}
+
+// Move the item to the top of the list
+static void lastheardMoveToFront(LinkItem_t *item)
+{
+	if (item == LinkHead)
+	{
+		return;
+	}
+
+	// Unlink it
+	item->prev->next = item->next;
+	if (item->next != NULL)
+	{
+		item->next->prev = item->prev;
+	}
+	else
+	{
+		lastheardTail = item->prev;
+	}
+
+	// And put it in front of the current head
+	item->prev = NULL;
+	item->next = LinkHead;
+	LinkHead->prev = item;
+	LinkHead = item;
+}
+
 void lastheardInitList(void)
 {
 	LinkHead = callsList;
+	lastheardTail = &callsList[NUM_LASTHEARD_STORED - 1];
+	memset(lastheardHashBuckets, 0, sizeof(lastheardHashBuckets));
 
 	for(int i = 0; i < NUM_LASTHEARD_STORED; i++)
 	{
@@ -236,6 +353,8 @@ void lastheardInitList(void)
 		callsList[i].talkerAlias[0] = 0;
 		callsList[i].locator[0] = 0;
 		callsList[i].time = 0;
+		callsList[i].callCount = 0;
+		callsList[i].airtime = 0;
 
 		if (i == 0)
 		{
@@ -259,82 +378,63 @@ void lastheardInitList(void)
 
 LinkItem_t *lastheardFindInList(uint32_t id)
 {
-    LinkItem_t *item = LinkHead;
+	uint8_t link = lastheardHashBuckets[lastheardHashBucket(id)];
 
-    while (item->next != NULL)
-    {
-        if (item->id == id)
-        {
-            // found it
-            return item;
-        }
-        item = item->next;
-    }
-    return NULL;
+	while (link != 0)
+	{
+		if (callsList[link - 1].id == id)
+		{
+			// found it
+			return &callsList[link - 1];
+		}
+		link = lastheardHashNext[link - 1];
+	}
+	return NULL;
 }
 
-static uint8_t *coordsToMaidenhead(double longitude, double latitude)
+// The coordinates are in 2^-22 degree units, offset to be positive: longitude + 180, latitude + 90
+static uint8_t *coordsToMaidenhead(uint32_t longitude, uint32_t latitude)
 {
 	static uint8_t maidenhead[15];
-	double l, l2;
-	uint8_t c;
-
-	l = longitude;
+	uint32_t subsquares;
 
 	for (uint8_t i = 0; i < 2; i++)
 	{
-		l = l / ((i == 0) ? 20.0 : 10.0) + 9.0;
-		c = (uint8_t) l;
-		maidenhead[0 + i] = c + 'A';
-		l2 = c;
-		l -= l2;
-		l *= 10.0;
-		c = (uint8_t) l;
-		maidenhead[2 + i] = c + '0';
-		l2 = c;
-		l -= l2;
-		l *= 24.0;
-		c = (uint8_t) l;
-		maidenhead[4 + i] = c + 'A';
-
-#if 0
-		if (extended)
-		{
-			l2 = c;
-			l -= l2;
-			l *= 10.0;
-			c = (uint8_t) l;
-			maidenhead[6 + i] = c + '0';
-			l2 = c;
-			l -= l2;
-			l *= 24.0;
-			c = (uint8_t) l;
-			maidenhead[8 + i] = c + (extended ? 'A' : 'a');
-			l2 = c;
-			l -= l2;
-			l *= 10.0;
-			c = (uint8_t) l;
-			maidenhead[10 + i] = c + '0';
-			l2 = c;
-			l -= l2;
-			l *= 24.0;
-			c = (uint8_t) l;
-			maidenhead[12 + i] = c + (extended ? 'A' : 'a');
-		}
-#endif
+		// Subsquares are 5' of longitude or 2.5' of latitude
+		subsquares = (uint32_t)((((uint64_t)((i == 0) ? longitude : latitude)) * 24) >> ((i == 0) ? 23 : 22));
 
-		l = latitude;
+		maidenhead[0 + i] = (subsquares / 240) + 'A';
+		maidenhead[2 + i] = ((subsquares / 24) % 10) + '0';
+		maidenhead[4 + i] = (subsquares % 24) + 'A';
 	}
 
-#if 0
-	maidenhead[extended ? 14 : 6] = '\0';
-#else
 	maidenhead[6] = '\0';
-#endif
 
 	return &maidenhead[0];
 }
 
+// Round to 24 significant bits, as the coordinates were rounded when they were decoded to floats, so the locators don't change
+static int32_t gpsRoundToFloatPrecision(int32_t value)
+{
+	uint32_t magnitude = (value < 0) ? -value : value;
+
+	if (magnitude >= (1U << 24))
+	{
+		int shift = 8 - __builtin_clz(magnitude);
+		uint32_t half = 1U << (shift - 1);
+		uint32_t remainder = magnitude & ((1U << shift) - 1);
+
+		magnitude >>= shift;
+		if ((remainder > half) || ((remainder == half) && (magnitude & 0x01)))// round half to even
+		{
+			magnitude++;
+		}
+		magnitude <<= shift;
+	}
+
+	return ((value < 0) ? -(int32_t)magnitude : (int32_t)magnitude);
+}
+
 static uint8_t *decodeGPSPosition(uint8_t *data)
 {
 #if 0
@@ -374,11 +474,9 @@ static uint8_t *decodeGPSPosition(uint8_t *data)
 	int32_t latitudeI = (data[6U] << 24) | (data[7U] << 16) | (data[8U] << 8);
 	latitudeI >>= 8;
 
-	float longitude = 360.0F / 33554432.0F;	// 360/2^25 steps
-	float latitude  = 180.0F / 16777216.0F;	// 180/2^24 steps
-
-	longitude *= (float)longitudeI;
-	latitude  *= (float)latitudeI;
+	// 360/2^25 and 180/2^24 degree steps, which are both 45 * 2^-22 degrees
+	uint32_t longitude = gpsRoundToFloatPrecision(longitudeI * 45) + (180 << 22);
+	uint32_t latitude = gpsRoundToFloatPrecision(latitudeI * 45) + (90 << 22);
 
 	return (coordsToMaidenhead(longitude, latitude));
 }
@@ -453,123 +551,240 @@ void lastHeardClearLastID(void)
 	lastID = 0;
 }
 
-static void updateLHItem(LinkItem_t *item)
+static const char *displayNameCacheFind(int kind, uint32_t id)
+{
+	uint32_t key = (kind << 24) | (id & 0x00FFFFFF);
+
+	for (int i = 0; i < DISPLAY_NAME_CACHE_SIZE; i++)
+	{
+		if ((displayNameCache[i].key == key) && (displayNameCache[i].contactDisplayPriority == nonVolatileSettings.contactDisplayPriority))
+		{
+			displayNameCache[i].lastUsed = ++displayNameCacheUseCounter;
+			return displayNameCache[i].text;
+		}
+	}
+
+	return NULL;
+}
+
+static void displayNameCacheAdd(int kind, uint32_t id, const char *text)
+{
+	displayNameCacheEntry_t *entry = &displayNameCache[0];
+
+	// Use a free entry, or the least recently used one
+	for (int i = 0; i < DISPLAY_NAME_CACHE_SIZE; i++)
+	{
+		if (displayNameCache[i].key == 0)
+		{
+			entry = &displayNameCache[i];
+			break;
+		}
+
+		if ((int32_t)(displayNameCache[i].lastUsed - entry->lastUsed) < 0)
+		{
+			entry = &displayNameCache[i];
+		}
+	}
+
+	entry->key = (kind << 24) | (id & 0x00FFFFFF);
+	entry->lastUsed = ++displayNameCacheUseCounter;
+	entry->contactDisplayPriority = nonVolatileSettings.contactDisplayPriority;
+	snprintf(entry->text, sizeof(entry->text), "%s", text);
+}
+
+// Must be called when the contacts, the DMR ID database or the language change
+void displayNameCacheInvalidate(void)
+{
+	memset(displayNameCache, 0, sizeof(displayNameCache));
+}
+
+static void displayNameBuild(int kind, uint32_t id, char *text, int textLen)
 {
 	static const int bufferLen = 33; // displayChannelNameOrRxFrequency() use 6x8 font
 	char buffer[bufferLen];// buffer passed to the DMR ID lookup function, needs to be large enough to hold worst case text length that is returned. Currently 16+1
 	dmrIdDataStruct_t currentRec;
 
-	if ((item->talkGroupOrPcId >> 24) == PC_CALL_FLAG)
+	switch (kind)
 	{
-		// Its a Private call
-		switch (nonVolatileSettings.contactDisplayPriority)
-		{
-			case CONTACT_DISPLAY_PRIO_CC_DB_TA:
-			case CONTACT_DISPLAY_PRIO_TA_CC_DB:
-				if (contactIDLookup(item->id, CONTACT_CALLTYPE_PC, buffer) == true)
-				{
-					snprintf(item->contact, 16, "%s", buffer);
-					item->contact[16] = 0;
-				}
-				else
-				{
-					dmrIDLookup(item->id, &currentRec);
-					snprintf(item->contact, 16, "%s", currentRec.text);
-					item->contact[16] = 0;
-				}
-				break;
+		case DISPLAY_NAME_CALLER:
+			switch (nonVolatileSettings.contactDisplayPriority)
+			{
+				case CONTACT_DISPLAY_PRIO_CC_DB_TA:
+				case CONTACT_DISPLAY_PRIO_TA_CC_DB:
+					if (contactIDLookup(id, CONTACT_CALLTYPE_PC, buffer) == true)
+					{
+						snprintf(text, textLen, "%s", buffer);
+					}
+					else
+					{
+						dmrIDLookup(id, &currentRec);
+						snprintf(text, textLen, "%s", currentRec.text);
+					}
+					break;
 
-			case CONTACT_DISPLAY_PRIO_DB_CC_TA:
-			case CONTACT_DISPLAY_PRIO_TA_DB_CC:
-				if (dmrIDLookup(item->id, &currentRec) == true)
-				{
-					snprintf(item->contact, 16, "%s", currentRec.text);
-					item->contact[16] = 0;
-				}
-				else
-				{
-					if (contactIDLookup(item->id, CONTACT_CALLTYPE_PC, buffer) == true)
+				case CONTACT_DISPLAY_PRIO_DB_CC_TA:
+				case CONTACT_DISPLAY_PRIO_TA_DB_CC:
+					if (dmrIDLookup(id, &currentRec) == true)
 					{
-						snprintf(item->contact, 16, "%s", buffer);
-						item->contact[16] = 0;
+						snprintf(text, textLen, "%s", currentRec.text);
 					}
 					else
 					{
-						snprintf(item->contact, 16, "%s", currentRec.text);
-						item->contact[16] = 0;
+						if (contactIDLookup(id, CONTACT_CALLTYPE_PC, buffer) == true)
+						{
+							snprintf(text, textLen, "%s", buffer);
+						}
+						else
+						{
+							snprintf(text, textLen, "%s", currentRec.text);
+						}
 					}
-				}
-				break;
-		}
+					break;
+			}
+			break;
 
-		if (item->talkGroupOrPcId != (trxDMRID | (PC_CALL_FLAG << 24)))
-		{
-			if (contactIDLookup(item->talkGroupOrPcId & 0x00FFFFFF, CONTACT_CALLTYPE_PC, buffer) == true)
+		case DISPLAY_NAME_PC_DESTINATION:
+			if (contactIDLookup(id, CONTACT_CALLTYPE_PC, buffer) == true)
 			{
-				snprintf(item->talkgroup, 16, "%s", buffer);
-				item->talkgroup[16] = 0;
+				snprintf(text, textLen, "%s", buffer);
 			}
 			else
 			{
-				dmrIDLookup(item->talkGroupOrPcId & 0x00FFFFFF, &currentRec);
-				snprintf(item->talkgroup, 16, "%s", currentRec.text);
-				item->talkgroup[16] = 0;
+				dmrIDLookup(id, &currentRec);
+				snprintf(text, textLen, "%s", currentRec.text);
 			}
+			break;
+
+		case DISPLAY_NAME_TALKGROUP:
+			if (contactIDLookup(id, CONTACT_CALLTYPE_TG, buffer) == true)
+			{
+				snprintf(text, textLen, "%s", buffer);
+			}
+			else
+			{
+				snprintf(text, textLen, "%s %d", currentLanguage->tg, id);
+			}
+			break;
+	}
+}
+
+// Copies the cached text for this TG or PC number, building it on a cache miss
+static void displayNameGet(int kind, uint32_t id, char *text, int textLen)
+{
+	const char *cachedText = displayNameCacheFind(kind, id);
+
+	if (cachedText == NULL)
+	{
+		char buffer[sizeof(displayNameCache[0].text)];
+
+		displayNameBuild(kind, id, buffer, sizeof(buffer));
+		displayNameCacheAdd(kind, id, buffer);
+		cachedText = displayNameCacheFind(kind, id);
+	}
+
+	snprintf(text, textLen, "%s", cachedText);
+}
+
+static void updateLHItem(LinkItem_t *item)
+{
+	if ((item->talkGroupOrPcId >> 24) == PC_CALL_FLAG)
+	{
+		// Its a Private call
+		displayNameGet(DISPLAY_NAME_CALLER, (item->id & 0x00FFFFFF), item->contact, 16);
+
+		if (item->talkGroupOrPcId != (trxDMRID | (PC_CALL_FLAG << 24)))
+		{
+			displayNameGet(DISPLAY_NAME_PC_DESTINATION, (item->talkGroupOrPcId & 0x00FFFFFF), item->talkgroup, 16);
 		}
 	}
 	else
 	{
 		// TalkGroup
-		if (contactIDLookup(item->talkGroupOrPcId, CONTACT_CALLTYPE_TG, buffer) == true)
+		displayNameGet(DISPLAY_NAME_TALKGROUP, (item->talkGroupOrPcId & 0x00FFFFFF), item->talkgroup, 16);
+		displayNameGet(DISPLAY_NAME_CALLER, (item->id & 0x00FFFFFF), item->contact, 20);
+	}
+}
+
+// Reuse the oldest item in the list, as the new item at the top of the list
+static LinkItem_t *lastheardNewItem(uint32_t id)
+{
+	LinkItem_t *item = lastheardTail;
+
+	if (numLastHeard < NUM_LASTHEARD_STORED)
+	{
+		numLastHeard++;
+	}
+	else
+	{
+		lastheardHashRemove(item);
+	}
+
+	lastheardMoveToFront(item);
+
+	item->id = id;
+	lastheardHashInsert(item);
+	item->callCount = 0;
+	item->airtime = 0;
+
+	memset(item->contact, 0, sizeof(item->contact)); // Clear contact's datas
+	memset(item->talkgroup, 0, sizeof(item->talkgroup));
+	memset(item->talkerAlias, 0, sizeof(item->talkerAlias));
+	memset(item->locator, 0, sizeof(item->locator));
+
+	return item;
+}
+
+// Rebuild the list, with its call counters, from the calls saved before the last power off.
+// There is no clock, so the ages of the calls only count the time the radio was switched on.
+void lastheardRestoreFromCallLog(void)
+{
+	int numRecords = callLogGetNumRecords();
+	callLogRecord_t record;
+	LinkItem_t *item;
+	uint32_t now = fw_millis();
+	int32_t age;
+
+	for (int i = 0; i < numRecords; i++)
+	{
+		if (callLogReadRecord(i, &record) == false)
+		{
+			continue;
+		}
+
+		item = lastheardFindInList(record.id);
+		if (item == NULL)
 		{
-			snprintf(item->talkgroup, 16, "%s", buffer);
-			item->talkgroup[16] = 0;
+			item = lastheardNewItem(record.id);
 		}
 		else
 		{
-			snprintf(item->talkgroup, 16, "%s %d", currentLanguage->tg, (item->talkGroupOrPcId & 0x00FFFFFF));
-			item->talkgroup[16] = 0;
+			lastheardMoveToFront(item);
 		}
 
-		switch (nonVolatileSettings.contactDisplayPriority)
-		{
-			case CONTACT_DISPLAY_PRIO_CC_DB_TA:
-			case CONTACT_DISPLAY_PRIO_TA_CC_DB:
-				if (contactIDLookup(item->id, CONTACT_CALLTYPE_PC, buffer) == true)
-				{
-					snprintf(item->contact, 20, "%s", buffer);
-					item->contact[20] = 0;
-				}
-				else
-				{
-					dmrIDLookup((item->id & 0x00FFFFFF), &currentRec);
-					snprintf(item->contact, 20, "%s", currentRec.text);
-					item->contact[20] = 0;
-				}
-				break;
+		item->talkGroupOrPcId = record.talkGroupOrPcId;
+		memcpy(item->locator, record.locator, sizeof(item->locator));
+		item->locator[sizeof(item->locator) - 1] = 0;
+		item->callCount++;
+		item->airtime += record.duration;
 
-			case CONTACT_DISPLAY_PRIO_DB_CC_TA:
-			case CONTACT_DISPLAY_PRIO_TA_DB_CC:
-				if (dmrIDLookup((item->id & 0x00FFFFFF), &currentRec) == true)
-				{
-					snprintf(item->contact, 20, "%s", currentRec.text);
-					item->contact[20] = 0;
-				}
-				else
-				{
-					if (contactIDLookup(item->id, CONTACT_CALLTYPE_PC, buffer) == true)
-					{
-						snprintf(item->contact, 20, "%s", buffer);
-						item->contact[20] = 0;
-					}
-					else
-					{
-						snprintf(item->contact, 20, "%s", currentRec.text);
-						item->contact[20] = 0;
-					}
-				}
-				break;
+		age = (int32_t)(fw_operatingSeconds() - record.operatingTime);
+		if (age < 0)
+		{
+			age = 0;// operating time not saved at the last power off
+		}
+		else if (age > (9999 * 60))
+		{
+			age = 9999 * 60;// the most the last heard screen can show, in minutes
 		}
+		item->time = now - ((uint32_t)age * 1000U);
+	}
+
+	// Only look up the names of the stations which ended up in the list
+	item = LinkHead;
+	for (int i = 0; i < numLastHeard; i++)
+	{
+		updateLHItem(item);
+		item = item->next;
 	}
 }
 
@@ -587,6 +802,8 @@ bool lastHeardListUpdate(uint8_t *dmrDataBuffer, bool forceOnHotspot)
 		{
 			uint32_t id = (dmrDataBuffer[6] << 16) + (dmrDataBuffer[7] << 8) + (dmrDataBuffer[8] << 0);
 
+			callLogCallHeard(id, talkGroupOrPcId);
+
 			if (id != lastID)
 			{
 				memset(bufferTA, 0, 32);// Clear any TA data in TA buffer (used for decode)
@@ -618,25 +835,7 @@ bool lastHeardListUpdate(uint8_t *dmrDataBuffer, bool forceOnHotspot)
 					else
 					{
 						// not at top of the list
-						// Move this item to the top of the list
-						LinkItem_t *next = item->next;
-						LinkItem_t *prev = item->prev;
-
-						// set the previous item to skip this item and link to 'items' next item.
-						prev->next = next;
-
-						if (item->next != NULL)
-						{
-							// not the last in the list
-							next->prev = prev;// backwards link the next item to the item before us in the list.
-						}
-
-						item->next = LinkHead;// link our next item to the item at the head of the list
-
-						LinkHead->prev = item;// backwards link the hold head item to the item moving to the top of the list.
-
-						item->prev = NULL;// change the items prev to NULL now we are at teh top of the list
-						LinkHead = item;// Change the global for the head of the link to the item that is to be at the top of the list.
+						lastheardMoveToFront(item);
 						if (item->talkGroupOrPcId != 0)
 						{
 							menuDisplayQSODataState = QSO_DISPLAY_CALLER_DATA;// flag that the display needs to update
@@ -646,37 +845,11 @@ bool lastHeardListUpdate(uint8_t *dmrDataBuffer, bool forceOnHotspot)
 				else
 				{
 					// Not in the list
-					item = LinkHead;// setup to traverse the list from the top.
-
-					if (numLastHeard < NUM_LASTHEARD_STORED)
-					{
-						numLastHeard++;
-					}
-
-					// need to use the last item in the list as the new item at the top of the list.
-					// find last item in the list
-					while(item->next != NULL)
-					{
-						item = item->next;
-					}
-					//item is now the last
-
-					(item->prev)->next = NULL;// make the previous item the last
-
-					LinkHead->prev = item;// set the current head item to back reference this item.
-					item->next = LinkHead;// set this items next to the current head
-					LinkHead = item;// Make this item the new head
-
-					item->id = id;
+					item = lastheardNewItem(id);
 					item->talkGroupOrPcId = talkGroupOrPcId;
 					item->time = fw_millis();
 					lastTG = talkGroupOrPcId;
 
-					memset(item->contact, 0, sizeof(item->contact)); // Clear contact's datas
-					memset(item->talkgroup, 0, sizeof(item->talkgroup));
-					memset(item->talkerAlias, 0, sizeof(item->talkerAlias));
-					memset(item->locator, 0, sizeof(item->locator));
-
 					updateLHItem(item);
 
 					if (item->talkGroupOrPcId != 0)
@@ -801,21 +974,162 @@ bool lastHeardListUpdate(uint8_t *dmrDataBuffer, bool forceOnHotspot)
 }
 
 
+// Reading the ID then the text of a record is done as one continuous stream, rather than two separate Flash read commands
 static void dmrIDReadContactInFlash(uint32_t contactOffset, uint8_t *data, uint32_t len)
 {
-	SPI_Flash_read((DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH) + contactOffset, data, len);
+	SPI_Flash_streamSeek(&dmrIDStream, (DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH) + contactOffset);
+	SPI_Flash_streamRead(&dmrIDStream, data, len);
 }
 
 
+static inline uint32_t dmrIDIndexGet(uint32_t indexPos)
+{
+	uint8_t *p = &dmrIDsCache.index[indexPos * 3];
+
+	return (p[0] | (p[1] << 8) | (p[2] << 16));
+}
+
+static inline void dmrIDIndexSet(uint32_t indexPos, uint32_t id)
+{
+	uint8_t *p = &dmrIDsCache.index[indexPos * 3];
+
+	p[0] = id & 0xFF;
+	p[1] = (id >> 8) & 0xFF;
+	p[2] = (id >> 16) & 0xFF;
+}
+
+/*
+ * Compressed format, "IDZ" followed by the format version:
+ * Header:    [3] version, [4..5] number of blocks, [6] log2 of the block size, [7] flags, [8..11] number of IDs
+ * Directory: the first ID of each block, then the last ID of the database, all 24 bit little endian.
+ *            This is read straight into the RAM index.
+ * Blocks:    a record count, then for each record the ID as a LEB128 delta from the previous ID,
+ *            the text length and the text packed as 6 bit DMRID_COMPRESSED_CHARSET codes, least significant bits first.
+ * Callsign index (optional, after the last block): the number of entries (32 bit), then the entries sorted by callsign.
+ *            Each entry is the callsign packed as 8 6 bit codes (space padded), and its 24 bit ID.
+ * Bloom filter (optional, after the callsign index): log2 of the number of bits, the number of hashes, 2 unused bytes, then the bits.
+ *            It is loaded into RAM, so most IDs which aren't in the database are rejected without reading the Flash.
+ *            The RAM is SPI_Flash_sectorbuffer, which is only used while the CPS writes to the Flash, see dmrIDBloomFilterRelease().
+ */
+static void dmrIDCompressedCacheInit(uint8_t *headerBuf)
+{
+	uint32_t numBlocks = headerBuf[4] | (headerBuf[5] << 8);
+	uint8_t lastIdBuf[3];
+	uint32_t sectionAddress;
+
+	if ((headerBuf[3] != DMRID_COMPRESSED_VERSION) || (numBlocks == 0) || (numBlocks > DMRID_INDEX_MAX_ENTRIES) || (headerBuf[6] > 16))
+	{
+		return;
+	}
+
+	// Anything past the end of the area would be read from the codeplug
+	sectionAddress = DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH + ((numBlocks + 1) * 3) + (numBlocks << headerBuf[6]);
+	if (sectionAddress > DMRID_MEMORY_STORAGE_END)
+	{
+		return;
+	}
+
+	SPI_Flash_read(DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH, dmrIDsCache.index, numBlocks * 3);
+	SPI_Flash_read(DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH + (numBlocks * 3), lastIdBuf, 3);
+
+	dmrIDsCache.format = DMRID_FORMAT_COMPRESSED;
+	dmrIDsCache.indexEntries = numBlocks;
+	dmrIDsCache.blockSize = 1 << headerBuf[6];
+	dmrIDsCache.dataStart = DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH + ((numBlocks + 1) * 3);
+	dmrIDsCache.lastId = lastIdBuf[0] | (lastIdBuf[1] << 8) | (lastIdBuf[2] << 16);
+	dmrIDsCache.entries = ((uint32_t)headerBuf[8] | (uint32_t)headerBuf[9] << 8 | (uint32_t)headerBuf[10] << 16 | (uint32_t)headerBuf[11] << 24);
+
+	if (headerBuf[7] & DMRID_COMPRESSED_FLAG_CALLSIGN_INDEX)
+	{
+		uint32_t callsignIndexEntries;
+
+		SPI_Flash_read(sectionAddress, (uint8_t *)&callsignIndexEntries, 4);
+		dmrIDsCache.callsignIndexStart = sectionAddress + 4;
+
+		if ((callsignIndexEntries > dmrIDsCache.entries) ||
+				((dmrIDsCache.callsignIndexStart + (callsignIndexEntries * DMRID_CALLSIGN_INDEX_ENTRY_SIZE)) > DMRID_MEMORY_STORAGE_END))
+		{
+			return;// erased or corrupt, and anything after it can't be found either
+		}
+		dmrIDsCache.callsignIndexEntries = callsignIndexEntries;
+		sectionAddress = dmrIDsCache.callsignIndexStart + (callsignIndexEntries * DMRID_CALLSIGN_INDEX_ENTRY_SIZE);
+	}
+
+	if (headerBuf[7] & DMRID_COMPRESSED_FLAG_BLOOM_FILTER)
+	{
+		uint8_t bloomHeader[4];
+
+		SPI_Flash_read(sectionAddress, bloomHeader, 4);
+
+		// The filter is only used if it fits in the buffer it borrows
+		if ((bloomHeader[0] >= 3) && ((1U << (bloomHeader[0] - 3)) <= DMRID_BLOOM_FILTER_MAX_SIZE) && (bloomHeader[1] > 0) && (bloomHeader[1] <= 16) &&
+				((sectionAddress + 4 + (1U << (bloomHeader[0] - 3))) <= DMRID_MEMORY_STORAGE_END))
+		{
+			dmrIDsCache.bloomFilter = SPI_Flash_sectorbuffer;
+			SPI_Flash_read(sectionAddress + 4, dmrIDsCache.bloomFilter, 1U << (bloomHeader[0] - 3));
+			dmrIDsCache.bloomFilterBitsMask = (1U << bloomHeader[0]) - 1;
+			dmrIDsCache.bloomFilterNumHashes = bloomHeader[1];
+		}
+	}
+}
+
+static inline uint32_t dmrIDBloomHash(uint32_t h)
+{
+	// MurmurHash3 finaliser
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35;
+	h ^= h >> 16;
+
+	return h;
+}
+
+// False if the ID is definitely not in the database, true if it may be, or if there is no Bloom filter
+static bool dmrIDBloomFilterMayContain(uint32_t id)
+{
+	uint32_t h1;
+	uint32_t h2;
+
+	if (dmrIDsCache.bloomFilterNumHashes == 0)
+	{
+		return true;
+	}
+
+	// Double hashing, bit i is h1 + i * h2
+	h1 = dmrIDBloomHash(id);
+	h2 = dmrIDBloomHash(id ^ 0x9E3779B9) | 1;
+
+	for (int i = 0; i < dmrIDsCache.bloomFilterNumHashes; i++)
+	{
+		uint32_t bit = (h1 + (i * h2)) & dmrIDsCache.bloomFilterBitsMask;
+
+		if ((dmrIDsCache.bloomFilter[bit >> 3] & (1 << (bit & 7))) == 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void dmrIDCacheInit(void)
 {
 	uint8_t headerBuf[32];
 
 	memset(&dmrIDsCache, 0, sizeof(dmrIDsCache_t));
 	memset(&headerBuf, 0, sizeof(headerBuf));
+	dmrIDLookupCacheInvalidate();
+	SPI_Flash_streamOpen(&dmrIDStream, DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH, false);
 
 	SPI_Flash_read(DMRID_MEMORY_STORAGE_START, headerBuf, DMRID_HEADER_LENGTH);
 
+	if ((headerBuf[0] == 'I') && (headerBuf[1] == 'D') && (headerBuf[2] == 'Z'))
+	{
+		dmrIDCompressedCacheInit(headerBuf);
+		return;
+	}
+
 	if ((headerBuf[0] != 'I') || (headerBuf[1] != 'D') || (headerBuf[2] != '-'))
 	{
 		return;
@@ -824,101 +1138,207 @@ void dmrIDCacheInit(void)
 	dmrIDsCache.entries = ((uint32_t)headerBuf[8] | (uint32_t)headerBuf[9] << 8 | (uint32_t)headerBuf[10] << 16 | (uint32_t)headerBuf[11] << 24);
 	dmrIDsCache.contactLength = (uint8_t)headerBuf[3] - 0x4a;
 
+	if ((dmrIDsCache.entries > ((DMRID_MEMORY_STORAGE_END - (DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH)) / 4)) ||
+			((DMRID_MEMORY_STORAGE_START + DMRID_HEADER_LENGTH + (dmrIDsCache.entries * dmrIDsCache.contactLength)) > DMRID_MEMORY_STORAGE_END))
+	{
+		dmrIDsCache.entries = 0;// would run into the codeplug
+	}
+
 	if (dmrIDsCache.entries > 0)
 	{
-		dmrIdDataStruct_t dmrIDContact;
+		uint32_t id;
+#if defined(USE_SEGGER_RTT)
+		uint32_t startTime = fw_millis();
+#endif
+
+		dmrIDsCache.indexStride = (dmrIDsCache.entries + (DMRID_INDEX_MAX_ENTRIES - 1)) / DMRID_INDEX_MAX_ENTRIES;
+		dmrIDsCache.indexEntries = (dmrIDsCache.entries + (dmrIDsCache.indexStride - 1)) / dmrIDsCache.indexStride;
 
-		// Set Min and Max IDs boundaries
-		// First available ID
-		dmrIDReadContactInFlash(0, (uint8_t *)&dmrIDContact, 4U);
-		dmrIDsCache.slices[0] = dmrIDContact.id;
+		// The IDs are stored as BCD, but the index holds them as binary, so they fit in 24 bits
+		for (uint32_t i = 0; i < dmrIDsCache.indexEntries; i++)
+		{
+			dmrIDReadContactInFlash((dmrIDsCache.contactLength * (i * dmrIDsCache.indexStride)), (uint8_t *)&id, 4U);
+			dmrIDIndexSet(i, bcd2int(id));
+		}
 
 		// Last available ID
-		dmrIDReadContactInFlash((dmrIDsCache.contactLength * (dmrIDsCache.entries - 1)), (uint8_t *)&dmrIDContact, 4U);
-		dmrIDsCache.slices[ID_SLICES - 1] = dmrIDContact.id;
+		dmrIDReadContactInFlash((dmrIDsCache.contactLength * (dmrIDsCache.entries - 1)), (uint8_t *)&id, 4U);
+		dmrIDsCache.lastId = bcd2int(id);
+
+		SPI_Flash_streamClose(&dmrIDStream);
+
+#if defined(USE_SEGGER_RTT)
+		SEGGER_RTT_printf(0, "DMR ID index: %u IDs, stride %u, %u bytes of RAM, built in %u mS\n",
+				dmrIDsCache.entries, dmrIDsCache.indexStride, dmrIDsCache.indexEntries * 3, fw_millis() - startTime);
+#endif
+	}
+}
 
-		if (dmrIDsCache.entries > MIN_ENTRIES_BEFORE_USING_SLICES)
+static uint32_t dmrIDReadVarint(void)
+{
+	uint32_t value = 0;
+	uint8_t b;
+	int shift = 0;
+
+	do
+	{
+		SPI_Flash_streamRead(&dmrIDStream, &b, 1);
+		value |= (b & 0x7F) << shift;
+		shift += 7;
+	} while ((b & 0x80) && (shift < 28));
+
+	return value;
+}
+
+// Decode the block sequentially until the ID is found, or an ID above it is reached. The block is read as a single stream.
+static bool dmrIDLookupInCompressedBlock(uint32_t targetId, uint32_t block, dmrIdDataStruct_t *foundRecord)
+{
+	uint8_t packedText[((DMRID_COMPRESSED_MAX_TEXT_LENGTH * 6) + 7) / 8 + 1];
+	uint32_t id = dmrIDIndexGet(block);
+	uint8_t numRecords;
+	uint8_t textLength;
+
+	SPI_Flash_streamSeek(&dmrIDStream, dmrIDsCache.dataStart + (block * dmrIDsCache.blockSize));
+	SPI_Flash_streamRead(&dmrIDStream, &numRecords, 1);
+
+	for (int i = 0; i < numRecords; i++)
+	{
+		id += dmrIDReadVarint();// The first record of a block has a delta of 0 from the ID in the index
+		SPI_Flash_streamRead(&dmrIDStream, &textLength, 1);
+
+		if ((id > targetId) || (textLength > DMRID_COMPRESSED_MAX_TEXT_LENGTH))
 		{
-			dmrIDsCache.IDsPerSlice = dmrIDsCache.entries / (ID_SLICES - 1);
+			return false;
+		}
 
-			for (uint8_t i = 0; i < (ID_SLICES - 2); i++)
+		// Reading the text of the records which are skipped is quicker than starting a new Flash read for each record
+		memset(packedText, 0, sizeof(packedText));
+		SPI_Flash_streamRead(&dmrIDStream, packedText, ((textLength * 6) + 7) / 8);
+
+		if (id == targetId)
+		{
+			for (int c = 0; c < textLength; c++)
 			{
-				dmrIDReadContactInFlash((dmrIDsCache.contactLength * ((dmrIDsCache.IDsPerSlice * i) + dmrIDsCache.IDsPerSlice)), (uint8_t *)&dmrIDContact, 4U);
-				dmrIDsCache.slices[i + 1] = dmrIDContact.id;
+				int bitPos = c * 6;
+
+				foundRecord->text[c] = DMRID_COMPRESSED_CHARSET[((packedText[bitPos >> 3] | (packedText[(bitPos >> 3) + 1] << 8)) >> (bitPos & 7)) & 0x3F];
 			}
+			foundRecord->text[textLength] = 0;
+			foundRecord->id = int2bcd(targetId);
+
+			return true;
 		}
 	}
+
+	return false;
 }
 
-bool dmrIDLookup(int targetId, dmrIdDataStruct_t *foundRecord)
+static bool dmrIDLookupInFlash(int targetId, dmrIdDataStruct_t *foundRecord)
 {
 	int targetIdBCD = int2bcd(targetId);
 
-	if ((dmrIDsCache.entries > 0) && (targetIdBCD >= dmrIDsCache.slices[0]) && (targetIdBCD <= dmrIDsCache.slices[ID_SLICES - 1]))
+	if ((dmrIDsCache.entries > 0) && ((uint32_t)targetId >= dmrIDIndexGet(0)) && ((uint32_t)targetId <= dmrIDsCache.lastId) &&
+			dmrIDBloomFilterMayContain((uint32_t)targetId))
 	{
-		uint32_t startPos = 0;
-		uint32_t endPos = dmrIDsCache.entries - 1;
+		uint32_t indexLow = 0;
+		uint32_t indexHigh = dmrIDsCache.indexEntries - 1;
+		uint32_t startPos;
+		uint32_t endPos;
 		uint32_t curPos;
+		uint32_t lowId;
+		uint32_t highId;
+		int probes = 0;
 
-		if (dmrIDsCache.entries > MIN_ENTRIES_BEFORE_USING_SLICES) // Use slices
+		// Find the last index entry which is not above the target ID, this is all done in RAM
+		while (indexLow < indexHigh)
 		{
-			for (uint8_t i = 0; i < ID_SLICES - 1; i++)
-			{
-				// Check if ID is in slices boundaries, with a special case for the last slice as [ID_SLICES - 1] is the last ID
-				if ((targetIdBCD >= dmrIDsCache.slices[i]) &&
-						((i == ID_SLICES - 2) ? (targetIdBCD <= dmrIDsCache.slices[i + 1]) : (targetIdBCD < dmrIDsCache.slices[i + 1])))
-				{
-					// targetID is the min slice limit, don't go further
-					if (targetIdBCD == dmrIDsCache.slices[i])
-					{
-						foundRecord->id = dmrIDsCache.slices[i];
-						dmrIDReadContactInFlash((dmrIDsCache.contactLength * (dmrIDsCache.IDsPerSlice * i)) + 4U, (uint8_t *)foundRecord + 4U, (dmrIDsCache.contactLength - 4U));
+			uint32_t indexMid = (indexLow + indexHigh + 1) >> 1;
 
-						return true;
-					}
-
-					startPos = dmrIDsCache.IDsPerSlice * i;
-					endPos = (i == ID_SLICES - 2) ? (dmrIDsCache.entries - 1) : dmrIDsCache.IDsPerSlice * (i + 1);
-
-					break;
-				}
+			if (dmrIDIndexGet(indexMid) <= (uint32_t)targetId)
+			{
+				indexLow = indexMid;
+			}
+			else
+			{
+				indexHigh = indexMid - 1;
 			}
 		}
-		else // Not enough contact to use slices
-		{
-			bool isMin;
 
-			// Check if targetID is equal to the first or the last in the IDs list
-			if ((isMin = (targetIdBCD == dmrIDsCache.slices[0])) || (targetIdBCD == dmrIDsCache.slices[ID_SLICES - 1]))
+		if (dmrIDsCache.format == DMRID_FORMAT_COMPRESSED)
+		{
+			if (dmrIDLookupInCompressedBlock((uint32_t)targetId, indexLow, foundRecord))
 			{
-				foundRecord->id = dmrIDsCache.slices[(isMin ? 0 : (ID_SLICES - 1))];
-				dmrIDReadContactInFlash((dmrIDsCache.contactLength * (dmrIDsCache.IDsPerSlice * (isMin ? 0 : (ID_SLICES - 1)))) + 4U, (uint8_t *)foundRecord + 4U, (dmrIDsCache.contactLength - 4U));
-
 				return true;
 			}
 		}
-
-		// Look for the ID now
-		while (startPos <= endPos)
+		else
 		{
-			curPos = (startPos + endPos) >> 1;
+			startPos = indexLow * dmrIDsCache.indexStride;
 
-			dmrIDReadContactInFlash((dmrIDsCache.contactLength * curPos), (uint8_t *)foundRecord, 4U);
+			// targetID is in the index, only its text needs to be read
+			if (dmrIDIndexGet(indexLow) == (uint32_t)targetId)
+			{
+				foundRecord->id = targetIdBCD;
+				dmrIDReadContactInFlash((dmrIDsCache.contactLength * startPos) + 4U, (uint8_t *)foundRecord + 4U, (dmrIDsCache.contactLength - 4U));
+
+				return true;
+			}
 
-			if (foundRecord->id < targetIdBCD)
+			// Otherwise it can only be between this index entry and the next one
+			endPos = startPos + dmrIDsCache.indexStride - 1;
+			if (endPos > (dmrIDsCache.entries - 1))
 			{
-				startPos = curPos + 1;
+				endPos = dmrIDsCache.entries - 1;
 			}
-			else
+			startPos++;
+
+			// IDs just outside the search range, used to guess the position of the target ID
+			lowId = dmrIDIndexGet(indexLow);
+			highId = ((indexLow + 1) < dmrIDsCache.indexEntries) ? dmrIDIndexGet(indexLow + 1) : (dmrIDsCache.lastId + 1);
+
+			// Look for the ID now
+			while (startPos <= endPos)
 			{
-				if (foundRecord->id > targetIdBCD)
+				if ((probes < DMRID_INTERPOLATION_PROBES) && (highId > lowId))
 				{
-					endPos = curPos - 1;
+					// IDs are fairly evenly spread, so interpolate between the IDs either side of the range.
+					// If the guesses don't find it quickly, the IDs aren't even here, so use binary search for the rest.
+					curPos = (startPos - 1) + (uint32_t)((((uint64_t)((uint32_t)targetId - lowId)) * ((endPos + 1) - (startPos - 1))) / (highId - lowId));
+
+					if (curPos < startPos)
+					{
+						curPos = startPos;
+					}
+					else if (curPos > endPos)
+					{
+						curPos = endPos;
+					}
 				}
 				else
 				{
-					dmrIDReadContactInFlash((dmrIDsCache.contactLength * curPos) + 4U, (uint8_t *)foundRecord + 4U, (dmrIDsCache.contactLength - 4U));
-					return true;
+					curPos = (startPos + endPos) >> 1;
+				}
+				probes++;
+
+				dmrIDReadContactInFlash((dmrIDsCache.contactLength * curPos), (uint8_t *)foundRecord, 4U);
+
+				if (foundRecord->id < targetIdBCD)
+				{
+					startPos = curPos + 1;
+					lowId = bcd2int(foundRecord->id);
+				}
+				else
+				{
+					if (foundRecord->id > targetIdBCD)
+					{
+						endPos = curPos - 1;
+						highId = bcd2int(foundRecord->id);
+					}
+					else
+					{
+						dmrIDReadContactInFlash((dmrIDsCache.contactLength * curPos) + 4U, (uint8_t *)foundRecord + 4U, (dmrIDsCache.contactLength - 4U));
+						return true;
+					}
 				}
 			}
 		}
@@ -928,18 +1348,235 @@ bool dmrIDLookup(int targetId, dmrIdDataStruct_t *foundRecord)
 	return false;
 }
 
+bool dmrIDCallsignIndexAvailable(void)
+{
+	return (dmrIDsCache.callsignIndexEntries > 0);
+}
+
+// Reads the callsign index entry as 6 bit codes, with the ID
+static void dmrIDCallsignReadEntry(int position, uint8_t *codes, uint32_t *id)
+{
+	uint8_t entry[DMRID_CALLSIGN_INDEX_ENTRY_SIZE];
+
+	SPI_Flash_read(dmrIDsCache.callsignIndexStart + (position * DMRID_CALLSIGN_INDEX_ENTRY_SIZE), entry, DMRID_CALLSIGN_INDEX_ENTRY_SIZE);
+
+	for (int c = 0; c < DMRID_CALLSIGN_MAX_LENGTH; c++)
+	{
+		int bitPos = c * 6;
+
+		codes[c] = ((entry[bitPos >> 3] | (entry[(bitPos >> 3) + 1] << 8)) >> (bitPos & 7)) & 0x3F;
+	}
+
+	*id = entry[6] | (entry[7] << 8) | (entry[8] << 16);
+}
+
+// Converts the prefix to 6 bit codes, callsigns are stored in upper case. Returns the number of codes,
+// or -1 if the prefix has a character which isn't in the character set, as no callsign can start with it.
+static int dmrIDCallsignPrefixToCodes(const char *prefix, uint8_t *codes)
+{
+	int len = 0;
+
+	while ((prefix[len] != 0) && (len < DMRID_CALLSIGN_MAX_LENGTH))
+	{
+		char c = prefix[len];
+		const char *p;
+
+		if ((c >= 'a') && (c <= 'z'))
+		{
+			c -= ('a' - 'A');
+		}
+		// The character set is not NUL terminated
+		p = memchr(DMRID_COMPRESSED_CHARSET, c, sizeof(DMRID_COMPRESSED_CHARSET));
+		if (p == NULL)
+		{
+			return -1;
+		}
+		codes[len++] = (p - DMRID_COMPRESSED_CHARSET);
+	}
+
+	return len;
+}
+
+// Returns the position in the callsign index of the first callsign which starts with the prefix, or -1.
+// This is a binary search, so it only reads log2(entries) index entries from the Flash.
+int dmrIDCallsignFind(const char *prefix)
+{
+	uint8_t prefixCodes[DMRID_CALLSIGN_MAX_LENGTH];
+	uint8_t codes[DMRID_CALLSIGN_MAX_LENGTH];
+	int prefixLength = dmrIDCallsignPrefixToCodes(prefix, prefixCodes);
+	int low = 0;
+	int high = dmrIDsCache.callsignIndexEntries;
+	uint32_t id;
+
+	if ((dmrIDsCache.callsignIndexEntries == 0) || (prefixLength <= 0))
+	{
+		return -1;
+	}
+
+	while (low < high)
+	{
+		int mid = (low + high) >> 1;
+
+		dmrIDCallsignReadEntry(mid, codes, &id);
+		if (memcmp(codes, prefixCodes, prefixLength) < 0)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	if (low < dmrIDsCache.callsignIndexEntries)
+	{
+		dmrIDCallsignReadEntry(low, codes, &id);
+		if (memcmp(codes, prefixCodes, prefixLength) == 0)
+		{
+			return low;
+		}
+	}
+
+	return -1;
+}
+
+// Gets the callsign and ID at this position in the callsign index. Returns false if there is no entry there, or it doesn't start with the prefix
+bool dmrIDCallsignGetEntry(int position, const char *prefix, char *callsign, uint32_t *id)
+{
+	uint8_t prefixCodes[DMRID_CALLSIGN_MAX_LENGTH];
+	uint8_t codes[DMRID_CALLSIGN_MAX_LENGTH];
+	int prefixLength = dmrIDCallsignPrefixToCodes(prefix, prefixCodes);
+	int len = 0;
+
+	if ((prefixLength < 0) || (position < 0) || (position >= dmrIDsCache.callsignIndexEntries))
+	{
+		return false;
+	}
+
+	dmrIDCallsignReadEntry(position, codes, id);
+	if (memcmp(codes, prefixCodes, prefixLength) != 0)
+	{
+		return false;
+	}
+
+	while ((len < DMRID_CALLSIGN_MAX_LENGTH) && (codes[len] != 0))
+	{
+		callsign[len] = DMRID_COMPRESSED_CHARSET[codes[len]];
+		len++;
+	}
+	callsign[len] = 0;
+
+	return true;
+}
+
+static dmrIDLookupCacheEntry_t *dmrIDLookupCacheFind(uint32_t key)
+{
+	for (int i = 0; i < DMRID_LOOKUP_CACHE_SIZE; i++)
+	{
+		if (dmrIDLookupCache[i].key == key)
+		{
+			dmrIDLookupCache[i].lastUsed = ++dmrIDLookupCacheUseCounter;
+			dmrIDLookupCacheStats.hits++;
+			return &dmrIDLookupCache[i];
+		}
+	}
+
+	dmrIDLookupCacheStats.misses++;
+	return NULL;
+}
+
+static void dmrIDLookupCacheAdd(uint32_t key, bool found, const char *text)
+{
+	dmrIDLookupCacheEntry_t *entry = &dmrIDLookupCache[0];
+
+	// Use a free entry, or the least recently used one
+	for (int i = 0; i < DMRID_LOOKUP_CACHE_SIZE; i++)
+	{
+		if (dmrIDLookupCache[i].key == 0)
+		{
+			entry = &dmrIDLookupCache[i];
+			break;
+		}
+
+		if ((int32_t)(dmrIDLookupCache[i].lastUsed - entry->lastUsed) < 0)
+		{
+			entry = &dmrIDLookupCache[i];
+		}
+	}
+
+	entry->key = key;
+	entry->lastUsed = ++dmrIDLookupCacheUseCounter;
+	entry->found = found;
+	memcpy(entry->text, text, sizeof(entry->text));
+}
+
+// Must be called when the DMR ID database or the contacts change
+void dmrIDLookupCacheInvalidate(void)
+{
+	memset(dmrIDLookupCache, 0, sizeof(dmrIDLookupCache));
+	displayNameCacheInvalidate();// The names are built from the lookups
+}
+
+// Must be called before the CPS uses SPI_Flash_sectorbuffer, which holds the Bloom filter.
+// Returns true if the filter was loaded, and dmrIDCacheInit() needs to be called to load it again.
+bool dmrIDBloomFilterRelease(void)
+{
+	bool wasLoaded = (dmrIDsCache.bloomFilterNumHashes != 0);
+
+	dmrIDsCache.bloomFilterNumHashes = 0;
+	dmrIDsCache.bloomFilter = NULL;
+
+	return wasLoaded;
+}
+
+bool dmrIDLookup(int targetId, dmrIdDataStruct_t *foundRecord)
+{
+	uint32_t key = (DMRID_LOOKUP_SOURCE_DMRIDS << 24) | (targetId & 0x00FFFFFF);
+	dmrIDLookupCacheEntry_t *entry = dmrIDLookupCacheFind(key);
+	bool found;
+
+	if (entry != NULL)
+	{
+		foundRecord->id = int2bcd(targetId);
+		memcpy(foundRecord->text, entry->text, sizeof(foundRecord->text));
+		return entry->found;
+	}
+
+	found = dmrIDLookupInFlash(targetId, foundRecord);
+
+	SPI_Flash_streamClose(&dmrIDStream);// Release the Flash CS
+
+	dmrIDLookupCacheAdd(key, found, foundRecord->text);
+
+	return found;
+}
+
 bool contactIDLookup(uint32_t id, int calltype, char *buffer)
 {
 	struct_codeplugContact_t contact;
+	uint32_t key = ((DMRID_LOOKUP_SOURCE_CONTACTS + calltype) << 24) | (id & 0x00FFFFFF);
+	dmrIDLookupCacheEntry_t *entry = dmrIDLookupCacheFind(key);
+	char nameBuf[20];
+
+	if (entry != NULL)
+	{
+		if (entry->found)
+		{
+			strcpy(buffer, entry->text);
+		}
+		return entry->found;
+	}
 
+	memset(nameBuf, 0, sizeof(nameBuf));
 	int contactIndex = codeplugContactIndexByTGorPC((id & 0x00FFFFFF), calltype, &contact);
 	if (contactIndex != 0)
 	{
-		codeplugUtilConvertBufToString(contact.name, buffer, 16);
-		return true;
+		codeplugUtilConvertBufToString(contact.name, nameBuf, 16);
+		strcpy(buffer, nameBuf);
 	}
+	dmrIDLookupCacheAdd(key, (contactIndex != 0), nameBuf);
 
-	return false;
+	return (contactIndex != 0);
 }
 
 static void displayChannelNameOrRxFrequency(char *buffer, size_t maxLen)
@@ -1909,8 +2546,16 @@ void buildTgOrPCDisplayName(char *nameBuf, int bufferLen)
 	int contactIndex;
 	struct_codeplugContact_t contact;
 	uint32_t id = (trxTalkGroupOrPcId & 0x00FFFFFF);
+	int kind = (((trxTalkGroupOrPcId >> 24) == TG_CALL_FLAG) ? DISPLAY_NAME_TX_TG : DISPLAY_NAME_TX_PC);
+	const char *cachedText = displayNameCacheFind(kind, id);
 
-	if ((trxTalkGroupOrPcId >> 24) == TG_CALL_FLAG)
+	if (cachedText != NULL)
+	{
+		snprintf(nameBuf, bufferLen, "%s", cachedText);
+		return;
+	}
+
+	if (kind == DISPLAY_NAME_TX_TG)
 	{
 		contactIndex = codeplugContactIndexByTGorPC(id, CONTACT_CALLTYPE_TG, &contact);
 		if (contactIndex == 0)
@@ -1944,6 +2589,7 @@ void buildTgOrPCDisplayName(char *nameBuf, int bufferLen)
 				{
 					snprintf(nameBuf, bufferLen, "ID:%d", id);
 				}
+				return;// Not cached, the TA could arrive later
 			}
 		}
 		else
@@ -1951,6 +2597,8 @@ void buildTgOrPCDisplayName(char *nameBuf, int bufferLen)
 			codeplugUtilConvertBufToString(contact.name, nameBuf, 16);
 		}
 	}
+
+	displayNameCacheAdd(kind, id, nameBuf);
 }
 
 void acceptPrivateCall(int id)